@@ -1,12 +1,38 @@
 // Include necessary header files
 #include <GL/glut.h>          // OpenGL Utility Toolkit for window management
+#ifdef FREEGLUT
+#include <GL/freeglut_ext.h>  // glutCloseFunc
+#endif
 #include <SOIL.h>             // Simple OpenGL Image Library for texture loading
 #include <math.h>             // Math functions (sin, cos, etc.)
 #include <stdio.h>            // Standard I/O functions
 #include <stdlib.h>           // Standard library functions
 #include <string.h>           // String manipulation functions
 #include <vector>             // STL vector container
-#include <ctime>              // Time functions for random seed
+#include <ctime>              // Default star seed
+#include <chrono>             // Headless frame timing
+#include "Simulation.h"       // Fixed-timestep orbit simulation
+#include "Benchmarks.h"       // Headless command-line benchmarks
+#include "TaskScheduler.h"    // Work-stealing thread pool for per-frame work
+#include "MeshCache.h"        // Shared sphere vertex/index buffers
+#include "Starfield.h"        // GPU-animated starfield
+#include "OrbitPaths.h"       // Cached orbit path geometry
+#include "OrbitTrails.h"      // Sampled trajectories
+#include "SpatialIndex.h"     // Mouse picking and neighbour queries
+#include "RingSystem.h"       // Prebuilt planetary ring meshes
+#include "Visibility.h"       // Frustum culling and LOD selection
+#include "TextureLoader.h"    // Parallel texture decoding and startup cache
+#include "VirtualTexture.h"   // Surface maps streamed tile by tile
+#include "Headless.h"         // Offscreen context for --headless runs
+#include "Profiler.h"         // Per-phase frame timings
+#include "TextRenderer.h"     // Glyph-atlas text batching
+#include "RenderState.h"      // Redundant state elision and sorted draws
+#include "Catalog.h"          // Bodies loaded from a text or binary catalog
+#include "RockInstances.h"    // One instanced draw for every asteroid mesh
+#include "FramePacer.h"       // Frame scheduling and input latency
+#include "FrameCapture.h"     // Asynchronous recording to Y4M or image sequences
+#include "Snapshot.h"         // Saving and resuming the scene state
+#include "SessionLog.h"       // Input logs replayed in headless mode
 
 // Define GL_CLAMP_TO_EDGE if not already defined by the system
 #ifndef GL_CLAMP_TO_EDGE
@@ -14,61 +40,82 @@
 #endif
 
 // Constants for the solar system simulation
-static const double PI = 3.14159;  // Value of pi for calculations
-#define MAX_PLANETS 7              // Number of planets in our solar system
-
-// Structure to represent a star in the background
-struct Star {
-    float x, y, z;         // 3D position coordinates
-    float size;            // Visual size of the star
-    float brightness;      // Base brightness level
-    float flickerSpeed;    // Speed of brightness variation
-};
+static const double PI = 3.14159265358979323846;  // Value of pi for calculations
+#define ASTEROID_RADIUS 0.05f      // Radius of each minor body
+#define FIELD_OF_VIEW 75.0         // Vertical field of view in degrees
+#define SCENE_RADIUS 300.0         // Everything drawn (stars included) lies within this of the origin
+#define SCENE_SECONDS_PER_YEAR 8.0 // Earth's orbital period: dates count Earth orbits from 2000-01-01
+#define PICK_PIXELS 4.0            // A click selects bodies within this many pixels of the cursor
+#define NEIGHBOUR_RADIUS 1.0f      // Range of the neighbour count shown for a selected asteroid
+#define SURFACE_DECODERS 2         // Background threads reading virtual texture tiles
+#define DEFAULT_SNAPSHOT "scene.snap"  // Where S saves without --snapshot
 
 // Structure to track camera state and movement
 struct CameraState {
     float x, y, z;         // Camera position coordinates
     float tx, ty, tz;      // Camera target (look-at point)
-    int targetPlanet;       // Index of planet being viewed (-1 for none)
+    int targetBody;        // Index of body being viewed (-1 for none)
     bool isMoving;         // Flag indicating if camera is moving
 } camera = { 0, 15, 60, 0, 5, 0, -1, false }; // Initialize camera with default values
 
-// Structure to hold planet information
-struct PlanetInfo {
-    const char* name;       // Planet name
-    const char* facts[3];   // Array of 3 facts about the planet
-};
-
-// Global variables for planet animation states
-static double orbitAngles[MAX_PLANETS] = { 0 };  // Current orbit angles for planets
-static double spinAngles[MAX_PLANETS] = { 0 };   // Current rotation angles for planets
-static float saturnRingAngle = 0.0f;             // Rotation angle for Saturn's rings
+// Simulation state for planet animation (stepped independently of redraws)
+static Simulation simulation;      // Owns orbit/spin state for all planets
+static BodySnapshot bodies;        // Interpolated state read by the renderer
+static int asteroidCount = 0;      // Minor bodies in the asteroid belt (set with --belt N)
+static TaskScheduler* scheduler = 0;  // Worker pool shared by simulation and frame preparation
+static int windowWidth = 1920, windowHeight = 1080;  // Current window size from reshape()
+
+// Per-body drawing data: catalog bodies first, then the asteroid belt
+static std::vector<unsigned char> bodyKinds;  // BodyKind
+static std::vector<float> bodySizes;       // Radius of the body itself
+
+// Visibility results per body, refreshed every frame
+static std::vector<float> bodyRadii;       // Bounding radius (rings included)
+static std::vector<signed char> bodyLod;   // LOD_CULLED, a mesh level or LOD_IMPOSTOR
+static std::vector<float> bodyPixels;      // On-screen radius in pixels
+static int visibleBodies = 0;              // Bodies that survived culling this frame
+static SpatialIndex bodyIndex;             // Hierarchy over the drawn spheres, refitted every frame
+static int threadCount = 0;        // Threads for the scheduler (0 = all cores, set with --threads N)
+static bool headless = false;      // Render offscreen without a window (--headless)
+static int headlessFrames = 600;   // Frames rendered in headless mode (set with --frames N)
+static const char* capturePath = 0;  // Recording target: a .y4m file or a .png/.ppm pattern (--capture, --dump-frames)
+static bool captureOnStart = false;  // Window starts recording on its first frame (--capture)
+static bool showProfiler = false;  // Frame timing overlay (toggled with P)
+static const char* profileCsvPath = 0;    // Per-frame timings written on exit (--profile-csv)
+static const char* profileTracePath = 0;  // Chrome trace written on exit (--profile-trace)
+static bool allowInstancing = true;  // Instanced asteroid meshes when supported (off with --no-instancing)
+static bool rockInstancing = false;  // Instanced path is active
+static int instancingBenchMax = 0;   // Largest belt for --bench-instancing (0 = not requested)
+static PaceMode paceMode = PACE_VSYNC;  // How the window schedules frames (--uncapped, --vsync, --fps N)
+static double paceFps = 60.0;           // Rate for PACE_TARGET (and the fallback when vsync is unavailable)
+static double startTime = 0.0;       // Simulation time to start from (set with --date)
+static bool showDate = false;        // Date line in the overlay (on with --date or once time is warped)
+static bool showTrails = false;      // Trajectory trails (toggled with T, on with --trails)
+static int trailLength = 512;        // Samples per trail (set with --trail-length N)
+static int trailDecimation = 4;      // Fixed steps between trail samples (set with --trail-decimation N)
+static unsigned starSeed = 0;        // Background star layout (set with --seed N, otherwise the clock)
+static bool seedGiven = false;       // --seed was given, so it wins over a snapshot's seed
+static const char* snapshotPath = 0; // Where S saves, and where headless runs save at the end (--snapshot)
+static const char* sessionPath = 0;  // Session log recorded from the first frame (--record-session)
+static bool resumed = false;         // Simulation came from a snapshot or session log (--resume, --replay)
+static bool replaying = false;       // Headless run is replaying a session log
+static SessionReplay replay;         // Log being replayed
 
 // Texture handling variables
-static GLuint textures[MAX_PLANETS + 2];  // OpenGL texture IDs (planets + sun + background)
-static const char* textureFiles[MAX_PLANETS + 2] = {  // Texture filenames
-    "Sun.jpg", "Mercury.jpg", "Venus.jpg", "Earth.jpg",
-    "Mars.jpg", "Jupiter.jpg", "Saturn.jpg", "Uranus.jpg",
-    "galaxy.jpg"
-};
-
-// Solar system configuration parameters
-static const double planetDistances[] = { 6.0, 10.0, 14.0, 20.0, 30.0, 40.0, 50.0 };  // Distance from sun
-static const double planetSizes[] = { 0.3, 0.6, 0.8, 1.0, 1.8, 1.5, 1.2 };            // Relative sizes
-static const double orbitalPeriods[] = { 3.0, 6.0, 8.0, 12.0, 24.0, 30.0, 40.0 };     // Orbit speeds
-static const double rotationalPeriods[] = { 1.0, 1.5, 2.0, 2.5, 3.0, 3.5, 4.0 };      // Rotation speeds
-static const bool hasVisibleRings[MAX_PLANETS] = { false, false, false, false, false, true, false }; // Ring flags
-
-// Planet information database
-static const PlanetInfo planetInfo[MAX_PLANETS] = {
-    {"Mercury", {"- Closest to Sun", "- Extreme temperatures ", "- No atmosphere"}},
-    {"Venus", {"- Hottest planet", "- Acid clouds ", "- Retrograde rotation"}},
-    {"Earth", {"- Liquid water Lovely Earth <3 ", "- Life exists", "- 1 moon"}},
-    {"Mars", {"- Red Planet", "- Olympus Mons ", "- 2 moons"}},
-    {"Jupiter", {"- Largest planet", "- Great Red Spot ", "- 79 moons"}},
-    {"Saturn", {"- Ring system", "- Low density ", "- 62 moons"}},
-    {"Uranus", {"- Ice giant", "- Sideways rotation ", "- 27 moons"}}
-};
+static std::vector<const char*> textureFiles;  // Texture filenames, each once (background last)
+static std::vector<GLuint> textures;           // OpenGL texture IDs matching textureFiles
+static std::vector<GLuint> bodyTextures;       // Texture of each catalog body (0 = untextured)
+static const char* BACKGROUND_TEXTURE = "galaxy.jpg";
+static const char* TEXTURE_CACHE_FILE = "textures.cache";  // Decoded mip chains from the last cold start
+static bool allowVirtualTextures = true;       // Stream surfaces that have a tiled .vtex (off with --no-virtual-textures)
+static int virtualBudgetMB = 64;               // GPU memory for streamed tiles (set with --vt-budget MB)
+static bool streamingSurfaces = false;         // Virtual textures are set up
+static std::vector<int> bodySurfaces;          // Virtual texture of each catalog body (-1 = none)
+static std::vector<std::pair<const char*, int>> surfaceFiles;  // Image each open virtual texture stands in for
+
+// Bodies in the scene: stars, planets, moons and minor bodies with their facts and rings
+static BodyCatalog catalog;
+static const char* catalogPath = "solarsystem.cat";  // Text or binary catalog (set with --catalog path)
 
 // Light properties for the sun
 static const GLfloat lightAmbient[] = { 0.1f, 0.1f, 0.1f, 1.0f };   // Ambient light
@@ -77,36 +124,73 @@ static const GLfloat lightSpecular[] = { 1.0f, 1.0f, 1.0f, 1.0f };  // Specular
 
 // Container for star objects
 std::vector<Star> stars;
+static int starTotal = 500;        // Stars in the background field (set with --stars N)
+
+// Virtual texture standing in for an image: the tiled .vtex beside it, opened once however many
+// bodies share it (-1 when there is none or it can't be used)
+static int openSurface(const char* image) {
+    for (const auto& entry : surfaceFiles)
+        if (strcmp(entry.first, image) == 0) return entry.second;
+    const char* dot = strrchr(image, '.');
+    char path[512];
+    snprintf(path, sizeof(path), "%.*s.vtex", dot ? (int)(dot - image) : (int)strlen(image), image);
+    FILE* probe = fopen(path, "rb");
+    if (!probe) return -1;
+    fclose(probe);
+    if (!streamingSurfaces) {
+        streamingSurfaces = initVirtualTextures(virtualBudgetMB * 1048576LL, SURFACE_DECODERS);
+        if (!streamingSurfaces) {
+            printf("Virtual textures need GLSL; loading surfaces whole\n");
+            allowVirtualTextures = false;
+            return -1;
+        }
+    }
+    int id = openVirtualTexture(path);
+    if (id >= 0) printf("Streaming %s from %s\n", image, path);
+    surfaceFiles.push_back(std::make_pair(image, id));
+    return id;
+}
 
-// Function to load textures from image files
+// Function to load textures from image files (decoded in parallel, cached for later runs)
 void loadTextures() {
     glEnable(GL_TEXTURE_2D);  // Enable 2D texturing
-    // Load each texture file
-    for (int i = 0; i <= MAX_PLANETS + 1; ++i) {
-        // Load image file into OpenGL texture
-        textures[i] = SOIL_load_OGL_texture(
-            textureFiles[i],          // Filename
-            SOIL_LOAD_AUTO,           // Automatic format detection
-            SOIL_CREATE_NEW_ID,       // Create new texture ID
-            SOIL_FLAG_MIPMAPS | SOIL_FLAG_INVERT_Y  // Generate mipmaps and flip Y
-        );
-        // Error checking for texture loading
-        if (!textures[i]) {
-            printf("Texture load failed: %s\n", SOIL_last_result());
-            exit(EXIT_FAILURE);
-        }
-        // Set texture parameters
-        glBindTexture(GL_TEXTURE_2D, textures[i]);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR); // Minification filter
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);               // Magnification filter
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);            // S-coordinate wrapping
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);            // T-coordinate wrapping
+
+    // Each distinct file is loaded once, however many bodies share it. A surface with a tiled
+    // .vtex is streamed instead and its image never loaded.
+    std::vector<int> textureSlot(catalog.count(), -1);
+    bodySurfaces.assign(catalog.count(), -1);
+    for (int i = 0; i < catalog.count(); i++) {
+        const char* file = catalog.texture(i);
+        if (!file) continue;
+        if (allowVirtualTextures && (bodySurfaces[i] = openSurface(file)) >= 0) continue;
+        int slot = 0;
+        while (slot < (int)textureFiles.size() && strcmp(textureFiles[slot], file) != 0) slot++;
+        if (slot == (int)textureFiles.size()) textureFiles.push_back(file);
+        textureSlot[i] = slot;
+    }
+    textureFiles.push_back(BACKGROUND_TEXTURE);
+    textures.resize(textureFiles.size());
+
+    TextureLoadStats stats;
+    int failed = loadTextureSet(textureFiles.data(), (int)textureFiles.size(), textures.data(),
+                                TEXTURE_CACHE_FILE, scheduler, &stats);
+    // Error checking for texture loading
+    if (failed >= 0) {
+        printf("Texture load failed: %s: %s\n", textureFiles[failed], SOIL_last_result());
+        exit(EXIT_FAILURE);
     }
+    printf("Textures loaded %s in %.1f ms (%s %.1f ms, upload %.1f ms)\n",
+           stats.warm ? "from cache" : "cold", stats.totalMs,
+           stats.warm ? "map" : "decode", stats.decodeMs, stats.uploadMs);
+
+    bodyTextures.assign(catalog.count(), 0);
+    for (int i = 0; i < catalog.count(); i++)
+        if (textureSlot[i] >= 0) bodyTextures[i] = textures[textureSlot[i]];
 }
 
 // Initialize starfield with random stars
 void initStars(int count) {
-    std::srand(std::time(0));  // Seed random number generator with current time
+    std::srand(starSeed);      // Seed random number generator (recorded in snapshots and session logs)
     stars.resize(count);       // Resize vector to hold requested number of stars
     // Initialize each star with random properties
     for (int i = 0; i < count; ++i) {
@@ -118,6 +202,28 @@ void initStars(int count) {
         stars[i].brightness = (rand() % 50 + 50) / 100.0f;     // Random brightness between 0.5 and 1.0
         stars[i].flickerSpeed = (rand() % 50 + 50) / 1000.0f;  // Random flicker speed
     }
+
+    // Upload once; the GPU animates the stars from here on
+    initStarfield(stars);
+    std::vector<Star>().swap(stars);  // Release the CPU copy
+}
+
+// Add an asteroid belt between Mars and Jupiter as massless minor bodies
+void initAsteroidBelt(int count) {
+    std::srand(12345);  // Fixed seed so every run gets the same belt
+    for (int i = 0; i < count; ++i) {
+        double r = 22.0 + 6.0 * (rand() / (double)RAND_MAX);          // Radius between 22 and 28
+        double phase = 2 * PI * (rand() / (double)RAND_MAX);          // Random starting angle
+        double spin = 0.5 + 2.0 * (rand() / (double)RAND_MAX);        // Tumbling period
+        simulation.addBody(r, simulation.keplerPeriod(r), spin, phase);
+    }
+}
+
+// Keplerian elements of catalog body i
+static OrbitalElements catalogOrbit(int i) {
+    OrbitalElements orbit = { catalog.distance[i], catalog.eccentricity[i], catalog.inclination[i],
+                              catalog.ascendingNode[i], catalog.periapsis[i] };
+    return orbit;
 }
 
 // Initialize OpenGL settings
@@ -140,63 +246,345 @@ void initGL() {
     glEnable(GL_COLOR_MATERIAL);
     glColorMaterial(GL_FRONT, GL_AMBIENT_AND_DIFFUSE);
 
-    loadTextures();    // Load all planet and background textures
-    initStars(500);    // Initialize starfield with 500 stars
+    // Register every catalog body with the simulation (same indices), then the belt.
+    // A star at the origin is the simulation's analytic central mass, so it adds no mass of its own.
+    // A resumed simulation already holds every body.
+    if (!resumed) {
+        for (int i = 0; i < catalog.count(); i++) {
+            bool centralStar = catalog.kind[i] == BODY_STAR && catalog.parent[i] < 0 && catalog.distance[i] == 0.0;
+            simulation.addBody(catalog.distance[i], catalog.orbitalPeriod[i], catalog.rotationalPeriod[i],
+                catalog.phase[i], centralStar ? 0.0 : catalog.mass[i] * simulation.centralMass, catalog.parent[i]);
+            simulation.setOrbit(i, catalogOrbit(i));
+        }
+        initAsteroidBelt(asteroidCount);
+        if (startTime != 0.0) simulation.seek(startTime);  // Same cost for any date
+    }
+    simulation.interpolate(1.0, bodies);
+
+    // Bounding radii for culling; ringed bodies include their ring extent
+    bodyKinds.assign(simulation.bodyCount(), BODY_MINOR);
+    bodySizes.assign(simulation.bodyCount(), ASTEROID_RADIUS);
+    bodyRadii.assign(simulation.bodyCount(), ASTEROID_RADIUS);
+    for (int i = 0; i < catalog.count(); i++) {
+        float extent = 1.0f;
+        for (int b = 0; b < catalog.bandCount[i]; b++)
+            extent = fmax(extent, catalog.bands[catalog.firstBand[i] + b].outer);
+        bodyKinds[i] = catalog.kind[i];
+        bodySizes[i] = catalog.size[i];
+        bodyRadii[i] = catalog.size[i] * extent;
+    }
+    bodyLod.resize(simulation.bodyCount());
+    bodyPixels.resize(simulation.bodyCount());
+
+    if (!headless) loadGLExtensions();  // Resolve buffer object entry points (headless contexts already did)
+    initProfiler();      // GPU timer queries when available
+    // Glyph atlas comes from the GLUT font, which needs glutInit()
+    if (!headless || headlessHasGlut()) initText();
+    else printf("Headless: no X display for the GLUT font, so frames have no overlay text\n");
+    loadTextures();    // Load every catalog texture and the background
+    initStars(starTotal);  // Initialize starfield (500 stars unless --stars is given)
+    rockInstancing = allowInstancing && initRockInstances();  // Otherwise asteroids are drawn one by one
+
+    // Orbit paths are built once; only setOrbitPath() changes them
+    // (minor bodies are too numerous to trace)
+    initOrbitPaths();
+    for (int i = 0; i < catalog.count(); i++) {
+        if (catalog.kind[i] == BODY_MINOR || catalog.distance[i] <= 0.0) continue;
+        setOrbitPath(i, catalogOrbit(i));
+    }
+
+    // Trails follow the same bodies as the orbit paths, showing where they have really been
+    std::vector<int> trailed;
+    for (int i = 0; i < catalog.count(); i++) {
+        if (catalog.kind[i] != BODY_MINOR && catalog.distance[i] > 0.0) trailed.push_back(i);
+    }
+    initOrbitTrails(trailed.data(), (int)trailed.size(), trailLength, trailDecimation);
+
+    // Ring meshes and profiles are built once for every body that shows rings
+    for (int i = 0; i < catalog.count(); i++) {
+        if (catalog.bandCount[i] > 0)
+            setRingSystem(i, catalog.ringTilt[i], &catalog.bands[catalog.firstBand[i]], catalog.bandCount[i]);
+    }
+}
+
+// Print how the capture pipeline kept up
+void printCaptureSummary() {
+    CaptureStats stats;
+    getCaptureStats(stats);
+    printf("Captured %d frames (%d written): %.2f ms/frame on the render thread, %.2f ms/frame encoding, "
+           "%d waits for the encoder\n", stats.frames, stats.written, stats.readMs, stats.encodeMs, stats.stalls);
+}
+
+// Start recording the window to --capture (or capture.y4m)
+void startRecording() {
+    double fps = getPaceMode() == PACE_TARGET ? getTargetFps() : 60.0;
+    startCapture(capturePath ? capturePath : "capture.y4m", windowWidth, windowHeight, (int)(fps + 0.5));
+}
+
+// Finish the frames in flight and report (also run at exit, as GLUT never returns)
+void stopRecording() {
+    if (!isCapturing()) return;
+    stopCapture();
+    printCaptureSummary();
+}
+
+// Everything besides the simulation that snapshots and session logs carry
+static SceneState currentScene() {
+    SceneState scene = { starSeed, { camera.x, camera.y, camera.z, camera.tx, camera.ty, camera.tz },
+                         camera.targetBody, camera.isMoving, showTrails, showDate };
+    return scene;
+}
+
+static void applyScene(const SceneState& scene) {
+    if (!seedGiven) starSeed = scene.starSeed;
+    camera.x = scene.camera[0];
+    camera.y = scene.camera[1];
+    camera.z = scene.camera[2];
+    camera.tx = scene.camera[3];
+    camera.ty = scene.camera[4];
+    camera.tz = scene.camera[5];
+    camera.targetBody = scene.targetBody;
+    camera.isMoving = scene.cameraMoving != 0;
+    showTrails = scene.showTrails != 0;
+    showDate = scene.showDate != 0;
+}
+
+// Save the scene to --snapshot (or scene.snap); only packing happens on this thread
+void saveSnapshot() {
+    const char* path = snapshotPath ? snapshotPath : DEFAULT_SNAPSHOT;
+    auto start = std::chrono::steady_clock::now();
+    size_t bytes = saveSnapshotAsync(path, simulation, currentScene());
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    printf("Saving %s: %.1f MB packed in %.2f ms\n", path, bytes / 1048576.0, ms);
+}
+
+// Replace the simulation with a snapshot (--resume) or a session log's starting state (--replay)
+bool resumeScene(const char* resumePath, const char* replayPath) {
+    const char* path = replayPath ? replayPath : resumePath;
+    char error[256];
+    SceneState scene;
+    auto start = std::chrono::steady_clock::now();
+    bool ok = replayPath ? openSessionReplay(replayPath, replay, simulation, scene, error, sizeof(error))
+                         : loadSnapshot(resumePath, simulation, scene, error, sizeof(error));
+    if (!ok) {
+        printf("Could not resume from %s: %s\n", path, error);
+        return false;
+    }
+    // Bodies are matched to the catalog by index, so the catalog's must come first and unchanged
+    bool matches = simulation.bodyCount() >= catalog.count();
+    for (int i = 0; matches && i < catalog.count(); i++) matches = simulation.parent[i] == catalog.parent[i];
+    if (!matches) {
+        printf("%s was saved from a different catalog than %s\n", path, catalogPath);
+        if (replayPath) closeSessionReplay(replay);
+        return false;
+    }
+    applyScene(scene);
+    resumed = true;
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    printf("Resumed %d bodies at t = %.2f s from %s in %.2f ms\n", simulation.bodyCount(), simulation.time(), path, ms);
+    return true;
+}
+
+// Close the session log with the final state (run at exit, as GLUT never returns)
+void finishSession() {
+    stopSessionRecording(simulation);
 }
 
 // Window resize handler
 void reshape(int w, int h) {
     if (h == 0) h = 1;  // Prevent divide by zero when calculating aspect ratio
+    recordSessionEvent(SESSION_RESIZE, w, h);
+    if (isCapturing() && (w != windowWidth || h != windowHeight)) {
+        stopRecording();  // Every frame of a recording has the same size
+        printf("Recording stopped: the window was resized\n");
+    }
+    windowWidth = w;
+    windowHeight = h;
     glViewport(0, 0, w, h);  // Set viewport to cover entire window
-    glMatrixMode(GL_PROJECTION);  // Switch to projection matrix mode
-    glLoadIdentity();             // Reset projection matrix
-    // Set up perspective projection with 75 degree FOV
-    gluPerspective(75.0, (float)w / h, 0.1, 200.0);
-    glMatrixMode(GL_MODELVIEW);  // Switch back to modelview matrix mode
+    // Projection is rebuilt every frame in display() so the far plane follows the camera
 }
 
-// Function to draw text on screen
-void drawText(float x, float y, const char* text) {
-    // Switch to orthographic projection for 2D text rendering
-    glMatrixMode(GL_PROJECTION);
-    glPushMatrix();
-    glLoadIdentity();
-    gluOrtho2D(0, glutGet(GLUT_WINDOW_WIDTH), 0, glutGet(GLUT_WINDOW_HEIGHT));
+// Draw rolling frame timings (mean / p50 / p99 in ms) for every phase in the top-right corner
+void drawProfilerHud() {
+    const float lineHeight = 20.0f;
+    const float startX = windowWidth - 520.0f;
+    float textY = windowHeight - 30.0f;
+    char text[96];
+
+    addText(startX, textY, "phase");
+    addText(startX + 150, textY, "cpu mean / p50 / p99");
+    addText(startX + 340, textY, hasGpuTimings() ? "gpu mean / p50 / p99" : "gpu n/a");
+    for (int p = 0; p < PHASE_COUNT; p++) {
+        PhaseStats cpu, gpu;
+        getPhaseStats((ProfilePhase)p, cpu, gpu);
+        textY -= lineHeight;
+        addText(startX, textY, phaseName((ProfilePhase)p));
+        snprintf(text, sizeof(text), "%.2f / %.2f / %.2f", cpu.mean, cpu.p50, cpu.p99);
+        addText(startX + 150, textY, text);
+        if (gpu.count > 0) {
+            snprintf(text, sizeof(text), "%.2f / %.2f / %.2f", gpu.mean, gpu.p50, gpu.p99);
+            addText(startX + 340, textY, text);
+        }
+    }
+    RenderStateStats state = getRenderStateStats();
+    snprintf(text, sizeof(text), "state changes: %d issued, %d elided", state.issued, state.elided);
+    textY -= lineHeight;
+    addText(startX, textY, text);
+    snprintf(text, sizeof(text), "text layouts cached: %d", cachedTextLayouts());
+    textY -= lineHeight;
+    addText(startX, textY, text);
+
+    // Frame pacing: rate, frame-to-frame time and input-to-photon latency (V cycles the mode)
+    PacingStats pacing;
+    getPacingStats(pacing);
+    if (getPaceMode() == PACE_TARGET)
+        snprintf(text, sizeof(text), "pacing: %s %.0f fps (V)   %.1f fps", paceModeName(getPaceMode()),
+                 getTargetFps(), pacing.fps);
+    else
+        snprintf(text, sizeof(text), "pacing: %s (V)   %.1f fps", paceModeName(getPaceMode()), pacing.fps);
+    textY -= lineHeight;
+    addText(startX, textY, text);
+    snprintf(text, sizeof(text), "frame %.2f / %.2f / %.2f", pacing.frame.mean, pacing.frame.p50, pacing.frame.p99);
+    textY -= lineHeight;
+    addText(startX, textY, text);
+    if (pacing.latency.count > 0) {
+        snprintf(text, sizeof(text), "input to photon %.1f mean / %.1f p99 (%d inputs)",
+                 pacing.latency.mean, pacing.latency.p99, pacing.latency.count);
+        textY -= lineHeight;
+        addText(startX, textY, text);
+    }
+    if (showTrails) {
+        TrailStats trails;
+        getOrbitTrailStats(trails);
+        snprintf(text, sizeof(text), "trails (T): %d x %d samples, %.1f KB buffer, %d bytes uploaded",
+                 trails.bodies, trails.samples, trails.bufferBytes / 1024.0, trails.uploadBytes);
+        textY -= lineHeight;
+        addText(startX, textY, text);
+    }
+    if (streamingSurfaces) {
+        VirtualTextureStats surfaces;
+        getVirtualTextureStats(surfaces);
+        snprintf(text, sizeof(text), "virtual textures: %d/%d tiles, %d/%d view hits, %d queued, %d uploaded",
+                 surfaces.resident, surfaces.slots, surfaces.hits, surfaces.wanted, surfaces.queued, surfaces.uploads);
+        textY -= lineHeight;
+        addText(startX, textY, text);
+    }
+    if (isCapturing()) {
+        CaptureStats capture;
+        getCaptureStats(capture);
+        snprintf(text, sizeof(text), "recording (R): %d frames, %.2f ms read, %.2f ms encode, %d waits",
+                 capture.frames, capture.readMs, capture.encodeMs, capture.stalls);
+        textY -= lineHeight;
+        addText(startX, textY, text);
+    }
+}
 
-    glMatrixMode(GL_MODELVIEW);
-    glPushMatrix();
-    glLoadIdentity();
+// Print the same statistics as the overlay (used after headless runs)
+void printProfileSummary() {
+    printf("%-14s %28s %28s\n", "phase", "cpu ms mean / p50 / p99", "gpu ms mean / p50 / p99");
+    for (int p = 0; p < PHASE_COUNT; p++) {
+        PhaseStats cpu, gpu;
+        getPhaseStats((ProfilePhase)p, cpu, gpu);
+        printf("%-14s %8.3f / %7.3f / %7.3f", phaseName((ProfilePhase)p), cpu.mean, cpu.p50, cpu.p99);
+        if (gpu.count > 0) printf(" %8.3f / %7.3f / %7.3f", gpu.mean, gpu.p50, gpu.p99);
+        printf("\n");
+    }
+    RenderStateStats state = getRenderStateStats();
+    printf("state changes per frame: %d issued, %d elided\n", state.issued, state.elided);
+    if (streamingSurfaces) {
+        VirtualTextureStats surfaces;
+        getVirtualTextureStats(surfaces);
+        long long wanted = surfaces.totalHits + surfaces.totalMisses;
+        printf("virtual textures: %d of %d tiles resident (%.0f MB atlas), %.1f%% of wanted tiles resident, %.1f MB read\n",
+               surfaces.resident, surfaces.slots, surfaces.atlasBytes / 1048576.0,
+               wanted ? 100.0 * surfaces.totalHits / wanted : 100.0, surfaces.bytesRead / 1048576.0);
+    }
+}
 
-    glDisable(GL_LIGHTING);  // Disable lighting for text
-    glColor3f(1, 1, 1);     // Set text color to white
-    glRasterPos2f(x, y);     // Position text
+// Export recorded frame timings to the files given on the command line
+void writeProfiles() {
+    if (profileCsvPath && !writeProfileCSV(profileCsvPath))
+        printf("Could not write %s\n", profileCsvPath);
+    if (profileTracePath && !writeProfileTrace(profileTracePath))
+        printf("Could not write %s\n", profileTracePath);
+}
 
-    // Draw each character of the string
-    for (const char* c = text; *c; c++)
-        glutBitmapCharacter(GLUT_BITMAP_HELVETICA_18, *c);
+// Days from 2000-01-01 to a calendar date (proleptic Gregorian)
+static long daysFromCivil(int year, int month, int day) {
+    year -= month <= 2;
+    const long era = (year >= 0 ? year : year - 399) / 400;
+    const long yoe = year - era * 400;
+    const long doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    const long doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 730425;  // 730425 = days from 0000-03-01 to 2000-01-01
+}
 
-    glEnable(GL_LIGHTING);  // Re-enable lighting
-    glPopMatrix();
-    glMatrixMode(GL_PROJECTION);
-    glPopMatrix();
-    glMatrixMode(GL_MODELVIEW);
+// Calendar date of a day count from 2000-01-01 (inverse of daysFromCivil)
+static void civilFromDays(long days, int& year, int& month, int& day) {
+    days += 730425;
+    const long era = (days >= 0 ? days : days - 146096) / 146097;
+    const long doe = days - era * 146097;
+    const long yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const long doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const long mp = (5 * doy + 2) / 153;
+    day = (int)(doy - (153 * mp + 2) / 5 + 1);
+    month = (int)(mp < 10 ? mp + 3 : mp - 9);
+    year = (int)(yoe + era * 400 + (month <= 2));
+}
+
+// Draw the time warp factor and the date the scene shows in the bottom-left corner
+void drawDateLine() {
+    int year, month, day;
+    civilFromDays((long)floor(bodies.time / SCENE_SECONDS_PER_YEAR * 365.25), year, month, day);
+    char text[96];
+    snprintf(text, sizeof(text), "%04d-%02d-%02d   time warp %gx   (+/- to change)",
+             year, month, day, simulation.timeWarp);
+    addText(20.0f, 20.0f, text);
 }
 
-// Draw information box for selected planet
-void drawInfoBox(int planetIndex) {
-    if (planetIndex < 0 || planetIndex >= MAX_PLANETS) return;  // Validate planet index
+// Name of any body: catalog bodies by name, belt asteroids by number
+static const char* bodyName(int body, char* buffer, size_t size) {
+    if (body < catalog.count()) return catalog.name(body);
+    snprintf(buffer, size, "Asteroid %d", body - catalog.count() + 1);
+    return buffer;
+}
 
-    const PlanetInfo& info = planetInfo[planetIndex];  // Get planet info
-    const int lineCount = 4;  // Name + 3 facts
+// Draw information box for selected body
+void drawInfoBox(int body) {
+    if (body < 0 || body >= (int)bodies.x.size()) return;  // Validate body index
+
+    // Catalog bodies list their facts (filled in order, so stop at the first missing one);
+    // belt asteroids show what is around them instead
+    const char* lines[3 + CATALOG_FACTS];
+    char name[32], nearestName[32], nearestLine[96], countLine[64];
+    int lineCount = 0;
+    lines[lineCount++] = bodyName(body, name, sizeof(name));
+    if (body < catalog.count()) {
+        for (int i = 0; i < CATALOG_FACTS && catalog.fact(body, i); i++) lines[lineCount++] = catalog.fact(body, i);
+    }
+    else {
+        int nearest[2];
+        float distance[2];
+        int found = bodyIndex.nearest(bodies.x[body], bodies.y[body], bodies.z[body], 2, nearest, distance);
+        if (found == 2) {
+            int other = nearest[0] == body ? 1 : 0;  // The body itself is at distance 0
+            snprintf(nearestLine, sizeof(nearestLine), "Nearest: %s, %.2f units",
+                     bodyName(nearest[other], nearestName, sizeof(nearestName)), distance[other]);
+            lines[lineCount++] = nearestLine;
+        }
+        static std::vector<int> neighbours;
+        neighbours.clear();
+        bodyIndex.withinRadius(bodies.x[body], bodies.y[body], bodies.z[body], NEIGHBOUR_RADIUS, neighbours);
+        snprintf(countLine, sizeof(countLine), "%d others within %.0f unit", (int)neighbours.size() - 1,
+                 NEIGHBOUR_RADIUS);
+        lines[lineCount++] = countLine;
+    }
     const float lineHeight = 20.0f;
     const float padding = 15.0f;
 
-    // Get current window dimensions
-    int windowWidth = glutGet(GLUT_WINDOW_WIDTH);
-    int windowHeight = glutGet(GLUT_WINDOW_HEIGHT);
-
     // Calculate box dimensions and position
-    float boxWidth = 250.0f;
+    float boxWidth = 250.0f;  // Wider when a line needs it
+    for (int i = 0; i < lineCount; i++) boxWidth = fmax(boxWidth, textWidth(lines[i]) + 2 * padding);
     float boxHeight = lineCount * lineHeight + padding * 2;
     float startX = 20.0f;
     float startY = windowHeight - 50.0f;
@@ -220,40 +608,43 @@ void drawInfoBox(int planetIndex) {
     glVertex2f(startX, startY - boxHeight);
     glEnd();
 
-    // Draw planet name and facts
+    // Draw body name and facts
     float textY = startY - padding;
-    drawText(startX + padding, textY, info.name);  // Planet name
-    textY -= lineHeight;
-    for (int i = 0; i < 3; i++) {
-        drawText(startX + padding, textY, info.facts[i]);  // Each fact
+    for (int i = 0; i < lineCount; i++) {
+        addText(startX + padding, textY, lines[i]);  // Name, then each fact
         textY -= lineHeight;
     }
 
     // Draw help text at bottom
-    drawText(startX + padding, textY - 10, "Press Q to return");
+    addText(startX + padding, textY - 10, "Press Q to return");
 }
 
 // Update camera position based on current target
 void updateCamera() {
-    if (camera.targetPlanet != -1) {
-        // Camera is focused on a specific planet
-        int idx = camera.targetPlanet;
-        double angle = orbitAngles[idx];
-        double distance = planetDistances[idx];
-        // Calculate planet position in orbit
-        double px = -distance * sin(angle);
-        double pz = distance * cos(angle);
-
-        // Set camera position behind and above the planet
+    if (camera.targetBody != -1) {
+        // Camera is focused on a specific body
+        int idx = camera.targetBody;
+        // Body position from the interpolated simulation snapshot
+        double px = bodies.x[idx];
+        double py = bodies.y[idx];
+        double pz = bodies.z[idx];
+        double distance = sqrt(px * px + pz * pz);
+        double dirX = 0.0, dirZ = 1.0;  // A body at the origin is viewed from the side
+        if (distance > 1e-6) {
+            dirX = px / distance;
+            dirZ = pz / distance;
+        }
+
+        // Set camera position behind and above the body (trailing along its orbit)
         float followDistance = 15.0f;
         float followHeight = 8.0f;
-        camera.x = px - followDistance * cos(angle);
-        camera.y = followHeight;
-        camera.z = pz - followDistance * sin(angle);
+        camera.x = px - followDistance * dirZ;
+        camera.y = py + followHeight;
+        camera.z = pz + followDistance * dirX;
 
-        // Set look-at target to planet
+        // Set look-at target to body
         camera.tx = px;
-        camera.ty = 0;
+        camera.ty = py;
         camera.tz = pz;
     }
     else if (camera.isMoving) {
@@ -272,17 +663,58 @@ void updateCamera() {
     }
 }
 
-// Keyboard input handler
-void keyboard(unsigned char key, int x, int y) {
-    int planetIndex = key - '1';  // Convert key to planet index (1-7)
-    if (planetIndex >= 0 && planetIndex < MAX_PLANETS) {
+// Catalog index of the nth planet in catalog order (-1 when there are fewer)
+static int nthPlanet(int n) {
+    for (int i = 0; i < catalog.count(); i++)
+        if (catalog.kind[i] == BODY_PLANET && n-- == 0) return i;
+    return -1;
+}
+
+// Next (or previous) selectable body after the current target; minor bodies are skipped
+static int cycleBody(int from, int direction) {
+    const int count = catalog.count();
+    int idx = from;
+    for (int step = 0; step < count; step++) {
+        idx = (from < 0 && step == 0) ? (direction > 0 ? 0 : count - 1) : (idx + direction + count) % count;
+        if (catalog.kind[idx] != BODY_MINOR) return idx;
+    }
+    return from;
+}
+
+// Keys that change what is simulated or shown; session logs record and replay these
+void sceneKey(unsigned char key) {
+    int planet = (key >= '1' && key <= '9') ? nthPlanet(key - '1') : -1;  // Keys 1-9 pick planets in order
+    if (planet >= 0) {
         // Focus camera on selected planet
-        camera.targetPlanet = planetIndex;
+        camera.targetBody = planet;
+        camera.isMoving = false;
+    }
+    else if (key == '[' || key == ']') {
+        // Step through every star, planet and moon in the catalog
+        camera.targetBody = cycleBody(camera.targetBody, key == ']' ? 1 : -1);
         camera.isMoving = false;
     }
+    else if (key == 'p' || key == 'P') {
+        // Toggle the frame timing overlay
+        showProfiler = !showProfiler;
+    }
+    else if (key == 'g' || key == 'G') {
+        // Toggle between analytic orbits and N-body gravity
+        simulation.setMode(simulation.getMode() == SIM_NBODY ? SIM_ORBITS : SIM_NBODY);
+    }
+    else if (key == '+' || key == '=' || key == '-') {
+        // Speed time up or slow it down tenfold (orbits are evaluated at any time, so no step limit)
+        double warp = simulation.timeWarp * (key == '-' ? 0.1 : 10.0);
+        simulation.timeWarp = fmax(1.0, fmin(warp, SIM_MAX_TIME_WARP));
+        showDate = true;
+    }
+    else if (key == 't' || key == 'T') {
+        // Show or hide trajectory trails (they keep recording while hidden)
+        showTrails = !showTrails;
+    }
     else if (key == '0' || key == 'q' || key == 'Q') {
         // Return to default view
-        camera.targetPlanet = -1;
+        camera.targetBody = -1;
         camera.tx = 0;
         camera.ty = 5;
         camera.tz = 0;
@@ -293,6 +725,31 @@ void keyboard(unsigned char key, int x, int y) {
     }
 }
 
+// Keyboard input handler
+void keyboard(unsigned char key, int x, int y) {
+    notePacedInput();
+    // Pacing, recording and snapshots don't change the scene, so they stay out of session logs
+    if (key == 'v' || key == 'V') {
+        // Cycle frame pacing: vsync, a fixed target rate, uncapped
+        PaceMode next = getPaceMode() == PACE_VSYNC ? PACE_TARGET :
+                        getPaceMode() == PACE_TARGET ? PACE_UNCAPPED : PACE_VSYNC;
+        setPaceMode(next, paceFps);
+    }
+    else if (key == 'r' || key == 'R') {
+        // Start or stop recording the window
+        if (isCapturing()) stopRecording();
+        else startRecording();
+    }
+    else if (key == 's' || key == 'S') {
+        // Save the scene in the background
+        saveSnapshot();
+    }
+    else {
+        recordSessionEvent(SESSION_KEY, key);
+        sceneKey(key);
+    }
+}
+
 // Draw background (galaxy texture)
 void drawBackground() {
     // Switch to orthographic projection for background
@@ -306,10 +763,11 @@ void drawBackground() {
     glLoadIdentity();
 
     // Disable lighting and depth test for background
-    glDisable(GL_LIGHTING);
-    glDisable(GL_DEPTH_TEST);
-    glEnable(GL_TEXTURE_2D);
-    glBindTexture(GL_TEXTURE_2D, textures[MAX_PLANETS + 1]);  // Galaxy texture
+    setCapability(GL_LIGHTING, false);
+    setCapability(GL_DEPTH_TEST, false);
+    setCapability(GL_TEXTURE_2D, true);
+    bindTexture(GL_TEXTURE_2D, textures.back());  // Galaxy texture
+    setColor(1.0f, 1.0f, 1.0f);
 
     // Draw fullscreen quad with texture
     glBegin(GL_QUADS);
@@ -320,9 +778,7 @@ void drawBackground() {
     glEnd();
 
     // Restore OpenGL state
-    glDisable(GL_TEXTURE_2D);
-    glEnable(GL_DEPTH_TEST);
-    glEnable(GL_LIGHTING);
+    setDefaultRenderState();
 
     glPopMatrix();
     glMatrixMode(GL_PROJECTION);
@@ -330,165 +786,208 @@ void drawBackground() {
     glMatrixMode(GL_MODELVIEW);
 }
 
-// Draw starfield
-void drawStars() {
-    static float time = 0.0f;  // Animation timer
-    time += 0.01f;             // Increment timer
-
-    // Save current OpenGL state
-    glPushAttrib(GL_ENABLE_BIT | GL_CURRENT_BIT);
-    glDisable(GL_LIGHTING);     // Stars emit their own light
-
-    // Draw each star with flickering effect
-    for (const auto& star : stars) {
-        float flicker = 0.5f + 0.5f * sin(time * star.flickerSpeed);
-        glColor3f(1.0f, 1.0f, 1.0f);  // White stars
-        glPointSize(star.size * (1.0f + flicker * 0.5f));  // Size varies with flicker
-
-        glBegin(GL_POINTS);
-        glVertex3f(star.x, star.y, star.z);
-        glEnd();
-    }
+// Lit surface shared by planets, the Sun and rocky minor bodies. GL_COLOR_MATERIAL is on,
+// so ambient and diffuse come from the current color (glMaterial can't set them).
+static const GLfloat planetSurface[] = { 0.8f, 0.8f, 0.8f, 1.0f };
+static const GLfloat rockSurface[] = { 0.7f, 0.65f, 0.6f, 1.0f };  // Dusty grey-brown rocks
+static void setSurfaceMaterial(const GLfloat* ambientDiffuse, bool emissive) {
+    static const GLfloat matSpec[] = { 0.1f, 0.1f, 0.1f, 1.0f };
+    static const GLfloat shininess = 10.0f;
+    static const GLfloat emit[] = { 1.0f, 1.0f, 0.9f, 1.0f };  // Makes the Sun glow
+    static const GLfloat black[] = { 0.0f, 0.0f, 0.0f, 1.0f };
+    setColor(ambientDiffuse[0], ambientDiffuse[1], ambientDiffuse[2], ambientDiffuse[3]);
+    setMaterial(GL_SPECULAR, matSpec);
+    setMaterial(GL_SHININESS, &shininess);
+    setMaterial(GL_EMISSION, emissive ? emit : black);
+}
 
-    // Draw some brighter stars
-    glPointSize(3.0f);
-    glColor3f(1.0f, 1.0f, 1.0f);
+// Draw a body too small to resolve as a single screen-sized point (command callback)
+void drawImpostor(int idx) {
+    setCapability(GL_LIGHTING, false);
+    setCapability(GL_TEXTURE_2D, false);
+    setColor(0.8f, 0.8f, 0.8f);  // Neutral grey dot
+    setPointSize(fmax(1.0f, 2.0f * bodyPixels[idx]));
     glBegin(GL_POINTS);
-    for (int i = 0; i < 20; i++) {
-        glVertex3f(stars[i].x * 1.5f, stars[i].y * 1.5f, stars[i].z * 1.5f);
-    }
+    glVertex3f(bodies.x[idx], bodies.y[idx], bodies.z[idx]);
     glEnd();
-
-    // Restore OpenGL state
-    glPopAttrib();
 }
 
-// Draw a planet's orbit ring
-void drawOrbitRing(double radius) {
-    // Save current OpenGL state
-    glPushAttrib(GL_ENABLE_BIT | GL_CURRENT_BIT);
-    glDisable(GL_LIGHTING);      // Orbits don't need lighting
-    glColor3f(1.0f, 1.0f, 1.0f);  // White orbit rings
-    glLineWidth(1.5f);           // Set line width
-    glEnable(GL_LINE_SMOOTH);    // Anti-aliased lines
-
-    // Draw circular orbit path
-    glBegin(GL_LINE_LOOP);
-    for (int i = 0; i < 360; ++i) {
-        double angle = 2 * PI * i / 360;
-        glVertex3d(radius * cos(angle), 0.0, radius * sin(angle));
+// Draw every point-sized asteroid in one batch (command callback)
+void drawAsteroidPoints(int) {
+    setCapability(GL_LIGHTING, false);  // Points are too small to need lighting
+    setCapability(GL_TEXTURE_2D, false);
+    setColor(rockSurface[0], rockSurface[1], rockSurface[2]);
+    setPointSize(1.5f);
+    glBegin(GL_POINTS);
+    for (int i = 0; i < (int)bodies.x.size(); ++i) {
+        if (bodyKinds[i] == BODY_MINOR && bodyLod[i] == LOD_IMPOSTOR)
+            glVertex3f(bodies.x[i], bodies.y[i], bodies.z[i]);
     }
     glEnd();
-
-    // Restore OpenGL state
-    glPopAttrib();
 }
 
-// Draw Saturn's rings
-void drawSaturnRings(double size) {
+// Draw one asteroid close enough to be a sphere (command callback)
+void drawAsteroid(int idx) {
+    setCapability(GL_TEXTURE_2D, false);
+    setSurfaceMaterial(rockSurface, false);
     glPushMatrix();
-    // Tilt rings for more realistic appearance
-    glRotatef(25.0f, 1.0f, 0.0f, 0.0f);
-    glRotatef(saturnRingAngle, 0.0f, 0.0f, 1.0f);  // Rotate rings over time
-
-    // Multiple layers for rings with different properties
-    const int layers = 5;
-    const float colors[][3] = {
-        {0.9f, 0.85f, 0.7f}, {0.8f, 0.75f, 0.6f},
-        {0.7f, 0.6f, 0.5f}, {0.6f, 0.55f, 0.5f},
-        {0.5f, 0.45f, 0.4f}
-    };
-
-    // Draw each ring layer
-    for (int i = 0; i < layers; ++i) {
-        glPushMatrix();
-        glColor3fv(colors[i]);  // Set ring color
-        // Draw torus (donut shape) for ring
-        glutSolidTorus(size * 0.02 * (i + 1), size * (2.5 + i * 0.4), 64, 128);
-        glPopMatrix();
-    }
-
+    glTranslatef(bodies.x[idx], bodies.y[idx], bodies.z[idx]);
+    drawSphereMesh(getSphereMesh(lodSegments[bodyLod[idx]]), bodySizes[idx]);
     glPopMatrix();
-    saturnRingAngle = fmod(saturnRingAngle + 0.3f, 360.0f);  // Update rotation angle
 }
 
-// Draw a textured sphere (planet or sun)
-void drawTexturedSphere(GLuint tex, double rad, bool isSun = false) {
-    glEnable(GL_TEXTURE_2D);  // Enable texturing
-    glBindTexture(GL_TEXTURE_2D, tex);  // Bind specified texture
-    GLUquadric* quad = gluNewQuadric();  // Create quadric object
-    gluQuadricTexture(quad, GL_TRUE);    // Enable texture coordinates
-    gluQuadricNormals(quad, GLU_SMOOTH); // Generate smooth normals
+// Draw every queued asteroid mesh with one instanced call (command callback)
+void drawAsteroidInstances(int) {
+    setCapability(GL_TEXTURE_2D, false);
+    setColor(rockSurface[0], rockSurface[1], rockSurface[2]);  // Tinted per rock in the shader
+    drawRockInstances();
+}
+
+// Record the minor bodies: one command for all points, and one for all meshes
+// (or one per mesh when instancing is unavailable)
+void submitMinorBodies() {
+    int count = (int)bodies.x.size();
+    bool anyPoints = false;
+    for (int i = 0; i < count; ++i) {
+        if (bodyKinds[i] != BODY_MINOR || bodyLod[i] == LOD_CULLED) continue;
+        if (bodyLod[i] == LOD_IMPOSTOR) anyPoints = true;
+        else if (rockInstancing) addRockInstance(bodies.x[i], bodies.y[i], bodies.z[i], bodySizes[i], bodies.spin[i], i);
+        else submitDraw(opaqueDrawKey(0, MATERIAL_ROCK), drawAsteroid, i);
+    }
+    if (anyPoints) submitDraw(opaqueDrawKey(0, MATERIAL_NONE), drawAsteroidPoints, 0);
+    if (queuedRockInstances() > 0) submitDraw(opaqueDrawKey(0, MATERIAL_ROCK), drawAsteroidInstances, 0);
+}
+
+// Function to draw a textured sphere (used for planets, moons and stars; tex 0 draws it plain,
+// a surface of 0 or more samples that virtual texture instead)
+void drawTexturedSphere(GLuint tex, double rad, bool isSun = false, int segments = lodSegments[0], int surface = -1) {
+    setCapability(GL_LIGHTING, true);
+    setCapability(GL_TEXTURE_2D, tex != 0);  // Enable texturing
+    if (tex) bindTexture(GL_TEXTURE_2D, tex);  // Bind specified texture
+    setSurfaceMaterial(planetSurface, isSun);  // Sun emits light
 
-    // Special handling for sun (emits light)
     if (isSun) {
         glPushMatrix();
         glRotatef(90.0f, 1.0f, 0.0f, 0.0f);  // Rotate for correct texture mapping
-        GLfloat emit[] = { 1.0f, 1.0f, 0.9f, 1.0f };
-        glMaterialfv(GL_FRONT, GL_EMISSION, emit);  // Make sun glow
     }
 
-    // Draw the sphere with texture
-    gluSphere(quad, rad, 40, 40);
+    // Draw the shared sphere mesh with texture (built once, one indexed draw)
+    if (surface >= 0) beginVirtualTexture(surface);
+    drawSphereMesh(getSphereMesh(segments), rad);
+    if (surface >= 0) endVirtualTexture();
 
-    // Reset emission if this was the sun
-    if (isSun) {
-        GLfloat black[] = { 0.0f, 0.0f, 0.0f, 1.0f };
-        glMaterialfv(GL_FRONT, GL_EMISSION, black);  // Turn off emission
-        glPopMatrix();
-    }
+    if (isSun) glPopMatrix();
+}
 
-    // Clean up quadric object
-    gluDeleteQuadric(quad);
-    glDisable(GL_TEXTURE_2D);
+// Draw a star (command callback); stars stay meshes however small they get
+void drawStar(int idx) {
+    int lod = bodyLod[idx] < LOD_LEVELS ? bodyLod[idx] : LOD_LEVELS - 1;
+    glPushMatrix();
+    glTranslatef(bodies.x[idx], bodies.y[idx], bodies.z[idx]);
+    glRotatef(bodies.spin[idx], 0.0f, 1.0f, 0.0f);
+    drawTexturedSphere(bodyTextures[idx], bodySizes[idx], true, lodSegments[lod], bodySurfaces[idx]);
+    glPopMatrix();
 }
 
-// Draw a planet with its orbit and rotation
-void drawPlanet(double dist, double size, double orbitPeriod, double rotPeriod, int idx) {
-    if (idx >= MAX_PLANETS) return;  // Validate planet index
+// Move into a body's spinning frame (rotated for correct texture mapping)
+static void enterPlanetFrame(int idx) {
+    glTranslatef(bodies.x[idx], bodies.y[idx], bodies.z[idx]);  // Move to orbit position
+    glRotatef(90.0f, 1.0f, 0.0f, 0.0f);  // Rotate for correct texture mapping
+    glRotatef(bodies.spin[idx], 0.0f, 0.0f, 1.0f);  // Apply planet rotation
+}
 
-    // Update orbital and rotational angles based on time
-    double orbitSpeed = 2 * PI / orbitPeriod;
-    orbitAngles[idx] = fmod(orbitAngles[idx] + orbitSpeed * 0.016, 2 * PI);
-    spinAngles[idx] = fmod(spinAngles[idx] + (360.0 / rotPeriod) * 0.016, 360.0);
+// Draw a planet's surface (command callback)
+void drawPlanet(int idx) {
+    glPushMatrix();
+    enterPlanetFrame(idx);
+    drawTexturedSphere(bodyTextures[idx], bodySizes[idx], false, lodSegments[bodyLod[idx]], bodySurfaces[idx]);
+    glPopMatrix();
+}
 
-    // Calculate planet position in orbit
-    double x = -dist * sin(orbitAngles[idx]);
-    double z = dist * cos(orbitAngles[idx]);
+// Where a body's sphere is and how it is turned, matching drawStar() and drawPlanet()
+static void surfaceView(int idx, SurfaceView& view) {
+    double spin = bodies.spin[idx] * PI / 180.0, c = cos(spin), s = sin(spin);
+    view.center[0] = bodies.x[idx];
+    view.center[1] = bodies.y[idx];
+    view.center[2] = bodies.z[idx];
+    view.radius = bodySizes[idx];
+    // Stars spin about y before the texture turn about x; planets turn first, then spin about the pole
+    const double star[3][3] = { { c, 0.0, -s }, { s, 0.0, c }, { 0.0, -1.0, 0.0 } };
+    const double planet[3][3] = { { c, 0.0, s }, { -s, 0.0, c }, { 0.0, -1.0, 0.0 } };
+    memcpy(view.axes, catalog.kind[idx] == BODY_STAR ? star : planet, sizeof(view.axes));
+}
 
-    // Set up planet transformation
+// Draw a planet's rings (translucent command callback)
+void drawPlanetRings(int idx) {
     glPushMatrix();
-    glTranslatef(x, 0.0f, z);  // Move to orbit position
-    glRotatef(90.0f, 1.0f, 0.0f, 0.0f);  // Rotate for correct texture mapping
-    glRotatef(spinAngles[idx], 0.0f, 0.0f, 1.0f);  // Apply planet rotation
+    enterPlanetFrame(idx);
+    drawRingSystem(idx, bodySizes[idx], bodies.ringAngle);
+    glPopMatrix();
+}
 
-    // Set material properties
-    GLfloat matAmbDiff[] = { 0.8f, 0.8f, 0.8f, 1.0f };
-    GLfloat matSpec[] = { 0.1f, 0.1f, 0.1f, 1.0f };
-    glMaterialfv(GL_FRONT, GL_AMBIENT_AND_DIFFUSE, matAmbDiff);
-    glMaterialfv(GL_FRONT, GL_SPECULAR, matSpec);
-    glMaterialf(GL_FRONT, GL_SHININESS, 10.0f);
+// Record a star, or a planet or moon as an impostor dot or as its sphere plus translucent rings
+void submitBody(int idx) {
+    if (idx >= catalog.count()) return;  // Validate body index
+    if (bodyLod[idx] == LOD_CULLED) return;  // Outside the view
+    if (catalog.kind[idx] == BODY_STAR) {
+        submitDraw(opaqueDrawKey(bodyTextures[idx], MATERIAL_SUN), drawStar, idx);  // Emits light
+        return;
+    }
+    if (bodyLod[idx] == LOD_IMPOSTOR) {
+        submitDraw(opaqueDrawKey(0, MATERIAL_NONE), drawImpostor, idx);
+        return;
+    }
+    submitDraw(opaqueDrawKey(bodyTextures[idx], MATERIAL_PLANET), drawPlanet, idx);
+    if (catalog.bandCount[idx] > 0) {
+        float dx = bodies.x[idx] - camera.x, dy = bodies.y[idx] - camera.y, dz = bodies.z[idx] - camera.z;
+        submitDraw(translucentDrawKey(sqrtf(dx * dx + dy * dy + dz * dz)), drawPlanetRings, idx);
+    }
+}
 
-    // Draw the planet
-    drawTexturedSphere(textures[idx + 1], size);
+// Draw one frame from the current body snapshot (shared by the window and headless mode)
+void renderScene() {
+    beginRenderStateFrame();
 
-    // Draw rings if this planet has them (Saturn)
-    if (hasVisibleRings[idx]) {
-        glPushAttrib(GL_ENABLE_BIT);
-        glDisable(GL_LIGHTING);
-        drawSaturnRings(size);
-        glPopAttrib();
+    {
+        ProfileScope phase(PHASE_BACKGROUND);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);  // Clear color and depth buffers
+        drawBackground();  // Draw background first
     }
 
-    glPopMatrix();
-}
-
-// Main display function called by GLUT
-void display() {
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);  // Clear color and depth buffers
-    drawBackground();  // Draw background first
+    Frustum frustum;
+    {
+        ProfileScope phase(PHASE_VISIBILITY);
+        updateCamera();  // Update camera position based on current target
+
+        // Projection: far plane reaches just past the scene from wherever the camera is
+        double eyeDistance = sqrt(camera.x * camera.x + camera.y * camera.y + camera.z * camera.z);
+        ViewParams view = {
+            { camera.x, camera.y, camera.z }, { camera.tx, camera.ty, camera.tz }, { 0.0, 1.0, 0.0 },
+            FIELD_OF_VIEW, (double)windowWidth / windowHeight, 0.1, eyeDistance + SCENE_RADIUS, windowHeight
+        };
+        glMatrixMode(GL_PROJECTION);
+        glLoadIdentity();
+        gluPerspective(view.fovY, view.aspect, view.zNear, view.zFar);
+        glMatrixMode(GL_MODELVIEW);
+
+        // Visibility stage: cull against the frustum and pick a LOD for every body (on the workers)
+        buildFrustum(view, frustum);
+        visibleBodies = classifyBodies(frustum, bodies.x.data(), bodies.y.data(), bodies.z.data(),
+            bodyRadii.data(), (int)bodies.x.size(), bodyLod.data(), bodyPixels.data(), scheduler);
+    }
 
-    updateCamera();  // Update camera position based on current target
+    // Page in the surface tiles this view needs (stars are drawn as spheres however small)
+    if (streamingSurfaces) {
+        ProfileScope phase(PHASE_STREAMING);
+        for (int i = 0; i < catalog.count(); i++) {
+            if (bodySurfaces[i] < 0 || bodyLod[i] == LOD_CULLED) continue;
+            if (bodyLod[i] == LOD_IMPOSTOR && catalog.kind[i] != BODY_STAR) continue;
+            SurfaceView surface;
+            surfaceView(i, surface);
+            requestVirtualTexture(bodySurfaces[i], surface, frustum);
+        }
+        updateVirtualTextures(headless);  // Headless frames wait for their tiles, so they never depend on timing
+    }
 
     // Set up view transformation
     glLoadIdentity();
@@ -496,37 +995,141 @@ void display() {
         camera.tx, camera.ty, camera.tz,    // Look-at point
         0.0, 1.0, 0.0);                     // Up vector
 
-    drawStars();  // Draw starfield
+    {
+        ProfileScope phase(PHASE_STARS);
+        drawStarfield((float)(bodies.clock * 0.6));  // Draw starfield (flicker clock matches the old 0.01 per frame)
+    }
 
-    // Draw Sun at center
-    glPushMatrix();
-    drawTexturedSphere(textures[0], 3.0, true);  // Sun is larger and emits light
-    glPopMatrix();
+    {
+        ProfileScope phase(PHASE_ORBITS);
+        for (int i : simulation.childBodies) {
+            int p = simulation.parent[i];
+            setOrbitCenter(i, bodies.x[p], bodies.y[p], bodies.z[p]);  // Moon orbits follow their parents
+        }
+        drawOrbitPaths();  // Draw all orbit paths from the cached circle
+        if (showTrails) drawOrbitTrails(bodies);  // Only new samples are uploaded
+    }
+
+    // Record every body, then draw them grouped by texture and material (translucent rings last)
+    {
+        ProfileScope phase(PHASE_SUBMIT);
+        for (int i = 0; i < catalog.count(); i++) {
+            if (catalog.kind[i] != BODY_MINOR) submitBody(i);
+        }
+        submitMinorBodies();  // Asteroid belt and catalog minor bodies
+    }
 
-    // Draw all planets and their orbits
-    for (int i = 0; i < MAX_PLANETS; i++) {
-        drawOrbitRing(planetDistances[i]);  // Draw orbit path
-        drawPlanet(planetDistances[i], planetSizes[i],  // Draw planet
-            orbitalPeriods[i], rotationalPeriods[i], i);
+    {
+        ProfileScope phase(PHASE_BODIES);
+        executeDrawList();
     }
 
-    // Draw info box if a planet is selected
-    if (camera.targetPlanet != -1) {
-        drawInfoBox(camera.targetPlanet);
+    // Draw info box if a body is selected
+    ProfileScope phase(PHASE_OVERLAY);
+    if (camera.targetBody != -1) {
+        drawInfoBox(camera.targetBody);
+    }
+    if (showProfiler) {
+        drawProfilerHud();
+    }
+    if (showDate) {
+        drawDateLine();
     }
+    flushText(windowWidth, windowHeight);  // All queued text in one draw
+}
 
-    glutSwapBuffers();  // Swap front and back buffers for smooth animation
+// Timer callback for paced frames
+void frameDue(int) {
+    glutPostRedisplay();
 }
 
-// Timer callback for animation
-void updateScene(int val) {
-    glutPostRedisplay();  // Trigger redisplay
-    glutTimerFunc(16, updateScene, 0);  // Set up next frame (~60fps)
+// Ask for the next frame as the pacing mode dictates. Uncapped and vsync redraw straight away
+// (vsync blocks in the swap); a target rate waits for the next absolute deadline, letting GLUT
+// handle input meanwhile.
+void scheduleNextFrame() {
+    if (getPaceMode() == PACE_TARGET)
+        glutTimerFunc(millisecondsUntilNextFrame(), frameDue, 0);
+    else
+        glutPostRedisplay();
 }
 
-// Special key handler (arrow keys, etc.)
-void specialKeys(int key, int x, int y) {
-    if (camera.targetPlanet == -1) {  // Only allow movement in default view
+// Main display function called by GLUT
+void display() {
+    if (sessionPath) {
+        startSessionRecording(sessionPath, simulation, currentScene(), windowWidth, windowHeight);
+        sessionPath = 0;  // The log starts from the first frame's state
+    }
+    beginProfileFrame();
+
+    // Step the simulation by real elapsed time and blend for display
+    {
+        ProfileScope phase(PHASE_SIMULATION);
+        double elapsed = beginPacedFrame();  // Real time since the last frame began
+        recordSessionEvent(SESSION_FRAME, 0, 0, elapsed);  // Replays step by exactly the same amounts
+        double alpha = simulation.advance(elapsed);
+        simulation.interpolate(alpha, bodies);
+        recordOrbitTrails(simulation);
+        bodyIndex.update(bodies.x.data(), bodies.y.data(), bodies.z.data(), bodyRadii.data(), (int)bodies.x.size());
+    }
+
+    renderScene();
+
+    {
+        ProfileScope phase(PHASE_PRESENT);
+        if (captureOnStart) {
+            captureOnStart = false;
+            startRecording();
+        }
+        captureFrame();     // Queue the back buffer's readback before it is swapped away
+        glutSwapBuffers();  // Swap front and back buffers for smooth animation
+    }
+    endPacedFrame();
+    endProfileFrame();
+
+    scheduleNextFrame();
+}
+
+// Select the body under window pixel (x, y)
+void pickBody(int x, int y) {
+    // Ray through the clicked pixel, from the same view renderScene() sets up
+    double forward[3] = { camera.tx - camera.x, camera.ty - camera.y, camera.tz - camera.z };
+    double length = sqrt(forward[0] * forward[0] + forward[1] * forward[1] + forward[2] * forward[2]);
+    if (length < 1e-9) return;
+    for (int a = 0; a < 3; a++) forward[a] /= length;
+    double right[3] = { -forward[2], 0.0, forward[0] };  // forward x (0, 1, 0)
+    length = sqrt(right[0] * right[0] + right[2] * right[2]);
+    if (length < 1e-9) return;
+    right[0] /= length;
+    right[2] /= length;
+    double up[3] = { right[1] * forward[2] - right[2] * forward[1], right[2] * forward[0] - right[0] * forward[2],
+                     right[0] * forward[1] - right[1] * forward[0] };
+    double tanHalf = tan(FIELD_OF_VIEW * PI / 360.0);
+    double sx = (2.0 * (x + 0.5) / windowWidth - 1.0) * tanHalf * windowWidth / windowHeight;
+    double sy = (1.0 - 2.0 * (y + 0.5) / windowHeight) * tanHalf;
+    float origin[3] = { camera.x, camera.y, camera.z };
+    float direction[3];
+    for (int a = 0; a < 3; a++) direction[a] = (float)(forward[a] + sx * right[a] + sy * up[a]);
+
+    // Widen the ray by a few pixels so tiny, distant bodies can still be clicked
+    float spread = (float)(PICK_PIXELS * 2.0 * tanHalf / windowHeight);
+    int hit = bodyIndex.raycast(origin, direction, spread);
+    if (hit >= 0) {
+        camera.targetBody = hit;
+        camera.isMoving = false;
+    }
+}
+
+// Mouse handler: a left click selects the body under the cursor
+void mouse(int button, int state, int x, int y) {
+    if (button != GLUT_LEFT_BUTTON || state != GLUT_DOWN) return;
+    notePacedInput();
+    recordSessionEvent(SESSION_CLICK, x, y);
+    pickBody(x, y);
+}
+
+// Move the camera with the arrow and page keys
+void moveCamera(int key) {
+    if (camera.targetBody == -1) {  // Only allow movement in default view
         switch (key) {
         case GLUT_KEY_LEFT:  camera.x -= 0.5f; break;      // Move camera left
         case GLUT_KEY_RIGHT: camera.x += 0.5f; break;     // Move camera right
@@ -540,13 +1143,251 @@ void specialKeys(int key, int x, int y) {
     }
 }
 
+// Special key handler (arrow keys, etc.)
+void specialKeys(int key, int x, int y) {
+    notePacedInput();
+    recordSessionEvent(SESSION_SPECIAL, key);
+    moveCamera(key);
+}
+
+// Apply a replayed input event the way the window's handlers did
+void applySessionEvent(const SessionEvent& event) {
+    switch (event.type) {
+    case SESSION_KEY:     sceneKey((unsigned char)event.a); break;
+    case SESSION_SPECIAL: moveCamera(event.a); break;
+    case SESSION_CLICK:   pickBody(event.a, event.b); break;
+    case SESSION_RESIZE:
+        // The framebuffer keeps its size, but the view and picking follow the window as recorded
+        windowWidth = event.a;
+        windowHeight = event.b;
+        glViewport(0, 0, windowWidth, windowHeight);
+        break;
+    }
+}
+
+// Render a fixed number of frames offscreen, one fixed step apart, as fast as possible.
+// A replayed session instead steps and handles input exactly as the recorded window did.
+int runHeadless(int* argc, char** argv) {
+    if (!createHeadlessContext(windowWidth, windowHeight, argc, argv)) return EXIT_FAILURE;
+    initGL();
+
+    if (capturePath && !startCapture(capturePath, windowWidth, windowHeight, (int)(1.0 / simulation.fixedStep + 0.5))) {
+        destroyHeadlessContext();
+        return EXIT_FAILURE;
+    }
+    const int frames = replaying ? replay.frames : headlessFrames;
+    const int width = windowWidth, height = windowHeight;  // Framebuffer size (replayed resizes only change the view)
+    int nextEvent = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int f = 0; f < frames; f++) {
+        beginProfileFrame();
+        {
+            ProfileScope phase(PHASE_SIMULATION);
+            if (replaying) {
+                // Input handled before this frame, then the frame's recorded real time
+                while (replay.events[nextEvent].type != SESSION_FRAME) applySessionEvent(replay.events[nextEvent++]);
+                double alpha = simulation.advance(replay.events[nextEvent++].value);
+                simulation.interpolate(alpha, bodies);
+            }
+            else {
+                simulation.step(simulation.stepDuration());
+                simulation.interpolate(1.0, bodies);
+            }
+            recordOrbitTrails(simulation);
+            if (replaying)  // Replayed clicks pick from it
+                bodyIndex.update(bodies.x.data(), bodies.y.data(), bodies.z.data(), bodyRadii.data(), (int)bodies.x.size());
+        }
+        renderScene();
+        {
+            ProfileScope phase(PHASE_PRESENT);
+            captureFrame();  // Does nothing unless --capture or --dump-frames was given
+        }
+        endProfileFrame();
+    }
+    glFinish();  // Count the GPU work, not just the submission
+    stopCapture();  // Includes encoding the last frames
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    resolveProfileQueries();
+
+    printf("Headless: %d frames at %dx%d in %.3f s (%.1f frames/s, %.3f ms/frame)\n",
+           frames, width, height, seconds, frames / seconds, 1000.0 * seconds / frames);
+    printProfileSummary();
+    if (capturePath) printCaptureSummary();
+
+    int status = 0;
+    if (replaying) {
+        unsigned long long hash = simulationStateHash(simulation);
+        if (!replay.complete)
+            printf("Replayed %d frames; the log was never closed, so there is no final state to compare\n", frames);
+        else if (hash == replay.finalHash)
+            printf("Replay matches the recorded session (state %016llx)\n", hash);
+        else {
+            printf("Replay diverged: state %016llx, recorded %016llx\n", hash, replay.finalHash);
+            status = EXIT_FAILURE;
+        }
+        closeSessionReplay(replay);
+    }
+    if (snapshotPath) {
+        saveSnapshot();
+        finishSnapshotWrites();
+    }
+    clearMeshCache();  // Its buffers belong to the context
+    destroyHeadlessContext();
+    return status;
+}
+
+// Sweep the instanced asteroid path against per-body draws in an offscreen context
+int runInstancingBenchmark(int* argc, char** argv) {
+    if (!createHeadlessContext(windowWidth, windowHeight, argc, argv)) return EXIT_FAILURE;
+    benchRockInstances(instancingBenchMax, windowWidth, windowHeight);
+    clearMeshCache();
+    destroyHeadlessContext();
+    return 0;
+}
+
+// Load the scene catalog, reporting how long it took
+bool loadSceneCatalog() {
+    char error[256];
+    auto start = std::chrono::steady_clock::now();
+    if (!loadCatalog(catalogPath, catalog, error, sizeof(error))) {
+        printf("Catalog load failed: %s\n", error);
+        return false;
+    }
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    printf("Catalog %s: %d bodies in %.2f ms\n", catalogPath, catalog.count(), ms);
+    return true;
+}
+
+// Convert a catalog (usually the text form) to the binary form: --build-catalog in out
+int buildCatalog(const char* in, const char* out) {
+    catalogPath = in;
+    if (!loadSceneCatalog()) return EXIT_FAILURE;
+    if (!writeCatalogBinary(out, catalog)) {
+        printf("Could not write %s\n", out);
+        return EXIT_FAILURE;
+    }
+    printf("Wrote %s\n", out);
+    return 0;
+}
+
 // Main program entry point
 int main(int argc, char** argv) {
+    // Headless benchmarks run before any window is created
+    if (runBenchmarks(argc, argv)) return 0;
+
+    // Scene options
+    const char* resumePath = 0;  // --resume
+    const char* replayPath = 0;  // --replay
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--belt") == 0 && i + 1 < argc)
+            asteroidCount = atoi(argv[++i]);             // Number of asteroids in the belt
+        else if (strcmp(argv[i], "--theta") == 0 && i + 1 < argc)
+            simulation.gravity.theta = atof(argv[++i]);  // Barnes-Hut accuracy
+        else if (strcmp(argv[i], "--stars") == 0 && i + 1 < argc)
+            starTotal = atoi(argv[++i]);                 // Stars in the background field
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+            threadCount = atoi(argv[++i]);               // Worker threads (0 = all cores)
+        else if (strcmp(argv[i], "--headless") == 0)
+            headless = true;                             // Offscreen rendering, no window
+        else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+            headlessFrames = atoi(argv[++i]);            // Frames to render in headless mode
+        else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc)
+            sscanf(argv[++i], "%dx%d", &windowWidth, &windowHeight);  // Frame size, e.g. 1280x720
+        else if (strcmp(argv[i], "--dump-frames") == 0 && i + 1 < argc)
+            capturePath = argv[++i];                     // Write every headless frame to disk
+        else if (strcmp(argv[i], "--capture") == 0 && i + 1 < argc) {
+            capturePath = argv[++i];                     // Record from the first frame (R toggles in the window)
+            captureOnStart = true;
+        }
+        else if (strcmp(argv[i], "--profile-csv") == 0 && i + 1 < argc)
+            profileCsvPath = argv[++i];                  // Per-frame phase timings
+        else if (strcmp(argv[i], "--profile-trace") == 0 && i + 1 < argc)
+            profileTracePath = argv[++i];                // Chrome trace of every frame
+        else if (strcmp(argv[i], "--catalog") == 0 && i + 1 < argc)
+            catalogPath = argv[++i];                     // Bodies to simulate (text or binary)
+        else if (strcmp(argv[i], "--no-instancing") == 0)
+            allowInstancing = false;                     // Draw asteroid meshes one by one
+        else if (strcmp(argv[i], "--bench-instancing") == 0)
+            instancingBenchMax = (i + 1 < argc && argv[i + 1][0] != '-') ? atoi(argv[++i]) : 100000;
+        else if (strcmp(argv[i], "--warp") == 0 && i + 1 < argc) {
+            simulation.timeWarp = fmax(1.0, fmin(atof(argv[++i]), SIM_MAX_TIME_WARP));  // Simulated seconds per second
+            showDate = simulation.timeWarp > 1.0;
+        }
+        else if (strcmp(argv[i], "--date") == 0 && i + 1 < argc) {
+            int year, month, day;  // Start the scene on YYYY-MM-DD
+            if (sscanf(argv[++i], "%d-%d-%d", &year, &month, &day) != 3) {
+                printf("Invalid --date; expected YYYY-MM-DD\n");
+                return EXIT_FAILURE;
+            }
+            startTime = daysFromCivil(year, month, day) / 365.25 * SCENE_SECONDS_PER_YEAR;
+            showDate = true;
+        }
+        else if (strcmp(argv[i], "--uncapped") == 0)
+            paceMode = PACE_UNCAPPED;                    // Redraw as fast as possible
+        else if (strcmp(argv[i], "--vsync") == 0)
+            paceMode = PACE_VSYNC;                       // Redraw once per display refresh (default)
+        else if (strcmp(argv[i], "--fps") == 0 && i + 1 < argc) {
+            paceMode = PACE_TARGET;                      // Redraw at a fixed rate
+            paceFps = fmax(1.0, atof(argv[++i]));
+        }
+        else if (strcmp(argv[i], "--trails") == 0)
+            showTrails = true;                           // Start with trajectory trails shown
+        else if (strcmp(argv[i], "--trail-length") == 0 && i + 1 < argc)
+            trailLength = atoi(argv[++i]);               // Samples kept per trail
+        else if (strcmp(argv[i], "--trail-decimation") == 0 && i + 1 < argc)
+            trailDecimation = atoi(argv[++i]);           // Fixed steps between samples
+        else if (strcmp(argv[i], "--no-virtual-textures") == 0)
+            allowVirtualTextures = false;                // Load every surface whole, even with a .vtex
+        else if (strcmp(argv[i], "--vt-budget") == 0 && i + 1 < argc)
+            virtualBudgetMB = atoi(argv[++i]);           // GPU memory for streamed surface tiles
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            starSeed = (unsigned)strtoul(argv[++i], 0, 10);  // Background star layout
+            seedGiven = true;
+        }
+        else if (strcmp(argv[i], "--snapshot") == 0 && i + 1 < argc)
+            snapshotPath = argv[++i];                    // Saved by S, or after the last headless frame
+        else if (strcmp(argv[i], "--resume") == 0 && i + 1 < argc)
+            resumePath = argv[++i];                      // Start from a snapshot
+        else if (strcmp(argv[i], "--record-session") == 0 && i + 1 < argc)
+            sessionPath = argv[++i];                     // Log the window's input and frame times
+        else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc)
+            replayPath = argv[++i];                      // Replay a session log headless
+        else if (strcmp(argv[i], "--build-catalog") == 0 && i + 2 < argc)
+            return buildCatalog(argv[i + 1], argv[i + 2]);  // Convert to binary and exit
+        else if (strcmp(argv[i], "--build-vtex") == 0 && i + 2 < argc)
+            return buildVirtualTexture(argv[i + 1], argv[i + 2]) ? 0 : EXIT_FAILURE;  // Tile an image and exit
+    }
+    if (profileCsvPath || profileTracePath) {
+        setProfileRecording(true);
+        atexit(writeProfiles);  // GLUT never returns from its main loop, so export on exit
+    }
+    atexit(shutdownVirtualTextures);  // Tile decoders must stop before the process tears down
+    atexit(finishSnapshotWrites);     // As must a snapshot still being written
+    scheduler = new TaskScheduler(threadCount);
+    simulation.scheduler = scheduler;
+    bodyIndex.scheduler = scheduler;
+
+    if (windowWidth < 1 || windowHeight < 1) {
+        printf("Invalid --size; expected WIDTHxHEIGHT\n");
+        return EXIT_FAILURE;
+    }
+    if (instancingBenchMax > 0) return runInstancingBenchmark(&argc, argv);
+    if (!loadSceneCatalog()) return EXIT_FAILURE;
+    if (!seedGiven) starSeed = (unsigned)std::time(0);
+    if ((resumePath || replayPath) && !resumeScene(resumePath, replayPath)) return EXIT_FAILURE;
+    if (replayPath) {
+        // Replays run offscreen at the recorded window size
+        replaying = headless = true;
+        windowWidth = replay.width;
+        windowHeight = replay.height;
+    }
+    if (headless) return runHeadless(&argc, argv);
+
     // Initialize GLUT
     glutInit(&argc, argv);
     // Set up display mode with double buffering, depth buffer, RGB color, and multisampling
     glutInitDisplayMode(GLUT_DOUBLE | GLUT_DEPTH | GLUT_RGB | GLUT_MULTISAMPLE);
-    glutInitWindowSize(1920, 1080);  // Set window size to HD resolution
+    glutInitWindowSize(windowWidth, windowHeight);  // HD resolution unless --size is given
     glutCreateWindow("Solar System Viewer with Info Boxes");  // Create window
     glutFullScreen();  // Start in fullscreen mode
 
@@ -557,7 +1398,13 @@ int main(int argc, char** argv) {
     glutReshapeFunc(reshape);    // Window resize handler
     glutKeyboardFunc(keyboard);  // Keyboard input handler
     glutSpecialFunc(specialKeys); // Special key handler
-    glutTimerFunc(0, updateScene, 0);  // Start animation timer
+    glutMouseFunc(mouse);        // Click to select a body
+    setPaceMode(paceMode, paceFps);  // Frames are then requested from display() itself
+#ifdef FREEGLUT
+    glutCloseFunc(stopRecording);  // Closing the window ends any recording while the context still exists
+#endif
+    atexit(stopRecording);  // Any other exit too (frames that can no longer be read back are dropped)
+    if (sessionPath) atexit(finishSession);
 
     glutMainLoop();  // Enter main event loop
     return 0;
@@ -0,0 +1,358 @@
+// Command-line benchmarks that run without a window or GL context
+#include "Benchmarks.h"
+#include "Simulation.h"
+#include "Catalog.h"
+#include "SpatialIndex.h"
+#include <stdio.h>            // Standard I/O functions
+#include <stdlib.h>           // atoi, strtod
+#include <string.h>           // strcmp, strncmp
+#include <math.h>             // fabs
+#include <algorithm>          // partial_sort
+#include <vector>
+#include <chrono>             // High resolution timing
+
+// Seconds elapsed since the given start point
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Read an integer argument following argv[i], or return the fallback
+static int intArg(int argc, char** argv, int i, int fallback) {
+    return (i < argc && argv[i][0] != '-') ? atoi(argv[i]) : fallback;
+}
+
+// Read the Barnes-Hut opening angle following argv[i]; anything but a positive number gives 0.5
+static double thetaArg(int argc, char** argv, int i) {
+    if (i >= argc || strncmp(argv[i], "--", 2) == 0) return 0.5;  // Negative values still get rejected below
+    char* end;
+    double theta = strtod(argv[i], &end);
+    if (end == argv[i] || *end != '\0' || !(theta > 0.0)) {
+        printf("Ignoring theta '%s' (must be a positive number); using 0.5\n", argv[i]);
+        return 0.5;
+    }
+    return theta;
+}
+
+// Fixed-timestep orbit update throughput: --bench-sim [bodies] [steps]
+static void benchSimulation(int bodies, int steps) {
+    Simulation sim;
+    for (int i = 0; i < bodies; ++i)
+        sim.addBody(6.0 + i * 0.01, 3.0 + (i % 40), 1.0 + (i % 4) * 0.5);
+
+    BodySnapshot snapshot;
+    auto start = std::chrono::steady_clock::now();
+    for (int s = 0; s < steps; ++s)
+        sim.step(SIM_FIXED_STEP);  // One at a time: a batch of orbit steps costs a single evaluation
+    double elapsed = secondsSince(start);
+    sim.interpolate(0.5, snapshot);  // Touch the snapshot path as the renderer would
+
+    printf("bench-sim: %d bodies, %d steps in %.3f s\n", bodies, steps, elapsed);
+    printf("  %.0f steps/s, %.3e body-steps/s\n", steps / elapsed, (double)bodies * steps / elapsed);
+}
+
+// Barnes-Hut N-body throughput across body counts: --bench-nbody [maxBodies] [steps] [theta]
+static void benchNBody(int maxBodies, int steps, double theta) {
+    printf("bench-nbody: theta %.2f, %d steps per size\n", theta, steps);
+    for (int n = 1000; n <= maxBodies; n *= 10) {
+        Simulation sim;
+        sim.gravity.theta = theta;
+        // Massive bodies spread through a disc so the tree has real work to do
+        srand(1);
+        for (int i = 0; i < n; ++i) {
+            double r = 6.0 + 44.0 * (rand() / (double)RAND_MAX);
+            double phase = 6.283185307179586 * (rand() / (double)RAND_MAX);
+            sim.addBody(r, sim.keplerPeriod(r), 1.0, phase, 1e-6 * sim.centralMass);
+        }
+        sim.setMode(SIM_NBODY);
+
+        auto start = std::chrono::steady_clock::now();
+        sim.step(SIM_FIXED_STEP, steps);
+        double elapsed = secondsSince(start);
+        printf("  N=%8d  %8.3f s  %.3e body-steps/s  (%d tree nodes)\n",
+            n, elapsed, (double)n * steps / elapsed, sim.gravity.nodeCount());
+    }
+}
+
+// Thread scaling of the N-body step: --bench-threads [bodies] [steps]
+static void benchThreads(int bodies, int steps) {
+    printf("bench-threads: N=%d, %d steps\n", bodies, steps);
+    double serial = 0.0;
+    const int threadCounts[] = { 1, 2, 4, 8, 16 };
+    for (int t : threadCounts) {
+        TaskScheduler scheduler(t);
+        Simulation sim;
+        sim.scheduler = &scheduler;
+        srand(1);
+        for (int i = 0; i < bodies; ++i) {
+            double r = 6.0 + 44.0 * (rand() / (double)RAND_MAX);
+            double phase = 6.283185307179586 * (rand() / (double)RAND_MAX);
+            sim.addBody(r, sim.keplerPeriod(r), 1.0, phase, 1e-6 * sim.centralMass);
+        }
+        sim.setMode(SIM_NBODY);
+
+        auto start = std::chrono::steady_clock::now();
+        sim.step(SIM_FIXED_STEP, steps);
+        double elapsed = secondsSince(start);
+        if (t == 1) serial = elapsed;
+        printf("  %2d threads  %8.3f s  %.3e body-steps/s  speedup %.2fx\n",
+            t, elapsed, (double)bodies * steps / elapsed, serial / elapsed);
+    }
+}
+
+// Catalog load time, text parse vs binary mapping: --bench-catalog [bodies]
+static void benchCatalog(int bodies) {
+    const char* textPath = "bench-catalog.txt";
+    const char* binaryPath = "bench-catalog.bin";
+    FILE* out = fopen(textPath, "w");
+    if (!out) {
+        printf("bench-catalog: cannot write %s\n", textPath);
+        return;
+    }
+    // A star with planets and moons, then a belt of minor bodies
+    srand(1);
+    fprintf(out, "body Sun star - 0 3 0 0 0 1 Sun.jpg\nfact - Benchmark star\n");
+    for (int i = 1; i < bodies; ++i) {
+        double r = 6.0 + 44.0 * (rand() / (double)RAND_MAX);
+        double phase = 360.0 * (rand() / (double)RAND_MAX);
+        if (i % 1000 == 1)
+            fprintf(out, "body P%d planet - %.3f 1 %.3f 2 %.2f 1e-6 Earth.jpg\nfact - Planet %d\n", i, r, r, phase, i);
+        else if (i % 1000 == 2)
+            fprintf(out, "body M%d moon P%d 2 0.2 2 2 %.2f 1e-8 -\n", i, i - 1, phase);
+        else
+            fprintf(out, "body A%d minor - %.3f 0.05 %.3f 1 %.2f 0 -\n", i, r, r, phase);
+    }
+    fclose(out);
+
+    BodyCatalog catalog;
+    char error[256];
+    auto start = std::chrono::steady_clock::now();
+    bool ok = parseCatalogText(textPath, catalog, error, sizeof(error));
+    double textSeconds = secondsSince(start);
+    ok = ok && writeCatalogBinary(binaryPath, catalog);
+    start = std::chrono::steady_clock::now();
+    ok = ok && loadCatalog(binaryPath, catalog, error, sizeof(error));
+    double binarySeconds = secondsSince(start);
+    remove(textPath);
+    remove(binaryPath);
+    if (!ok) {
+        printf("bench-catalog: %s\n", error);
+        return;
+    }
+    printf("bench-catalog: %d bodies\n", catalog.count());
+    printf("  text parse  %8.2f ms\n", textSeconds * 1000.0);
+    printf("  binary load %8.2f ms  (%.1fx faster)\n", binarySeconds * 1000.0, textSeconds / binarySeconds);
+}
+
+// Kepler propagation, SIMD against scalar, and seek cost at near and far times:
+// --bench-kepler [bodies] [evaluations]
+static void benchKepler(int bodies, int evaluations) {
+    Simulation sim;
+    srand(1);
+    for (int i = 0; i < bodies; ++i) {
+        double r = 6.0 + 44.0 * (rand() / (double)RAND_MAX);
+        sim.addBody(r, sim.keplerPeriod(r), 1.0, 6.283185307179586 * (rand() / (double)RAND_MAX));
+        OrbitalElements orbit = { r, 0.9 * (rand() / (double)RAND_MAX), 0.3 * (rand() / (double)RAND_MAX),
+                                  6.283185307179586 * (rand() / (double)RAND_MAX),
+                                  6.283185307179586 * (rand() / (double)RAND_MAX) };
+        sim.setOrbit(i, orbit);
+    }
+    const KeplerOrbits orbits = { sim.orbitSpeed.data(), sim.epochAnomaly.data(), sim.eccentricity.data(),
+                                  sim.basisPX.data(), sim.basisPY.data(), sim.basisPZ.data(),
+                                  sim.basisQX.data(), sim.basisQY.data(), sim.basisQZ.data() };
+    std::vector<double> x(bodies), y(bodies), z(bodies), rx(bodies), ry(bodies), rz(bodies);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int k = 0; k < evaluations; ++k)
+        propagateKepler(orbits, k * 0.37, 0, bodies, x.data(), y.data(), z.data());
+    double simdSeconds = secondsSince(start);
+    start = std::chrono::steady_clock::now();
+    for (int k = 0; k < evaluations; ++k)
+        propagateKeplerScalar(orbits, k * 0.37, 0, bodies, rx.data(), ry.data(), rz.data());
+    double scalarSeconds = secondsSince(start);
+
+    // Largest disagreement over a spread of times, relative to the orbit size
+    double maxError = 0.0;
+    const double times[] = { 0.0, 1e3, 1e6, 1e9, 1e12 };
+    for (double t : times) {
+        propagateKepler(orbits, t, 0, bodies, x.data(), y.data(), z.data());
+        propagateKeplerScalar(orbits, t, 0, bodies, rx.data(), ry.data(), rz.data());
+        for (int i = 0; i < bodies; ++i) {
+            double error = (fabs(x[i] - rx[i]) + fabs(y[i] - ry[i]) + fabs(z[i] - rz[i])) / sim.distance[i];
+            if (error > maxError) maxError = error;
+        }
+    }
+
+    const double evals = (double)bodies * evaluations;
+    printf("bench-kepler: %d elliptical orbits (e < 0.9), %d evaluations\n", bodies, evaluations);
+    printf("  simd    %8.3f s  %.3e bodies/s\n", simdSeconds, evals / simdSeconds);
+    printf("  scalar  %8.3f s  %.3e bodies/s  (simd %.2fx)\n", scalarSeconds, evals / scalarSeconds,
+           scalarSeconds / simdSeconds);
+    printf("  max difference %.2e of the semi-major axis\n", maxError);
+
+    // Seeking evaluates once at the target time, however far away it is
+    const double targets[] = { 1e3, 1e6, 1e12 };
+    for (double t : targets) {
+        start = std::chrono::steady_clock::now();
+        const int seeks = 20;
+        for (int k = 0; k < seeks; ++k) sim.seek(t + k);
+        printf("  seek to t=%-6g %8.3f ms\n", t, secondsSince(start) * 1000.0 / seeks);
+    }
+}
+
+// Spatial index build, refit and query latency, checked against brute force:
+// --bench-spatial [bodies] [queries]
+static void benchSpatial(int bodies, int queries) {
+    // A thick belt of asteroid-sized bodies turning at Keplerian rates
+    srand(7);
+    std::vector<float> x(bodies), y(bodies), z(bodies), radius(bodies, 0.05f);
+    std::vector<double> orbit(bodies), angle(bodies), rate(bodies);
+    for (int i = 0; i < bodies; ++i) {
+        orbit[i] = 10.0 + 40.0 * (rand() / (double)RAND_MAX);
+        angle[i] = 6.283185307179586 * (rand() / (double)RAND_MAX);
+        rate[i] = 0.01 * pow(10.0 / orbit[i], 1.5);  // Radians per step: the inner edge orbits in 628 steps
+        y[i] = (float)(2.0 * (rand() / (double)RAND_MAX) - 1.0);
+    }
+    auto place = [&]() {
+        for (int i = 0; i < bodies; ++i) {
+            x[i] = (float)(orbit[i] * cos(angle[i]));
+            z[i] = (float)(orbit[i] * sin(angle[i]));
+        }
+    };
+    place();
+
+    TaskScheduler scheduler;  // All cores for the refit
+    SpatialIndex index;
+    index.scheduler = &scheduler;
+    auto start = std::chrono::steady_clock::now();
+    index.build(x.data(), y.data(), z.data(), radius.data(), bodies);
+    double buildSeconds = secondsSince(start);
+
+    // Refit after every step, as the window does after each frame
+    const int steps = 100;
+    double refitSeconds = 0.0;
+    for (int s = 0; s < steps; ++s) {
+        for (int i = 0; i < bodies; ++i) angle[i] += rate[i];
+        place();
+        start = std::chrono::steady_clock::now();
+        index.update(x.data(), y.data(), z.data(), radius.data(), bodies);
+        refitSeconds += secondsSince(start);
+    }
+
+    printf("bench-spatial: %d bodies, %d nodes, %d queries of each kind, %d threads for the refit\n", bodies,
+           index.nodeCount(), queries, scheduler.threadCount());
+    printf("  build        %10.2f ms\n", buildSeconds * 1000.0);
+    printf("  update       %10.2f ms mean over %d steps (%d rebuilds)\n", refitSeconds * 1000.0 / steps, steps,
+           index.buildCount() - 1);
+
+    // Rays from a camera above the belt towards random bodies, a few pixels wide at 1080p;
+    // points for the proximity queries anywhere in the belt
+    const float eye[3] = { 0.0f, 15.0f, 60.0f };
+    const float spread = 4.0f * 0.00142f;
+    const int K = 8;
+    const float R = 1.0f;
+    std::vector<float> rays(queries * 3), points(queries * 3);
+    for (int q = 0; q < queries; ++q) {
+        int target = rand() % bodies;
+        rays[q * 3 + 0] = x[target] - eye[0];
+        rays[q * 3 + 1] = y[target] - eye[1];
+        rays[q * 3 + 2] = z[target] - eye[2];
+        int near = rand() % bodies;
+        points[q * 3 + 0] = x[near] + (float)(rand() / (double)RAND_MAX - 0.5);
+        points[q * 3 + 1] = y[near];
+        points[q * 3 + 2] = z[near] + (float)(rand() / (double)RAND_MAX - 0.5);
+    }
+    std::vector<int> picks(queries), found;
+    std::vector<int> nearestIndex(K);
+    std::vector<float> nearestDistance(K);
+    size_t foundTotal = 0;
+
+    start = std::chrono::steady_clock::now();
+    for (int q = 0; q < queries; ++q) picks[q] = index.raycast(eye, &rays[q * 3], spread);
+    double raySeconds = secondsSince(start);
+    start = std::chrono::steady_clock::now();
+    for (int q = 0; q < queries; ++q)
+        index.nearest(points[q * 3], points[q * 3 + 1], points[q * 3 + 2], K, nearestIndex.data(), nearestDistance.data());
+    double nearestSeconds = secondsSince(start);
+    start = std::chrono::steady_clock::now();
+    for (int q = 0; q < queries; ++q) {
+        found.clear();
+        index.withinRadius(points[q * 3], points[q * 3 + 1], points[q * 3 + 2], R, found);
+        foundTotal += found.size();
+    }
+    double radiusSeconds = secondsSince(start);
+
+    // The same queries by testing every body, on a sample
+    const int checks = std::min(queries, 20);
+    int mismatches = 0;
+    std::vector<float> d2(bodies);
+    start = std::chrono::steady_clock::now();
+    for (int q = 0; q < checks; ++q) {
+        const float* dir = &rays[q * 3];
+        float length = sqrtf(dir[0] * dir[0] + dir[1] * dir[1] + dir[2] * dir[2]);
+        float best = 1e30f;
+        int hit = -1;
+        for (int i = 0; i < bodies; ++i) {
+            float ox = x[i] - eye[0], oy = y[i] - eye[1], oz = z[i] - eye[2];
+            float along = (ox * dir[0] + oy * dir[1] + oz * dir[2]) / length;
+            float r = radius[i] + spread * std::max(along, 0.0f);
+            float miss2 = ox * ox + oy * oy + oz * oz - along * along;
+            if (miss2 > r * r || along + sqrtf(r * r - miss2) < 0.0f) continue;
+            float t = std::max(along - sqrtf(r * r - miss2), 0.0f);
+            if (t < best) { best = t; hit = i; }
+        }
+        if (hit != picks[q]) ++mismatches;
+    }
+    double bruteSeconds = secondsSince(start) / checks;
+    for (int q = 0; q < checks; ++q) {
+        const float* p = &points[q * 3];
+        int inside = 0;
+        for (int i = 0; i < bodies; ++i) {
+            float dx = x[i] - p[0], dy = y[i] - p[1], dz = z[i] - p[2];
+            d2[i] = dx * dx + dy * dy + dz * dz;
+            if (d2[i] <= (R + radius[i]) * (R + radius[i])) ++inside;
+        }
+        std::partial_sort(d2.begin(), d2.begin() + K, d2.end());
+        index.nearest(p[0], p[1], p[2], K, nearestIndex.data(), nearestDistance.data());
+        if (fabs(nearestDistance[K - 1] - sqrtf(d2[K - 1])) > 1e-4f) ++mismatches;
+        found.clear();
+        index.withinRadius(p[0], p[1], p[2], R, found);
+        if ((int)found.size() != inside) ++mismatches;
+    }
+
+    printf("  ray pick     %10.2f us/query\n", raySeconds * 1e6 / queries);
+    printf("  %d-nearest    %10.2f us/query\n", K, nearestSeconds * 1e6 / queries);
+    printf("  radius %.1f   %10.2f us/query (%.1f bodies found on average)\n", R, radiusSeconds * 1e6 / queries,
+           (double)foundTotal / queries);
+    printf("  brute force  %10.2f us per ray\n", bruteSeconds * 1e6);
+    printf("  %d of %d sampled queries disagree with brute force\n", mismatches, checks * 3);
+}
+
+bool runBenchmarks(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--bench-sim") == 0) {
+            benchSimulation(intArg(argc, argv, i + 1, 7), intArg(argc, argv, i + 2, 100000));
+            return true;
+        }
+        if (strcmp(argv[i], "--bench-nbody") == 0) {
+            benchNBody(intArg(argc, argv, i + 1, 100000), intArg(argc, argv, i + 2, 10), thetaArg(argc, argv, i + 3));
+            return true;
+        }
+        if (strcmp(argv[i], "--bench-threads") == 0) {
+            benchThreads(intArg(argc, argv, i + 1, 100000), intArg(argc, argv, i + 2, 5));
+            return true;
+        }
+        if (strcmp(argv[i], "--bench-kepler") == 0) {
+            benchKepler(intArg(argc, argv, i + 1, 100000), intArg(argc, argv, i + 2, 100));
+            return true;
+        }
+        if (strcmp(argv[i], "--bench-spatial") == 0) {
+            benchSpatial(intArg(argc, argv, i + 1, 1000000), intArg(argc, argv, i + 2, 10000));
+            return true;
+        }
+        if (strcmp(argv[i], "--bench-catalog") == 0) {
+            benchCatalog(intArg(argc, argv, i + 1, 100000));
+            return true;
+        }
+    }
+    return false;
+}
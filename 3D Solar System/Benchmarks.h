@@ -0,0 +1,6 @@
+// Command-line benchmarks that run without a window or GL context
+#pragma once
+
+// Run the benchmark named on the command line, if any.
+// Returns true when a benchmark ran (the program should then exit).
+bool runBenchmarks(int argc, char** argv);
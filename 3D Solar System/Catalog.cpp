@@ -0,0 +1,340 @@
+// Body catalog loading: text for authoring, packed binary columns for fast startup
+#include "Catalog.h"
+#include "MappedFile.h"       // Zero-copy view of binary catalogs
+#include <stdio.h>            // FILE, fgets, snprintf
+#include <stdlib.h>           // strtod
+#include <string.h>           // strcmp, memcpy
+#include <stdint.h>           // Fixed-width header fields
+#include <string>
+#include <unordered_map>
+
+static const double DEG_TO_RAD = 3.14159265358979323846 / 180.0;
+static const char CATALOG_MAGIC[4] = { 'S', 'C', 'A', 'T' };
+static const uint32_t CATALOG_VERSION = 2;  // 2 added orbital elements
+
+// Fixed-layout header; the columns follow in the order of BodyCatalog's fields
+struct CatalogHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t bodyCount;
+    uint32_t bandCount;
+    uint32_t stringBytes;
+    uint32_t reserved;
+};
+
+// Reads the binary format from a mapping when there is one, otherwise from a stream
+struct CatalogSource {
+    const unsigned char* data;  // Mapped file (null when streaming)
+    size_t size, position;
+    FILE* file;                 // Stream used when mapping is unavailable
+
+    bool read(void* out, size_t bytes) {
+        if (bytes == 0) return true;
+        if (!data) return fread(out, 1, bytes, file) == bytes;
+        if (bytes > size - position) return false;
+        memcpy(out, data + position, bytes);
+        position += bytes;
+        return true;
+    }
+};
+
+template <class T>
+static bool readColumn(CatalogSource& source, std::vector<T>& column, size_t count) {
+    column.resize(count);
+    return source.read(column.data(), count * sizeof(T));
+}
+
+template <class T>
+static bool writeColumn(FILE* out, const std::vector<T>& column) {
+    return column.empty() || fwrite(column.data(), sizeof(T), column.size(), out) == column.size();
+}
+
+// Append a null-terminated string and return its offset
+static int addString(BodyCatalog& catalog, const char* text) {
+    int offset = (int)catalog.strings.size();
+    catalog.strings.insert(catalog.strings.end(), text, text + strlen(text) + 1);
+    return offset;
+}
+
+// Check the invariants the renderer relies on (parents first, offsets and bands in range)
+static bool validateCatalog(const BodyCatalog& catalog, char* error, int errorSize) {
+    const int count = catalog.count();
+    const int stringBytes = (int)catalog.strings.size();
+    if (stringBytes > 0 && catalog.strings[stringBytes - 1] != '\0') {
+        snprintf(error, errorSize, "string table is not terminated");
+        return false;
+    }
+    for (int i = 0; i < count; ++i) {
+        bool ok = catalog.kind[i] <= BODY_MINOR &&
+            catalog.parent[i] >= -1 && catalog.parent[i] < i &&
+            catalog.nameOffset[i] >= 0 && catalog.nameOffset[i] < stringBytes &&
+            catalog.textureOffset[i] >= -1 && catalog.textureOffset[i] < stringBytes &&
+            catalog.bandCount[i] >= 0 && catalog.firstBand[i] >= 0 &&
+            catalog.firstBand[i] + catalog.bandCount[i] <= (int)catalog.bands.size();
+        for (int f = 0; f < CATALOG_FACTS; ++f) {
+            int offset = catalog.factOffset[i * CATALOG_FACTS + f];
+            ok = ok && offset >= -1 && offset < stringBytes;
+        }
+        if (!ok) {
+            snprintf(error, errorSize, "body %d is malformed", i);
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool readCatalogBinary(CatalogSource& source, BodyCatalog& catalog, char* error, int errorSize) {
+    CatalogHeader header;
+    if (!source.read(&header, sizeof(header)) || memcmp(header.magic, CATALOG_MAGIC, 4) != 0 ||
+        header.version != CATALOG_VERSION) {
+        snprintf(error, errorSize, "not a version %u binary catalog", CATALOG_VERSION);
+        return false;
+    }
+    // Bound the counts by the file size so a corrupt header can't demand huge allocations
+    if (source.data) {
+        size_t perBody = 1 + sizeof(int) * (5 + CATALOG_FACTS) + sizeof(double) * 9 + sizeof(float) * 2;
+        size_t needed = sizeof(header) + (size_t)header.bodyCount * perBody +
+            (size_t)header.bandCount * sizeof(RingBand) + header.stringBytes;
+        if (needed > source.size) {
+            snprintf(error, errorSize, "binary catalog is truncated");
+            return false;
+        }
+    }
+
+    const size_t n = header.bodyCount;
+    bool ok = readColumn(source, catalog.kind, n) &&
+        readColumn(source, catalog.parent, n) &&
+        readColumn(source, catalog.distance, n) &&
+        readColumn(source, catalog.orbitalPeriod, n) &&
+        readColumn(source, catalog.rotationalPeriod, n) &&
+        readColumn(source, catalog.phase, n) &&
+        readColumn(source, catalog.mass, n) &&
+        readColumn(source, catalog.eccentricity, n) &&
+        readColumn(source, catalog.inclination, n) &&
+        readColumn(source, catalog.ascendingNode, n) &&
+        readColumn(source, catalog.periapsis, n) &&
+        readColumn(source, catalog.size, n) &&
+        readColumn(source, catalog.ringTilt, n) &&
+        readColumn(source, catalog.firstBand, n) &&
+        readColumn(source, catalog.bandCount, n) &&
+        readColumn(source, catalog.nameOffset, n) &&
+        readColumn(source, catalog.textureOffset, n) &&
+        readColumn(source, catalog.factOffset, n * CATALOG_FACTS) &&
+        readColumn(source, catalog.bands, header.bandCount) &&
+        readColumn(source, catalog.strings, header.stringBytes);
+    if (!ok) {
+        snprintf(error, errorSize, "binary catalog is truncated");
+        return false;
+    }
+    return validateCatalog(catalog, error, errorSize);
+}
+
+bool loadCatalog(const char* path, BodyCatalog& catalog, char* error, int errorSize) {
+    catalog = BodyCatalog();
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        snprintf(error, errorSize, "cannot open %s", path);
+        return false;
+    }
+    char magic[4] = { 0 };
+    bool binary = fread(magic, 1, 4, file) == 4 && memcmp(magic, CATALOG_MAGIC, 4) == 0;
+    if (!binary) {
+        fclose(file);
+        return parseCatalogText(path, catalog, error, errorSize);
+    }
+
+    // Columns are copied straight out of the mapping; stream them if it can't be mapped
+    CatalogSource source = { 0, 0, 0, file };
+    MappedFile mapped;
+    bool isMapped = mapFile(path, mapped);
+    if (isMapped) {
+        source.data = mapped.data;
+        source.size = mapped.size;
+    }
+    else {
+        fseek(file, 0, SEEK_SET);
+    }
+    bool ok = readCatalogBinary(source, catalog, error, errorSize);
+    if (isMapped) unmapFile(mapped);
+    fclose(file);
+    if (!ok) catalog = BodyCatalog();
+    return ok;
+}
+
+static bool parseKind(const char* text, unsigned char& kind) {
+    static const char* names[] = { "star", "planet", "moon", "minor" };
+    for (int k = 0; k <= BODY_MINOR; ++k) {
+        if (strcmp(text, names[k]) == 0) {
+            kind = (unsigned char)k;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool parseCatalogText(const char* path, BodyCatalog& catalog, char* error, int errorSize) {
+    catalog = BodyCatalog();
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        snprintf(error, errorSize, "cannot open %s", path);
+        return false;
+    }
+
+    std::unordered_map<std::string, int> bodyIndex;  // Name lookup for parents
+    char line[1024];
+    int lineNumber = 0;
+    int ringOwner = -1;  // Body whose rings block is open
+    bool ok = true;
+    while (ok && fgets(line, sizeof(line), file)) {
+        ++lineNumber;
+        size_t length = strlen(line);
+        while (length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r')) line[--length] = '\0';
+        char* text = line;
+        while (*text == ' ' || *text == '\t') ++text;
+        if (*text == '\0' || *text == '#') continue;
+
+        char keyword[16];
+        int consumed = 0;
+        sscanf(text, "%15s%n", keyword, &consumed);
+        char* rest = text + consumed;
+        while (*rest == ' ' || *rest == '\t') ++rest;
+        const int current = catalog.count() - 1;
+
+        if (strcmp(keyword, "body") == 0) {
+            char name[64], kindName[16], parentName[64], texture[256];
+            double distance, orbitalPeriod, rotationalPeriod, phase, mass;
+            double eccentricity = 0.0, inclination = 0.0, ascendingNode = 0.0, periapsis = 0.0;
+            float size;
+            unsigned char kind;
+            int fields = sscanf(rest, "%63s %15s %63s %lf %f %lf %lf %lf %lf %255s %lf %lf %lf %lf",
+                                name, kindName, parentName, &distance, &size, &orbitalPeriod,
+                                &rotationalPeriod, &phase, &mass, texture,
+                                &eccentricity, &inclination, &ascendingNode, &periapsis);
+            if (fields != 10 && fields != 14) {
+                snprintf(error, errorSize, "%s:%d: body needs 10 fields (or 14 with orbital elements)", path, lineNumber);
+                ok = false;
+            }
+            else if (eccentricity < 0.0 || eccentricity >= 1.0) {
+                snprintf(error, errorSize, "%s:%d: eccentricity must be in [0, 1)", path, lineNumber);
+                ok = false;
+            }
+            else if (!parseKind(kindName, kind)) {
+                snprintf(error, errorSize, "%s:%d: unknown kind '%s'", path, lineNumber, kindName);
+                ok = false;
+            }
+            else if (bodyIndex.count(name)) {
+                snprintf(error, errorSize, "%s:%d: duplicate body '%s'", path, lineNumber, name);
+                ok = false;
+            }
+            else if (strcmp(parentName, "-") != 0 && !bodyIndex.count(parentName)) {
+                // Parents must be declared first so indices stay topologically ordered
+                snprintf(error, errorSize, "%s:%d: parent '%s' is not declared above", path, lineNumber, parentName);
+                ok = false;
+            }
+            else {
+                bodyIndex[name] = catalog.count();
+                catalog.kind.push_back(kind);
+                catalog.parent.push_back(strcmp(parentName, "-") == 0 ? -1 : bodyIndex[parentName]);
+                catalog.distance.push_back(distance);
+                catalog.orbitalPeriod.push_back(orbitalPeriod);
+                catalog.rotationalPeriod.push_back(rotationalPeriod);
+                catalog.phase.push_back(phase * DEG_TO_RAD);
+                catalog.mass.push_back(mass);
+                catalog.eccentricity.push_back(eccentricity);
+                catalog.inclination.push_back(inclination * DEG_TO_RAD);
+                catalog.ascendingNode.push_back(ascendingNode * DEG_TO_RAD);
+                catalog.periapsis.push_back(periapsis * DEG_TO_RAD);
+                catalog.size.push_back(size);
+                catalog.ringTilt.push_back(0.0f);
+                catalog.firstBand.push_back((int)catalog.bands.size());
+                catalog.bandCount.push_back(0);
+                catalog.nameOffset.push_back(addString(catalog, name));
+                catalog.textureOffset.push_back(strcmp(texture, "-") == 0 ? -1 : addString(catalog, texture));
+                for (int f = 0; f < CATALOG_FACTS; ++f) catalog.factOffset.push_back(-1);
+            }
+        }
+        else if (current < 0) {
+            snprintf(error, errorSize, "%s:%d: '%s' before any body", path, lineNumber, keyword);
+            ok = false;
+        }
+        else if (strcmp(keyword, "fact") == 0) {
+            int* facts = &catalog.factOffset[current * CATALOG_FACTS];
+            int slot = 0;
+            while (slot < CATALOG_FACTS && facts[slot] >= 0) ++slot;
+            if (slot == CATALOG_FACTS) {
+                snprintf(error, errorSize, "%s:%d: more than %d facts", path, lineNumber, CATALOG_FACTS);
+                ok = false;
+            }
+            else {
+                facts[slot] = addString(catalog, rest);
+            }
+        }
+        else if (strcmp(keyword, "rings") == 0) {
+            catalog.ringTilt[current] = (float)strtod(rest, 0);
+            catalog.firstBand[current] = (int)catalog.bands.size();
+            catalog.bandCount[current] = 0;
+            ringOwner = current;
+        }
+        else if (strcmp(keyword, "band") == 0) {
+            RingBand band;
+            if (sscanf(rest, "%f %f %f %f %f %f", &band.inner, &band.outer,
+                       &band.color[0], &band.color[1], &band.color[2], &band.color[3]) != 6) {
+                snprintf(error, errorSize, "%s:%d: band needs 6 fields", path, lineNumber);
+                ok = false;
+            }
+            else if (ringOwner != current) {
+                snprintf(error, errorSize, "%s:%d: band outside a rings block", path, lineNumber);
+                ok = false;
+            }
+            else {
+                catalog.bands.push_back(band);
+                catalog.bandCount[current]++;
+            }
+        }
+        else {
+            snprintf(error, errorSize, "%s:%d: unknown keyword '%s'", path, lineNumber, keyword);
+            ok = false;
+        }
+    }
+    fclose(file);
+    if (!ok) catalog = BodyCatalog();
+    return ok;
+}
+
+bool writeCatalogBinary(const char* path, const BodyCatalog& catalog) {
+    FILE* out = fopen(path, "wb");
+    if (!out) return false;
+
+    CatalogHeader header;
+    memcpy(header.magic, CATALOG_MAGIC, 4);
+    header.version = CATALOG_VERSION;
+    header.bodyCount = (uint32_t)catalog.count();
+    header.bandCount = (uint32_t)catalog.bands.size();
+    header.stringBytes = (uint32_t)catalog.strings.size();
+    header.reserved = 0;
+
+    bool ok = fwrite(&header, sizeof(header), 1, out) == 1 &&
+        writeColumn(out, catalog.kind) &&
+        writeColumn(out, catalog.parent) &&
+        writeColumn(out, catalog.distance) &&
+        writeColumn(out, catalog.orbitalPeriod) &&
+        writeColumn(out, catalog.rotationalPeriod) &&
+        writeColumn(out, catalog.phase) &&
+        writeColumn(out, catalog.mass) &&
+        writeColumn(out, catalog.eccentricity) &&
+        writeColumn(out, catalog.inclination) &&
+        writeColumn(out, catalog.ascendingNode) &&
+        writeColumn(out, catalog.periapsis) &&
+        writeColumn(out, catalog.size) &&
+        writeColumn(out, catalog.ringTilt) &&
+        writeColumn(out, catalog.firstBand) &&
+        writeColumn(out, catalog.bandCount) &&
+        writeColumn(out, catalog.nameOffset) &&
+        writeColumn(out, catalog.textureOffset) &&
+        writeColumn(out, catalog.factOffset) &&
+        writeColumn(out, catalog.bands) &&
+        writeColumn(out, catalog.strings);
+    if (fclose(out) != 0) ok = false;
+    if (!ok) remove(path);
+    return ok;
+}
@@ -0,0 +1,63 @@
+// Body catalog: the stars, planets, moons and minor bodies that make up the scene
+#pragma once
+
+#include <vector>
+#include "RingSystem.h"       // RingBand
+
+// What a catalog entry is; decides how it is simulated and drawn
+enum BodyKind {
+    BODY_STAR,    // Self-luminous; a root star at the origin is the central mass
+    BODY_PLANET,  // Selectable with the number keys
+    BODY_MOON,    // Orbits its parent body
+    BODY_MINOR    // Asteroids and comets, drawn as rocks
+};
+
+static const int CATALOG_FACTS = 3;  // Info-box lines per body
+
+// Every body in structure-of-arrays form. A parent always comes before its children,
+// so positions can be resolved in one pass in index order.
+struct BodyCatalog {
+    std::vector<unsigned char> kind;     // BodyKind
+    std::vector<int> parent;             // Index of the body orbited (-1 orbits the origin)
+    std::vector<double> distance;        // Orbit radius (semi-major axis) around the parent
+    std::vector<double> orbitalPeriod;   // Seconds per orbit (0 = fixed)
+    std::vector<double> rotationalPeriod;  // Seconds per turn (0 = no spin)
+    std::vector<double> phase;           // Mean anomaly at time 0 in radians
+    std::vector<double> mass;            // Fraction of the Sun's mass
+    std::vector<double> eccentricity;    // 0 = circular
+    std::vector<double> inclination, ascendingNode, periapsis;  // Orbit orientation in radians
+    std::vector<float> size;             // Radius
+    std::vector<float> ringTilt;         // Degrees
+    std::vector<int> firstBand, bandCount;  // Slice of bands (bandCount 0 = no rings)
+    std::vector<int> nameOffset;         // Into strings
+    std::vector<int> textureOffset;      // Into strings (-1 = untextured)
+    std::vector<int> factOffset;         // CATALOG_FACTS per body, into strings (-1 = none)
+    std::vector<RingBand> bands;         // Ring bands of every body, in body order
+    std::vector<char> strings;           // Null-terminated names, texture files and facts
+
+    int count() const { return (int)kind.size(); }
+    const char* name(int i) const { return &strings[nameOffset[i]]; }
+    const char* texture(int i) const { return textureOffset[i] < 0 ? 0 : &strings[textureOffset[i]]; }
+    const char* fact(int i, int f) const {
+        int offset = factOffset[i * CATALOG_FACTS + f];
+        return offset < 0 ? 0 : &strings[offset];
+    }
+};
+
+// Load a catalog in either format (binary files are recognized by their magic).
+// Binary catalogs are memory-mapped, or streamed when mapping fails.
+// On failure returns false and describes the problem in error.
+bool loadCatalog(const char* path, BodyCatalog& catalog, char* error, int errorSize);
+
+// Parse the text authoring format:
+//   # comment
+//   body <name> <star|planet|moon|minor> <parent|-> <distance> <size> <orbitalPeriod>
+//        <rotationalPeriod> <phaseDegrees> <massFraction> <texture|->
+//        [<eccentricity> <inclinationDeg> <ascendingNodeDeg> <periapsisDeg>]
+//   fact <text>                        (up to three per body, for the info box)
+//   rings <tiltDegrees>                (then one line per band, innermost first)
+//   band <inner> <outer> <r> <g> <b> <a>
+bool parseCatalogText(const char* path, BodyCatalog& catalog, char* error, int errorSize);
+
+// Write the compact binary format (a header and one packed column per field)
+bool writeCatalogBinary(const char* path, const BodyCatalog& catalog);
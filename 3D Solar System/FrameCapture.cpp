@@ -0,0 +1,413 @@
+// Asynchronous frame capture: a ring of pixel buffers for readback and a background encoder
+#include "FrameCapture.h"
+#include "GLExtensions.h"     // Pixel buffer objects
+#include <stdio.h>            // Output files
+#include <string.h>           // memcpy, strchr, strrchr
+#include <stdint.h>           // CRC and checksum words
+#include <chrono>             // Render- and encoder-side timings
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+static const int READBACK_RING = 3;  // Frame N is collected once N+1 and N+2 have been drawn
+static const int QUEUE_SLOTS = 4;    // Frames waiting for the encoder before rendering has to wait
+
+enum CaptureFormat {
+    FORMAT_Y4M,  // One stream, YUV 4:2:0 (full-range BT.601, as in JPEG)
+    FORMAT_PNG,  // One file per frame, uncompressed deflate blocks
+    FORMAT_PPM   // One file per frame, binary RGB
+};
+
+// One frame's BGRA pixels as GL returns them (bottom row first)
+struct QueuedFrame {
+    std::vector<unsigned char> pixels;
+    int index;
+};
+
+static bool capturing = false;
+static CaptureFormat format = FORMAT_Y4M;
+static char pathPattern[512];
+static FILE* stream = 0;         // Y4M output (image sequences open a file per frame)
+static int frameWidth = 0, frameHeight = 0;
+static size_t frameBytes = 0;
+
+// Readback ring (frames go straight into a queue slot when pixel buffers are unavailable)
+static bool usePixelBuffers = false;
+static GLuint pixelBuffers[READBACK_RING];
+static int issued = 0;     // Frames whose readback has started
+static int collected = 0;  // Frames copied out to the encoder queue
+
+// Bounded queue between the render thread and the encoder
+static QueuedFrame slots[QUEUE_SLOTS];
+static std::deque<int> freeSlots, filledSlots;
+static std::mutex queueLock;
+static std::condition_variable queueChanged;
+static std::thread encoder;
+static bool encoderStop = false;
+
+// Totals for CaptureStats (the encoder's under queueLock)
+static int stalls = 0, written = 0;
+static double readSeconds = 0.0, encodeSeconds = 0.0;
+static bool writeFailed = false;
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Row y of the image (counted from the top) as RGB
+static void toRGBRow(const unsigned char* bgra, int y, unsigned char* rgb) {
+    const unsigned char* src = bgra + (size_t)(frameHeight - 1 - y) * frameWidth * 4;
+    for (int x = 0; x < frameWidth; ++x, src += 4, rgb += 3) {
+        rgb[0] = src[2];
+        rgb[1] = src[1];
+        rgb[2] = src[0];
+    }
+}
+
+static bool writePPM(const char* path, const unsigned char* bgra, std::vector<unsigned char>& scratch) {
+    const size_t rowBytes = (size_t)frameWidth * 3;
+    scratch.resize(rowBytes * frameHeight);
+    for (int y = 0; y < frameHeight; ++y) toRGBRow(bgra, y, &scratch[y * rowBytes]);
+    FILE* out = fopen(path, "wb");
+    if (!out) return false;
+    fprintf(out, "P6\n%d %d\n255\n", frameWidth, frameHeight);
+    bool ok = fwrite(scratch.data(), 1, scratch.size(), out) == scratch.size();
+    return fclose(out) == 0 && ok;
+}
+
+static uint32_t crcTable[4][256];  // Slicing-by-4: four bytes per step
+
+static void buildCrcTable() {
+    for (uint32_t n = 0; n < 256; ++n) {
+        uint32_t c = n;
+        for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        crcTable[0][n] = c;
+    }
+    for (uint32_t n = 0; n < 256; ++n)
+        for (int t = 1; t < 4; ++t)
+            crcTable[t][n] = crcTable[0][crcTable[t - 1][n] & 0xFF] ^ (crcTable[t - 1][n] >> 8);
+}
+
+static uint32_t updateCrc(uint32_t crc, const unsigned char* data, size_t length) {
+    size_t i = 0;
+    for (; i + 4 <= length; i += 4) {
+        crc ^= (uint32_t)data[i] | ((uint32_t)data[i + 1] << 8) | ((uint32_t)data[i + 2] << 16) | ((uint32_t)data[i + 3] << 24);
+        crc = crcTable[3][crc & 0xFF] ^ crcTable[2][(crc >> 8) & 0xFF] ^
+              crcTable[1][(crc >> 16) & 0xFF] ^ crcTable[0][crc >> 24];
+    }
+    for (; i < length; ++i) crc = crcTable[0][(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return crc;
+}
+
+static void storeBigEndian(unsigned char* out, uint32_t v) {
+    out[0] = (unsigned char)(v >> 24);
+    out[1] = (unsigned char)(v >> 16);
+    out[2] = (unsigned char)(v >> 8);
+    out[3] = (unsigned char)v;
+}
+
+// Write bytes that belong to a chunk, folding them into its running CRC
+static bool putChunkBytes(FILE* out, uint32_t& crc, const unsigned char* data, size_t length) {
+    crc = updateCrc(crc, data, length);
+    return fwrite(data, 1, length, out) == length;
+}
+
+// Start a chunk: length (not covered by the CRC) and type
+static bool beginChunk(FILE* out, uint32_t& crc, const char* type, size_t length) {
+    unsigned char size[4];
+    storeBigEndian(size, (uint32_t)length);
+    crc = 0xFFFFFFFFu;
+    return fwrite(size, 1, 4, out) == 4 && putChunkBytes(out, crc, (const unsigned char*)type, 4);
+}
+
+static bool endChunk(FILE* out, uint32_t crc) {
+    unsigned char tail[4];
+    storeBigEndian(tail, crc ^ 0xFFFFFFFFu);
+    return fwrite(tail, 1, 4, out) == 4;
+}
+
+// RGB PNG whose zlib stream holds stored (uncompressed) blocks: no compression cost on the encoder,
+// at about the size of a PPM. Recompress offline if the files need to be small.
+static bool writePNG(const char* path, const unsigned char* bgra, std::vector<unsigned char>& scratch) {
+    const size_t rowBytes = (size_t)frameWidth * 3;
+    const size_t rawBytes = (rowBytes + 1) * frameHeight;  // Each row starts with filter type 0 (none)
+    const size_t blocks = (rawBytes + 65534) / 65535;
+    scratch.resize(rawBytes);
+    for (int y = 0; y < frameHeight; ++y) {
+        unsigned char* row = &scratch[y * (rowBytes + 1)];
+        row[0] = 0;
+        toRGBRow(bgra, y, row + 1);
+    }
+    uint32_t a = 1, b = 0;  // Adler-32, reduced every 5552 bytes so the sums can't overflow
+    for (size_t at = 0; at < rawBytes; ) {
+        size_t run = rawBytes - at < 5552 ? rawBytes - at : 5552;
+        for (size_t i = 0; i < run; ++i) {
+            a += scratch[at + i];
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+        at += run;
+    }
+
+    FILE* out = fopen(path, "wb");
+    if (!out) return false;
+    static const unsigned char signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    unsigned char header[13] = { 0 };
+    storeBigEndian(header, (uint32_t)frameWidth);
+    storeBigEndian(header + 4, (uint32_t)frameHeight);
+    header[8] = 8;  // Bits per channel
+    header[9] = 2;  // Truecolor
+    uint32_t crc;
+    bool ok = fwrite(signature, 1, 8, out) == 8 &&
+        beginChunk(out, crc, "IHDR", sizeof(header)) && putChunkBytes(out, crc, header, sizeof(header)) &&
+        endChunk(out, crc);
+
+    // IDAT: zlib header, stored blocks of up to 65535 bytes, Adler-32
+    static const unsigned char zlibHeader[2] = { 0x78, 0x01 };
+    ok = ok && beginChunk(out, crc, "IDAT", 2 + blocks * 5 + rawBytes + 4) &&
+        putChunkBytes(out, crc, zlibHeader, 2);
+    for (size_t at = 0; ok && at < rawBytes; at += 65535) {
+        size_t length = rawBytes - at < 65535 ? rawBytes - at : 65535;
+        unsigned char block[5] = {
+            (unsigned char)(at + length == rawBytes ? 1 : 0),  // Final-block flag, type 0 (stored)
+            (unsigned char)length, (unsigned char)(length >> 8),
+            (unsigned char)~length, (unsigned char)(~length >> 8)
+        };
+        ok = putChunkBytes(out, crc, block, 5) && putChunkBytes(out, crc, &scratch[at], length);
+    }
+    unsigned char adler[4];
+    storeBigEndian(adler, (b << 16) | a);
+    ok = ok && putChunkBytes(out, crc, adler, 4) && endChunk(out, crc);
+    ok = ok && beginChunk(out, crc, "IEND", 0) && endChunk(out, crc);
+    return fclose(out) == 0 && ok;
+}
+
+// One Y4M frame: full-resolution luma, then each chroma plane averaged over 2x2 pixels.
+// Rows are converted in pairs so every pixel is read once for both.
+static bool writeY4MFrame(const unsigned char* bgra, std::vector<unsigned char>& scratch) {
+    const int chromaWidth = (frameWidth + 1) / 2, chromaHeight = (frameHeight + 1) / 2;
+    const size_t lumaBytes = (size_t)frameWidth * frameHeight;
+    const size_t chromaBytes = (size_t)chromaWidth * chromaHeight;
+    scratch.resize(lumaBytes + 2 * chromaBytes);
+    unsigned char* luma = scratch.data();
+    unsigned char* cb = luma + lumaBytes;
+    unsigned char* cr = cb + chromaBytes;
+    const size_t stride = (size_t)frameWidth * 4;
+
+    for (int cy = 0; cy < chromaHeight; ++cy) {
+        const int y0 = 2 * cy, y1 = (y0 + 1 < frameHeight) ? y0 + 1 : y0;  // Odd heights repeat the last row
+        const unsigned char* row0 = bgra + (frameHeight - 1 - y0) * stride;
+        const unsigned char* row1 = bgra + (frameHeight - 1 - y1) * stride;
+        unsigned char* luma0 = luma + (size_t)y0 * frameWidth;
+        unsigned char* luma1 = luma + (size_t)y1 * frameWidth;
+        for (int cx = 0; cx < chromaWidth; ++cx) {
+            const int x0 = 2 * cx, x1 = (x0 + 1 < frameWidth) ? x0 + 1 : x0;
+            const unsigned char* p[4] = { row0 + x0 * 4, row0 + x1 * 4, row1 + x0 * 4, row1 + x1 * 4 };
+            luma0[x0] = (unsigned char)((77 * p[0][2] + 150 * p[0][1] + 29 * p[0][0] + 128) >> 8);
+            luma0[x1] = (unsigned char)((77 * p[1][2] + 150 * p[1][1] + 29 * p[1][0] + 128) >> 8);
+            luma1[x0] = (unsigned char)((77 * p[2][2] + 150 * p[2][1] + 29 * p[2][0] + 128) >> 8);
+            luma1[x1] = (unsigned char)((77 * p[3][2] + 150 * p[3][1] + 29 * p[3][0] + 128) >> 8);
+            int b = p[0][0] + p[1][0] + p[2][0] + p[3][0];
+            int g = p[0][1] + p[1][1] + p[2][1] + p[3][1];
+            int r = p[0][2] + p[1][2] + p[2][2] + p[3][2];
+            // Sums of four pixels, so shift by 10 instead of 8; the offset keeps them positive
+            cb[(size_t)cy * chromaWidth + cx] = (unsigned char)((-43 * r - 85 * g + 128 * b + (128 << 10) + 512) >> 10);
+            cr[(size_t)cy * chromaWidth + cx] = (unsigned char)((128 * r - 107 * g - 21 * b + (128 << 10) + 512) >> 10);
+        }
+    }
+    bool ok = fputs("FRAME\n", stream) >= 0;
+    return fwrite(scratch.data(), 1, scratch.size(), stream) == scratch.size() && ok;
+}
+
+static bool encodeFrame(const QueuedFrame& frame, std::vector<unsigned char>& scratch) {
+    if (format == FORMAT_Y4M) return writeY4MFrame(frame.pixels.data(), scratch);
+    char path[600];
+    snprintf(path, sizeof(path), pathPattern, frame.index);
+    if (format == FORMAT_PNG) return writePNG(path, frame.pixels.data(), scratch);
+    return writePPM(path, frame.pixels.data(), scratch);
+}
+
+// Encoder thread: frames in order until stopped and drained
+static void encoderLoop() {
+    std::vector<unsigned char> scratch;  // Converted frame, reused
+    for (;;) {
+        int slot;
+        {
+            std::unique_lock<std::mutex> guard(queueLock);
+            queueChanged.wait(guard, [] { return !filledSlots.empty() || encoderStop; });
+            if (filledSlots.empty()) return;
+            slot = filledSlots.front();
+            filledSlots.pop_front();
+        }
+        auto start = std::chrono::steady_clock::now();
+        bool ok = encodeFrame(slots[slot], scratch);
+        double seconds = secondsSince(start);
+        {
+            std::lock_guard<std::mutex> guard(queueLock);
+            freeSlots.push_back(slot);
+            ++written;
+            encodeSeconds += seconds;
+            if (!ok && !writeFailed) {
+                writeFailed = true;
+                printf("Capture: could not write frame %d\n", slots[slot].index);
+            }
+        }
+        queueChanged.notify_all();
+    }
+}
+
+// Take a free queue slot, waiting for the encoder if all are full
+static int acquireSlot() {
+    std::unique_lock<std::mutex> guard(queueLock);
+    if (freeSlots.empty()) {
+        ++stalls;
+        queueChanged.wait(guard, [] { return !freeSlots.empty(); });
+    }
+    int slot = freeSlots.front();
+    freeSlots.pop_front();
+    return slot;
+}
+
+static void submitSlot(int slot, int index) {
+    {
+        std::lock_guard<std::mutex> guard(queueLock);
+        slots[slot].index = index;
+        filledSlots.push_back(slot);
+    }
+    queueChanged.notify_all();
+}
+
+// Copy the oldest frame in the readback ring out to the encoder. A frame that can't be mapped
+// (say the context is already gone) is dropped rather than encoded as black.
+static void collectOldest() {
+    int slot = acquireSlot();
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, pixelBuffers[collected % READBACK_RING]);
+    const void* mapped = glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+    if (mapped) {
+        memcpy(slots[slot].pixels.data(), mapped, frameBytes);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    if (mapped) {
+        submitSlot(slot, collected++);
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> guard(queueLock);
+        freeSlots.push_back(slot);
+    }
+    ++collected;
+}
+
+bool startCapture(const char* path, int width, int height, int fps) {
+    if (capturing) stopCapture();
+    const char* extension = strrchr(path, '.');
+    if (extension && (strcmp(extension, ".y4m") == 0 || strcmp(extension, ".Y4M") == 0)) format = FORMAT_Y4M;
+    else if (extension && (strcmp(extension, ".png") == 0 || strcmp(extension, ".PNG") == 0)) format = FORMAT_PNG;
+    else if (extension && (strcmp(extension, ".ppm") == 0 || strcmp(extension, ".PPM") == 0)) format = FORMAT_PPM;
+    else {
+        printf("Capture: %s should end in .y4m, .png or .ppm\n", path);
+        return false;
+    }
+    if (format != FORMAT_Y4M && !strchr(path, '%')) {
+        printf("Capture: %s needs a frame number pattern, e.g. frame%%05d%s\n", path, extension);
+        return false;
+    }
+    snprintf(pathPattern, sizeof(pathPattern), "%s", path);
+    frameWidth = width;
+    frameHeight = height;
+    frameBytes = (size_t)width * height * 4;
+
+    if (format == FORMAT_Y4M) {
+        stream = fopen(path, "wb");
+        if (!stream) {
+            printf("Capture: could not create %s\n", path);
+            return false;
+        }
+        // C420jpeg only sets chroma siting; the range has to be stated or players assume 16-235
+        fprintf(stream, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg XCOLORRANGE=FULL\n", width, height, fps);
+    }
+    buildCrcTable();
+
+    usePixelBuffers = hasPixelBuffers;
+    if (usePixelBuffers) {
+        glGenBuffers(READBACK_RING, pixelBuffers);
+        for (int i = 0; i < READBACK_RING; ++i) {
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, pixelBuffers[i]);
+            glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr)frameBytes, 0, GL_STREAM_READ);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+    freeSlots.clear();
+    filledSlots.clear();
+    for (int i = 0; i < QUEUE_SLOTS; ++i) {
+        slots[i].pixels.resize(frameBytes);
+        freeSlots.push_back(i);
+    }
+    issued = collected = stalls = written = 0;
+    readSeconds = encodeSeconds = 0.0;
+    writeFailed = false;
+    encoderStop = false;
+    encoder = std::thread(encoderLoop);
+    capturing = true;
+    printf("Capturing %dx%d to %s (%s readback)\n", width, height, path,
+           usePixelBuffers ? "asynchronous" : "synchronous");
+    return true;
+}
+
+bool isCapturing() {
+    return capturing;
+}
+
+void captureFrame() {
+    if (!capturing) return;
+    auto start = std::chrono::steady_clock::now();
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);  // BGRA rows are always 4-byte aligned
+    if (usePixelBuffers) {
+        // Reuse the oldest buffer: its readback had two frames of rendering to finish in
+        if (issued - collected == READBACK_RING) collectOldest();
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, pixelBuffers[issued % READBACK_RING]);
+        glReadPixels(0, 0, frameWidth, frameHeight, GL_BGRA, GL_UNSIGNED_BYTE, 0);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        ++issued;
+    }
+    else {
+        int slot = acquireSlot();
+        glReadPixels(0, 0, frameWidth, frameHeight, GL_BGRA, GL_UNSIGNED_BYTE, slots[slot].pixels.data());
+        submitSlot(slot, issued++);
+        ++collected;
+    }
+    readSeconds += secondsSince(start);
+}
+
+void stopCapture() {
+    if (!capturing) return;
+    auto start = std::chrono::steady_clock::now();
+    while (collected < issued) collectOldest();
+    readSeconds += secondsSince(start);
+    {
+        std::lock_guard<std::mutex> guard(queueLock);
+        encoderStop = true;
+    }
+    queueChanged.notify_all();
+    encoder.join();
+    if (usePixelBuffers) glDeleteBuffers(READBACK_RING, pixelBuffers);
+    if (stream) {
+        if (fclose(stream) != 0) writeFailed = true;
+        stream = 0;
+    }
+    for (int i = 0; i < QUEUE_SLOTS; ++i) std::vector<unsigned char>().swap(slots[i].pixels);
+    capturing = false;
+}
+
+void getCaptureStats(CaptureStats& stats) {
+    std::lock_guard<std::mutex> guard(queueLock);
+    stats.frames = issued;
+    stats.written = written;
+    stats.stalls = stalls;
+    stats.readMs = issued > 0 ? readSeconds * 1000.0 / issued : 0.0;
+    stats.encodeMs = written > 0 ? encodeSeconds * 1000.0 / written : 0.0;
+}
@@ -0,0 +1,27 @@
+// Asynchronous frame capture: a ring of pixel buffers for readback and a background encoder
+#pragma once
+
+// Running totals since startCapture()
+struct CaptureStats {
+    int frames;       // Frames handed to captureFrame()
+    int written;      // Frames the encoder has finished
+    int stalls;       // Times rendering had to wait for a free queue slot
+    double readMs;    // Mean render-thread cost per frame (readback and copy-out)
+    double encodeMs;  // Mean encoder-thread cost per frame (conversion and writing)
+};
+
+// Capture width x height frames to path. The extension picks the format:
+//   .y4m            one raw YUV 4:2:0 stream at fps frames per second
+//   .png / .ppm     one image per frame, path being a printf pattern such as shots/frame%05d.png
+// Needs the GL context with extensions loaded. Prints the reason and returns false on failure.
+bool startCapture(const char* path, int width, int height, int fps);
+bool isCapturing();
+
+// Queue the frame in the current read buffer; call after drawing and before the swap.
+// The pixels are collected two frames later, so the GPU is never waited on.
+void captureFrame();
+
+// Collect the frames still in flight, let the encoder finish and close the output
+void stopCapture();
+
+void getCaptureStats(CaptureStats& stats);
@@ -0,0 +1,113 @@
+// Frame pacing for the interactive window
+#include "FramePacer.h"
+#include "GLExtensions.h"     // setSwapInterval
+#include <chrono>             // High-resolution frame clock
+#include <algorithm>          // min
+
+#ifdef _WIN32
+#include <windows.h>
+#include <mmsystem.h>         // timeBeginPeriod: 1 ms timer waits instead of the 15.6 ms default
+#pragma comment(lib, "winmm.lib")
+#endif
+
+static const int HISTORY = 240;  // Frames in the rolling statistics window (matches the profiler)
+
+static const std::chrono::steady_clock::time_point paceEpoch = std::chrono::steady_clock::now();
+static PaceMode mode = PACE_UNCAPPED;
+static double targetFps = 60.0;
+static double lastFrameStart = -1.0;  // Seconds since paceEpoch (-1 before the first frame)
+static double lastInterval = 0.0;
+static double nextDeadline = -1.0;    // When the next PACE_TARGET frame is due (-1 = start a new schedule)
+static double pendingInput = -1.0;    // Oldest input not yet picked up by a frame
+static double frameInput = -1.0;      // Input shown by the frame in progress
+
+// Rings of recent samples in milliseconds (counts keep growing; the newest is at (count - 1) % HISTORY)
+static double intervals[HISTORY];
+static double latencies[HISTORY];
+static int intervalCount = 0, latencyCount = 0;
+
+static double nowSeconds() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - paceEpoch).count();
+}
+
+PaceMode setPaceMode(PaceMode newMode, double fps) {
+    if (fps > 0.0) targetFps = fps;
+    if (newMode == PACE_VSYNC && !setSwapInterval(1)) newMode = PACE_TARGET;  // No swap control: hold the rate ourselves
+    else if (newMode != PACE_VSYNC) setSwapInterval(0);
+#ifdef _WIN32
+    static bool fineTimer = false;
+    if (newMode == PACE_TARGET && !fineTimer) fineTimer = timeBeginPeriod(1) == TIMERR_NOERROR;
+#endif
+    mode = newMode;
+    nextDeadline = -1.0;
+    intervalCount = latencyCount = 0;  // Statistics describe one mode at a time
+    return mode;
+}
+
+PaceMode getPaceMode() {
+    return mode;
+}
+
+double getTargetFps() {
+    return targetFps;
+}
+
+const char* paceModeName(PaceMode m) {
+    switch (m) {
+    case PACE_UNCAPPED: return "uncapped";
+    case PACE_VSYNC:    return "vsync";
+    default:            return "target";
+    }
+}
+
+double beginPacedFrame() {
+    double now = nowSeconds();
+    double elapsed = (lastFrameStart < 0.0) ? 0.0 : now - lastFrameStart;
+    if (lastFrameStart >= 0.0) {
+        lastInterval = elapsed;
+        intervals[intervalCount++ % HISTORY] = elapsed * 1000.0;
+    }
+    lastFrameStart = now;
+
+    // This frame is the first to see any input that arrived since the last one started
+    if (frameInput < 0.0 && pendingInput >= 0.0) {
+        frameInput = pendingInput;
+        pendingInput = -1.0;
+    }
+    return elapsed;
+}
+
+void endPacedFrame() {
+    if (frameInput < 0.0) return;
+    // The swap has returned, so the frame is on its way out. With vsync, scan-out then takes one
+    // refresh, so add half of one to reach the middle of the screen.
+    double presented = nowSeconds() + (mode == PACE_VSYNC ? 0.5 * lastInterval : 0.0);
+    latencies[latencyCount++ % HISTORY] = (presented - frameInput) * 1000.0;
+    frameInput = -1.0;
+}
+
+int millisecondsUntilNextFrame() {
+    const double period = 1.0 / targetFps;
+    double now = nowSeconds();
+    // A new schedule on the first frame, or after falling more than a frame behind (skip, don't catch up)
+    if (nextDeadline < 0.0 || now - nextDeadline > period) nextDeadline = now;
+    nextDeadline += period;
+    double wait = nextDeadline - now;
+    return wait > 0.0 ? (int)(wait * 1000.0) : 0;
+}
+
+void notePacedInput() {
+    if (pendingInput < 0.0) pendingInput = nowSeconds();  // The oldest event of a burst waits longest
+}
+
+void getPacingStats(PacingStats& stats) {
+    double samples[HISTORY];
+    int count = std::min(intervalCount, HISTORY);
+    std::copy(intervals, intervals + count, samples);
+    summarizeSamples(samples, count, stats.frame);
+    stats.fps = (stats.frame.mean > 0.0) ? 1000.0 / stats.frame.mean : 0.0;
+
+    count = std::min(latencyCount, HISTORY);
+    std::copy(latencies, latencies + count, samples);
+    summarizeSamples(samples, count, stats.latency);
+}
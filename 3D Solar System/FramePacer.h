@@ -0,0 +1,40 @@
+// Frame pacing for the interactive window: real frame times from a high-resolution clock,
+// uncapped / vsync / fixed-rate modes, and input-to-photon latency estimates
+#pragma once
+
+#include "Profiler.h"         // PhaseStats
+
+// How the next frame is scheduled
+enum PaceMode {
+    PACE_UNCAPPED,  // Redraw as soon as the last frame is done (swap interval 0)
+    PACE_VSYNC,     // Swap interval 1: the display's refresh holds the loop
+    PACE_TARGET     // Wait for each frame's deadline at a fixed rate
+};
+
+// Rolling statistics over recent frames, in milliseconds
+struct PacingStats {
+    double fps;          // Frames per second over the window
+    PhaseStats frame;    // Time from one frame start to the next
+    PhaseStats latency;  // Input event to the frame that shows it reaching the screen (estimate)
+};
+
+// Switch modes (targetFps is used by PACE_TARGET). Needs the window's GL context for the swap interval.
+// Returns the mode in effect: vsync falls back to PACE_TARGET when the swap interval can't be set.
+PaceMode setPaceMode(PaceMode mode, double targetFps);
+PaceMode getPaceMode();
+double getTargetFps();
+const char* paceModeName(PaceMode mode);
+
+// Bracket every displayed frame: begin returns real seconds since the previous frame began,
+// end (after the buffer swap) closes the latency measurement of any input this frame shows
+double beginPacedFrame();
+void endPacedFrame();
+
+// Milliseconds to wait before the next frame in PACE_TARGET mode. Deadlines are absolute,
+// so early or late wake-ups don't accumulate drift; frames that fall behind are skipped.
+int millisecondsUntilNextFrame();
+
+// Record that input arrived now; the next frame to start is measured until it is presented
+void notePacedInput();
+
+void getPacingStats(PacingStats& stats);
@@ -0,0 +1,252 @@
+// Runtime loader for OpenGL entry points newer than the 1.1 headers shipped with Windows
+#ifdef _WIN32
+#include <windows.h>          // wglGetProcAddress
+#else
+#include <GL/glx.h>           // glXGetProcAddressARB
+#endif
+#include "GLExtensions.h"
+#include <stdio.h>            // Shader error output
+#include <string.h>           // strstr
+
+PFN_GENBUFFERS    glGenBuffers = 0;
+PFN_DELETEBUFFERS glDeleteBuffers = 0;
+PFN_BINDBUFFER    glBindBuffer = 0;
+PFN_BUFFERDATA    glBufferData = 0;
+PFN_BUFFERSUBDATA glBufferSubData = 0;
+PFN_MAPBUFFER     glMapBuffer = 0;
+PFN_UNMAPBUFFER   glUnmapBuffer = 0;
+PFN_MULTIDRAWELEMENTS glMultiDrawElements = 0;
+PFN_CREATESHADER  glCreateShader = 0;
+PFN_DELETESHADER  glDeleteShader = 0;
+PFN_SHADERSOURCE  glShaderSource = 0;
+PFN_COMPILESHADER glCompileShader = 0;
+PFN_GETSHADERIV   glGetShaderiv = 0;
+PFN_GETSHADERINFOLOG glGetShaderInfoLog = 0;
+PFN_CREATEPROGRAM glCreateProgram = 0;
+PFN_DELETEPROGRAM glDeleteProgram = 0;
+PFN_ATTACHSHADER  glAttachShader = 0;
+PFN_BINDATTRIBLOCATION glBindAttribLocation = 0;
+PFN_LINKPROGRAM   glLinkProgram = 0;
+PFN_GETPROGRAMIV  glGetProgramiv = 0;
+PFN_GETPROGRAMINFOLOG glGetProgramInfoLog = 0;
+PFN_USEPROGRAM    glUseProgram = 0;
+PFN_GETUNIFORMLOCATION glGetUniformLocation = 0;
+PFN_UNIFORM1F     glUniform1f = 0;
+PFN_UNIFORM1I     glUniform1i = 0;
+PFN_UNIFORM4F     glUniform4f = 0;
+PFN_UNIFORM1FV    glUniform1fv = 0;
+PFN_VERTEXATTRIBPOINTER glVertexAttribPointer = 0;
+PFN_ENABLEVERTEXATTRIBARRAY glEnableVertexAttribArray = 0;
+PFN_DISABLEVERTEXATTRIBARRAY glDisableVertexAttribArray = 0;
+PFN_ACTIVETEXTURE glActiveTexture = 0;
+PFN_GENFRAMEBUFFERS glGenFramebuffers = 0;
+PFN_DELETEFRAMEBUFFERS glDeleteFramebuffers = 0;
+PFN_BINDFRAMEBUFFER glBindFramebuffer = 0;
+PFN_CHECKFRAMEBUFFERSTATUS glCheckFramebufferStatus = 0;
+PFN_GENRENDERBUFFERS glGenRenderbuffers = 0;
+PFN_DELETERENDERBUFFERS glDeleteRenderbuffers = 0;
+PFN_BINDRENDERBUFFER glBindRenderbuffer = 0;
+PFN_RENDERBUFFERSTORAGE glRenderbufferStorage = 0;
+PFN_FRAMEBUFFERRENDERBUFFER glFramebufferRenderbuffer = 0;
+PFN_GENQUERIES    glGenQueries = 0;
+PFN_DELETEQUERIES glDeleteQueries = 0;
+PFN_QUERYCOUNTER  glQueryCounter = 0;
+PFN_GETQUERYOBJECTIV glGetQueryObjectiv = 0;
+PFN_GETQUERYOBJECTUI64V glGetQueryObjectui64v = 0;
+PFN_DRAWELEMENTSINSTANCED glDrawElementsInstanced = 0;
+PFN_VERTEXATTRIBDIVISOR glVertexAttribDivisor = 0;
+
+bool hasVertexBuffers = false;
+bool hasShaders = false;
+bool hasFramebuffers = false;
+bool hasTimerQueries = false;
+bool hasInstancing = false;
+bool hasPixelBuffers = false;
+
+static GLProcResolver procResolver = 0;  // Set by loadGLExtensions() for non-window-system contexts
+
+// Look up a GL function by name in the current context
+static void* getProc(const char* name) {
+    if (procResolver) return procResolver(name);
+#ifdef _WIN32
+    return (void*)wglGetProcAddress(name);
+#else
+    return (void*)glXGetProcAddressARB((const GLubyte*)name);
+#endif
+}
+
+// Try the core name first, then the ARB extension name
+static void* getProcARB(const char* core, const char* arb) {
+    void* proc = getProc(core);
+    return proc ? proc : getProc(arb);
+}
+
+// Features without entry points of their own are found by version or extension name
+static bool versionAtLeast(int major, int minor) {
+    const char* version = (const char*)glGetString(GL_VERSION);
+    int haveMajor = 0, haveMinor = 0;
+    if (!version || sscanf(version, "%d.%d", &haveMajor, &haveMinor) != 2) return false;
+    return haveMajor > major || (haveMajor == major && haveMinor >= minor);
+}
+
+static bool hasExtension(const char* name) {
+    const char* extensions = (const char*)glGetString(GL_EXTENSIONS);
+    return extensions && strstr(extensions, name);
+}
+
+void loadGLExtensions(GLProcResolver resolver) {
+    procResolver = resolver;
+    glGenBuffers = (PFN_GENBUFFERS)getProcARB("glGenBuffers", "glGenBuffersARB");
+    glDeleteBuffers = (PFN_DELETEBUFFERS)getProcARB("glDeleteBuffers", "glDeleteBuffersARB");
+    glBindBuffer = (PFN_BINDBUFFER)getProcARB("glBindBuffer", "glBindBufferARB");
+    glBufferData = (PFN_BUFFERDATA)getProcARB("glBufferData", "glBufferDataARB");
+    glBufferSubData = (PFN_BUFFERSUBDATA)getProcARB("glBufferSubData", "glBufferSubDataARB");
+    // GLX returns a stub for any name, so a feature also needs the version or extension behind it
+    hasVertexBuffers = glGenBuffers && glDeleteBuffers && glBindBuffer && glBufferData && glBufferSubData &&
+        (versionAtLeast(1, 5) || hasExtension("GL_ARB_vertex_buffer_object"));
+
+    // Pixel buffers reuse the buffer entry points plus mapping
+    glMapBuffer = (PFN_MAPBUFFER)getProcARB("glMapBuffer", "glMapBufferARB");
+    glUnmapBuffer = (PFN_UNMAPBUFFER)getProcARB("glUnmapBuffer", "glUnmapBufferARB");
+    hasPixelBuffers = hasVertexBuffers && glMapBuffer && glUnmapBuffer &&
+        (versionAtLeast(2, 1) || hasExtension("GL_ARB_pixel_buffer_object") || hasExtension("GL_EXT_pixel_buffer_object"));
+
+    glMultiDrawElements = (PFN_MULTIDRAWELEMENTS)getProcARB("glMultiDrawElements", "glMultiDrawElementsEXT");
+    if (!versionAtLeast(1, 4) && !hasExtension("GL_EXT_multi_draw_arrays")) glMultiDrawElements = 0;
+
+    glCreateShader = (PFN_CREATESHADER)getProc("glCreateShader");
+    glDeleteShader = (PFN_DELETESHADER)getProc("glDeleteShader");
+    glShaderSource = (PFN_SHADERSOURCE)getProc("glShaderSource");
+    glCompileShader = (PFN_COMPILESHADER)getProc("glCompileShader");
+    glGetShaderiv = (PFN_GETSHADERIV)getProc("glGetShaderiv");
+    glGetShaderInfoLog = (PFN_GETSHADERINFOLOG)getProc("glGetShaderInfoLog");
+    glCreateProgram = (PFN_CREATEPROGRAM)getProc("glCreateProgram");
+    glDeleteProgram = (PFN_DELETEPROGRAM)getProc("glDeleteProgram");
+    glAttachShader = (PFN_ATTACHSHADER)getProc("glAttachShader");
+    glBindAttribLocation = (PFN_BINDATTRIBLOCATION)getProc("glBindAttribLocation");
+    glLinkProgram = (PFN_LINKPROGRAM)getProc("glLinkProgram");
+    glGetProgramiv = (PFN_GETPROGRAMIV)getProc("glGetProgramiv");
+    glGetProgramInfoLog = (PFN_GETPROGRAMINFOLOG)getProc("glGetProgramInfoLog");
+    glUseProgram = (PFN_USEPROGRAM)getProc("glUseProgram");
+    glGetUniformLocation = (PFN_GETUNIFORMLOCATION)getProc("glGetUniformLocation");
+    glUniform1f = (PFN_UNIFORM1F)getProc("glUniform1f");
+    glUniform1i = (PFN_UNIFORM1I)getProc("glUniform1i");
+    glVertexAttribPointer = (PFN_VERTEXATTRIBPOINTER)getProc("glVertexAttribPointer");
+    glEnableVertexAttribArray = (PFN_ENABLEVERTEXATTRIBARRAY)getProc("glEnableVertexAttribArray");
+    glDisableVertexAttribArray = (PFN_DISABLEVERTEXATTRIBARRAY)getProc("glDisableVertexAttribArray");
+    hasShaders = glCreateShader && glDeleteShader && glShaderSource && glCompileShader &&
+        glGetShaderiv && glGetShaderInfoLog && glCreateProgram && glDeleteProgram &&
+        glAttachShader && glBindAttribLocation && glLinkProgram && glGetProgramiv &&
+        glGetProgramInfoLog && glUseProgram && glGetUniformLocation && glUniform1f &&
+        glUniform1i && glVertexAttribPointer && glEnableVertexAttribArray && glDisableVertexAttribArray &&
+        versionAtLeast(2, 0);
+    glUniform4f = (PFN_UNIFORM4F)getProc("glUniform4f");
+    glUniform1fv = (PFN_UNIFORM1FV)getProc("glUniform1fv");
+
+    glActiveTexture = (PFN_ACTIVETEXTURE)getProcARB("glActiveTexture", "glActiveTextureARB");
+
+    // The EXT entry points take the same arguments and enum values
+    glGenFramebuffers = (PFN_GENFRAMEBUFFERS)getProcARB("glGenFramebuffers", "glGenFramebuffersEXT");
+    glDeleteFramebuffers = (PFN_DELETEFRAMEBUFFERS)getProcARB("glDeleteFramebuffers", "glDeleteFramebuffersEXT");
+    glBindFramebuffer = (PFN_BINDFRAMEBUFFER)getProcARB("glBindFramebuffer", "glBindFramebufferEXT");
+    glCheckFramebufferStatus = (PFN_CHECKFRAMEBUFFERSTATUS)getProcARB("glCheckFramebufferStatus", "glCheckFramebufferStatusEXT");
+    glGenRenderbuffers = (PFN_GENRENDERBUFFERS)getProcARB("glGenRenderbuffers", "glGenRenderbuffersEXT");
+    glDeleteRenderbuffers = (PFN_DELETERENDERBUFFERS)getProcARB("glDeleteRenderbuffers", "glDeleteRenderbuffersEXT");
+    glBindRenderbuffer = (PFN_BINDRENDERBUFFER)getProcARB("glBindRenderbuffer", "glBindRenderbufferEXT");
+    glRenderbufferStorage = (PFN_RENDERBUFFERSTORAGE)getProcARB("glRenderbufferStorage", "glRenderbufferStorageEXT");
+    glFramebufferRenderbuffer = (PFN_FRAMEBUFFERRENDERBUFFER)getProcARB("glFramebufferRenderbuffer", "glFramebufferRenderbufferEXT");
+    hasFramebuffers = glGenFramebuffers && glDeleteFramebuffers && glBindFramebuffer && glCheckFramebufferStatus &&
+        glGenRenderbuffers && glDeleteRenderbuffers && glBindRenderbuffer && glRenderbufferStorage &&
+        glFramebufferRenderbuffer &&
+        (versionAtLeast(3, 0) || hasExtension("GL_ARB_framebuffer_object") || hasExtension("GL_EXT_framebuffer_object"));
+
+    glGenQueries = (PFN_GENQUERIES)getProcARB("glGenQueries", "glGenQueriesARB");
+    glDeleteQueries = (PFN_DELETEQUERIES)getProcARB("glDeleteQueries", "glDeleteQueriesARB");
+    glQueryCounter = (PFN_QUERYCOUNTER)getProc("glQueryCounter");
+    glGetQueryObjectiv = (PFN_GETQUERYOBJECTIV)getProcARB("glGetQueryObjectiv", "glGetQueryObjectivARB");
+    glGetQueryObjectui64v = (PFN_GETQUERYOBJECTUI64V)getProcARB("glGetQueryObjectui64v", "glGetQueryObjectui64vEXT");
+    hasTimerQueries = glGenQueries && glDeleteQueries && glQueryCounter && glGetQueryObjectiv && glGetQueryObjectui64v &&
+        (versionAtLeast(3, 3) || hasExtension("GL_ARB_timer_query"));
+
+    // Per-instance attributes need generic attributes, so instancing also needs shaders
+    glDrawElementsInstanced = (PFN_DRAWELEMENTSINSTANCED)getProcARB("glDrawElementsInstanced", "glDrawElementsInstancedARB");
+    glVertexAttribDivisor = (PFN_VERTEXATTRIBDIVISOR)getProcARB("glVertexAttribDivisor", "glVertexAttribDivisorARB");
+    hasInstancing = glDrawElementsInstanced && glVertexAttribDivisor && hasShaders && hasVertexBuffers &&
+        (versionAtLeast(3, 3) || (hasExtension("GL_ARB_instanced_arrays") && hasExtension("GL_ARB_draw_instanced")));
+}
+
+bool setSwapInterval(int interval) {
+#ifdef _WIN32
+    typedef BOOL (WINAPI* PFN_SWAPINTERVALEXT)(int interval);
+    PFN_SWAPINTERVALEXT swapInterval = (PFN_SWAPINTERVALEXT)getProc("wglSwapIntervalEXT");
+    return swapInterval && swapInterval(interval);
+#else
+    typedef void (*PFN_SWAPINTERVALEXT)(Display* display, GLXDrawable drawable, int interval);
+    typedef int (*PFN_SWAPINTERVALMESA)(unsigned int interval);
+    typedef int (*PFN_SWAPINTERVALSGI)(int interval);
+    Display* display = glXGetCurrentDisplay();
+    GLXDrawable drawable = glXGetCurrentDrawable();
+    if (!display || !drawable) return false;
+    // GLX hands out a stub for any name, so check the extension string before calling
+    const char* extensions = glXQueryExtensionsString(display, DefaultScreen(display));
+    if (!extensions) return false;
+    if (strstr(extensions, "GLX_EXT_swap_control")) {
+        ((PFN_SWAPINTERVALEXT)getProc("glXSwapIntervalEXT"))(display, drawable, interval);
+        return true;
+    }
+    if (strstr(extensions, "GLX_MESA_swap_control"))
+        return ((PFN_SWAPINTERVALMESA)getProc("glXSwapIntervalMESA"))((unsigned int)interval) == 0;
+    PFN_SWAPINTERVALSGI swapSgi = strstr(extensions, "GLX_SGI_swap_control") ?
+        (PFN_SWAPINTERVALSGI)getProc("glXSwapIntervalSGI") : 0;
+    return swapSgi && interval > 0 && swapSgi(interval) == 0;  // SGI can't turn vsync off
+#endif
+}
+
+// Compile one shader stage, printing the log on failure
+static GLuint compileShader(GLenum type, const char* source) {
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, 0);
+    glCompileShader(shader);
+    GLint ok = 0;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &ok);
+    if (!ok) {
+        char log[1024];
+        glGetShaderInfoLog(shader, sizeof(log), 0, log);
+        printf("Shader compile failed: %s\n", log);
+        glDeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+GLuint buildProgram(const char* vertexSource, const char* fragmentSource,
+                    const char* const* attributes, const GLuint* locations, int attributeCount) {
+    if (!hasShaders) return 0;
+    GLuint vs = compileShader(GL_VERTEX_SHADER, vertexSource);
+    GLuint fs = compileShader(GL_FRAGMENT_SHADER, fragmentSource);
+    if (!vs || !fs) {
+        if (vs) glDeleteShader(vs);
+        if (fs) glDeleteShader(fs);
+        return 0;
+    }
+
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vs);
+    glAttachShader(program, fs);
+    for (int i = 0; i < attributeCount; ++i)
+        glBindAttribLocation(program, locations[i], attributes[i]);
+    glLinkProgram(program);
+    glDeleteShader(vs);  // Flagged for deletion once the program is gone
+    glDeleteShader(fs);
+
+    GLint ok = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &ok);
+    if (!ok) {
+        char log[1024];
+        glGetProgramInfoLog(program, sizeof(log), 0, log);
+        printf("Shader link failed: %s\n", log);
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
@@ -0,0 +1,254 @@
+// Runtime loader for OpenGL entry points newer than the 1.1 headers shipped with Windows
+#pragma once
+
+#include <GL/glut.h>          // OpenGL Utility Toolkit (pulls in gl.h)
+#include <stddef.h>           // ptrdiff_t
+
+#ifndef APIENTRY
+#define APIENTRY
+#endif
+
+// Buffer objects (OpenGL 1.5)
+#ifndef GL_VERSION_1_5
+typedef ptrdiff_t GLsizeiptr;
+typedef ptrdiff_t GLintptr;
+#define GL_ARRAY_BUFFER           0x8892
+#define GL_ELEMENT_ARRAY_BUFFER   0x8893
+#define GL_STREAM_DRAW            0x88E0
+#define GL_STATIC_DRAW            0x88E4
+#define GL_DYNAMIC_DRAW           0x88E8
+#define GL_WRITE_ONLY             0x88B9
+#define GL_READ_ONLY              0x88B8
+#define GL_STREAM_READ            0x88E1
+#endif
+
+// Pixel buffer objects (OpenGL 2.1 / ARB_pixel_buffer_object)
+#ifndef GL_PIXEL_PACK_BUFFER
+#define GL_PIXEL_PACK_BUFFER      0x88EB
+#endif
+#ifndef GL_BGRA
+#define GL_BGRA                   0x80E1
+#endif
+
+typedef void (APIENTRY* PFN_GENBUFFERS)(GLsizei n, GLuint* buffers);
+typedef void (APIENTRY* PFN_DELETEBUFFERS)(GLsizei n, const GLuint* buffers);
+typedef void (APIENTRY* PFN_BINDBUFFER)(GLenum target, GLuint buffer);
+typedef void (APIENTRY* PFN_BUFFERDATA)(GLenum target, GLsizeiptr size, const void* data, GLenum usage);
+typedef void (APIENTRY* PFN_BUFFERSUBDATA)(GLenum target, GLintptr offset, GLsizeiptr size, const void* data);
+typedef void* (APIENTRY* PFN_MAPBUFFER)(GLenum target, GLenum access);
+typedef GLboolean (APIENTRY* PFN_UNMAPBUFFER)(GLenum target);
+
+// Several index ranges in one draw call (OpenGL 1.4 / EXT_multi_draw_arrays)
+typedef void (APIENTRY* PFN_MULTIDRAWELEMENTS)(GLenum mode, const GLsizei* count, GLenum type, const void* const* indices, GLsizei drawCount);
+
+// Shaders (OpenGL 2.0)
+#ifndef GL_VERSION_2_0
+typedef char GLchar;
+#define GL_FRAGMENT_SHADER            0x8B30
+#define GL_VERTEX_SHADER              0x8B31
+#define GL_COMPILE_STATUS             0x8B81
+#define GL_LINK_STATUS                0x8B82
+#define GL_VERTEX_PROGRAM_POINT_SIZE  0x8642
+#endif
+
+typedef GLuint (APIENTRY* PFN_CREATESHADER)(GLenum type);
+typedef void (APIENTRY* PFN_DELETESHADER)(GLuint shader);
+typedef void (APIENTRY* PFN_SHADERSOURCE)(GLuint shader, GLsizei count, const GLchar* const* source, const GLint* length);
+typedef void (APIENTRY* PFN_COMPILESHADER)(GLuint shader);
+typedef void (APIENTRY* PFN_GETSHADERIV)(GLuint shader, GLenum pname, GLint* params);
+typedef void (APIENTRY* PFN_GETSHADERINFOLOG)(GLuint shader, GLsizei bufSize, GLsizei* length, GLchar* infoLog);
+typedef GLuint (APIENTRY* PFN_CREATEPROGRAM)();
+typedef void (APIENTRY* PFN_DELETEPROGRAM)(GLuint program);
+typedef void (APIENTRY* PFN_ATTACHSHADER)(GLuint program, GLuint shader);
+typedef void (APIENTRY* PFN_BINDATTRIBLOCATION)(GLuint program, GLuint index, const GLchar* name);
+typedef void (APIENTRY* PFN_LINKPROGRAM)(GLuint program);
+typedef void (APIENTRY* PFN_GETPROGRAMIV)(GLuint program, GLenum pname, GLint* params);
+typedef void (APIENTRY* PFN_GETPROGRAMINFOLOG)(GLuint program, GLsizei bufSize, GLsizei* length, GLchar* infoLog);
+typedef void (APIENTRY* PFN_USEPROGRAM)(GLuint program);
+typedef GLint (APIENTRY* PFN_GETUNIFORMLOCATION)(GLuint program, const GLchar* name);
+typedef void (APIENTRY* PFN_UNIFORM1F)(GLint location, GLfloat v0);
+typedef void (APIENTRY* PFN_UNIFORM1I)(GLint location, GLint v0);
+typedef void (APIENTRY* PFN_UNIFORM4F)(GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3);
+typedef void (APIENTRY* PFN_UNIFORM1FV)(GLint location, GLsizei count, const GLfloat* value);
+typedef void (APIENTRY* PFN_VERTEXATTRIBPOINTER)(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void* pointer);
+typedef void (APIENTRY* PFN_ENABLEVERTEXATTRIBARRAY)(GLuint index);
+typedef void (APIENTRY* PFN_DISABLEVERTEXATTRIBARRAY)(GLuint index);
+
+// Texture units (OpenGL 1.3 / ARB_multitexture)
+#ifndef GL_TEXTURE0
+#define GL_TEXTURE0               0x84C0
+#endif
+
+typedef void (APIENTRY* PFN_ACTIVETEXTURE)(GLenum texture);
+
+// Framebuffer objects (OpenGL 3.0 / ARB_framebuffer_object)
+#ifndef GL_VERSION_3_0
+#define GL_FRAMEBUFFER            0x8D40
+#define GL_RENDERBUFFER           0x8D41
+#define GL_COLOR_ATTACHMENT0      0x8CE0
+#define GL_DEPTH_ATTACHMENT       0x8D00
+#define GL_FRAMEBUFFER_COMPLETE   0x8CD5
+#define GL_FRAMEBUFFER_BINDING    0x8CA6
+#endif
+#ifndef GL_RGBA8
+#define GL_RGBA8                  0x8058
+#endif
+#ifndef GL_DEPTH_COMPONENT24
+#define GL_DEPTH_COMPONENT24      0x81A6
+#endif
+
+typedef void (APIENTRY* PFN_GENFRAMEBUFFERS)(GLsizei n, GLuint* framebuffers);
+typedef void (APIENTRY* PFN_DELETEFRAMEBUFFERS)(GLsizei n, const GLuint* framebuffers);
+typedef void (APIENTRY* PFN_BINDFRAMEBUFFER)(GLenum target, GLuint framebuffer);
+typedef GLenum (APIENTRY* PFN_CHECKFRAMEBUFFERSTATUS)(GLenum target);
+typedef void (APIENTRY* PFN_GENRENDERBUFFERS)(GLsizei n, GLuint* renderbuffers);
+typedef void (APIENTRY* PFN_DELETERENDERBUFFERS)(GLsizei n, const GLuint* renderbuffers);
+typedef void (APIENTRY* PFN_BINDRENDERBUFFER)(GLenum target, GLuint renderbuffer);
+typedef void (APIENTRY* PFN_RENDERBUFFERSTORAGE)(GLenum target, GLenum internalformat, GLsizei width, GLsizei height);
+typedef void (APIENTRY* PFN_FRAMEBUFFERRENDERBUFFER)(GLenum target, GLenum attachment, GLenum renderbuffertarget, GLuint renderbuffer);
+
+// Timer queries (OpenGL 3.3 / ARB_timer_query)
+#ifndef GL_VERSION_3_2
+typedef unsigned long long GLuint64;
+#endif
+#ifndef GL_VERSION_3_3
+#define GL_QUERY_RESULT           0x8866
+#define GL_QUERY_RESULT_AVAILABLE 0x8867
+#define GL_TIMESTAMP              0x8E28
+#endif
+
+typedef void (APIENTRY* PFN_GENQUERIES)(GLsizei n, GLuint* ids);
+typedef void (APIENTRY* PFN_DELETEQUERIES)(GLsizei n, const GLuint* ids);
+typedef void (APIENTRY* PFN_QUERYCOUNTER)(GLuint id, GLenum target);
+typedef void (APIENTRY* PFN_GETQUERYOBJECTIV)(GLuint id, GLenum pname, GLint* params);
+typedef void (APIENTRY* PFN_GETQUERYOBJECTUI64V)(GLuint id, GLenum pname, GLuint64* params);
+
+// Instanced drawing (OpenGL 3.3 / ARB_draw_instanced + ARB_instanced_arrays)
+typedef void (APIENTRY* PFN_DRAWELEMENTSINSTANCED)(GLenum mode, GLsizei count, GLenum type, const void* indices, GLsizei instanceCount);
+typedef void (APIENTRY* PFN_VERTEXATTRIBDIVISOR)(GLuint index, GLuint divisor);
+
+// Our pointers are renamed so they never clash with prototypes from a system glext.h
+#define glGenBuffers    ext_glGenBuffers
+#define glDeleteBuffers ext_glDeleteBuffers
+#define glBindBuffer    ext_glBindBuffer
+#define glBufferData    ext_glBufferData
+#define glBufferSubData ext_glBufferSubData
+#define glMapBuffer     ext_glMapBuffer
+#define glUnmapBuffer   ext_glUnmapBuffer
+#define glMultiDrawElements ext_glMultiDrawElements
+#define glCreateShader  ext_glCreateShader
+#define glDeleteShader  ext_glDeleteShader
+#define glShaderSource  ext_glShaderSource
+#define glCompileShader ext_glCompileShader
+#define glGetShaderiv   ext_glGetShaderiv
+#define glGetShaderInfoLog ext_glGetShaderInfoLog
+#define glCreateProgram ext_glCreateProgram
+#define glDeleteProgram ext_glDeleteProgram
+#define glAttachShader  ext_glAttachShader
+#define glBindAttribLocation ext_glBindAttribLocation
+#define glLinkProgram   ext_glLinkProgram
+#define glGetProgramiv  ext_glGetProgramiv
+#define glGetProgramInfoLog ext_glGetProgramInfoLog
+#define glUseProgram    ext_glUseProgram
+#define glGetUniformLocation ext_glGetUniformLocation
+#define glUniform1f     ext_glUniform1f
+#define glUniform1i     ext_glUniform1i
+#define glUniform4f     ext_glUniform4f
+#define glUniform1fv    ext_glUniform1fv
+#define glVertexAttribPointer ext_glVertexAttribPointer
+#define glEnableVertexAttribArray ext_glEnableVertexAttribArray
+#define glDisableVertexAttribArray ext_glDisableVertexAttribArray
+#define glActiveTexture ext_glActiveTexture
+#define glGenFramebuffers ext_glGenFramebuffers
+#define glDeleteFramebuffers ext_glDeleteFramebuffers
+#define glBindFramebuffer ext_glBindFramebuffer
+#define glCheckFramebufferStatus ext_glCheckFramebufferStatus
+#define glGenRenderbuffers ext_glGenRenderbuffers
+#define glDeleteRenderbuffers ext_glDeleteRenderbuffers
+#define glBindRenderbuffer ext_glBindRenderbuffer
+#define glRenderbufferStorage ext_glRenderbufferStorage
+#define glFramebufferRenderbuffer ext_glFramebufferRenderbuffer
+#define glGenQueries    ext_glGenQueries
+#define glDeleteQueries ext_glDeleteQueries
+#define glQueryCounter  ext_glQueryCounter
+#define glGetQueryObjectiv ext_glGetQueryObjectiv
+#define glGetQueryObjectui64v ext_glGetQueryObjectui64v
+#define glDrawElementsInstanced ext_glDrawElementsInstanced
+#define glVertexAttribDivisor ext_glVertexAttribDivisor
+
+extern PFN_GENBUFFERS    glGenBuffers;
+extern PFN_DELETEBUFFERS glDeleteBuffers;
+extern PFN_BINDBUFFER    glBindBuffer;
+extern PFN_BUFFERDATA    glBufferData;
+extern PFN_BUFFERSUBDATA glBufferSubData;
+extern PFN_MAPBUFFER     glMapBuffer;
+extern PFN_UNMAPBUFFER   glUnmapBuffer;
+extern PFN_MULTIDRAWELEMENTS glMultiDrawElements;  // Null when unavailable (callers loop over glDrawElements)
+extern PFN_CREATESHADER  glCreateShader;
+extern PFN_DELETESHADER  glDeleteShader;
+extern PFN_SHADERSOURCE  glShaderSource;
+extern PFN_COMPILESHADER glCompileShader;
+extern PFN_GETSHADERIV   glGetShaderiv;
+extern PFN_GETSHADERINFOLOG glGetShaderInfoLog;
+extern PFN_CREATEPROGRAM glCreateProgram;
+extern PFN_DELETEPROGRAM glDeleteProgram;
+extern PFN_ATTACHSHADER  glAttachShader;
+extern PFN_BINDATTRIBLOCATION glBindAttribLocation;
+extern PFN_LINKPROGRAM   glLinkProgram;
+extern PFN_GETPROGRAMIV  glGetProgramiv;
+extern PFN_GETPROGRAMINFOLOG glGetProgramInfoLog;
+extern PFN_USEPROGRAM    glUseProgram;
+extern PFN_GETUNIFORMLOCATION glGetUniformLocation;
+extern PFN_UNIFORM1F     glUniform1f;
+extern PFN_UNIFORM1I     glUniform1i;
+extern PFN_UNIFORM4F     glUniform4f;   // Not part of hasShaders (older modules never needed them)
+extern PFN_UNIFORM1FV    glUniform1fv;
+extern PFN_VERTEXATTRIBPOINTER glVertexAttribPointer;
+extern PFN_ENABLEVERTEXATTRIBARRAY glEnableVertexAttribArray;
+extern PFN_DISABLEVERTEXATTRIBARRAY glDisableVertexAttribArray;
+extern PFN_ACTIVETEXTURE glActiveTexture;  // Null when only one texture unit is reachable
+extern PFN_GENFRAMEBUFFERS glGenFramebuffers;
+extern PFN_DELETEFRAMEBUFFERS glDeleteFramebuffers;
+extern PFN_BINDFRAMEBUFFER glBindFramebuffer;
+extern PFN_CHECKFRAMEBUFFERSTATUS glCheckFramebufferStatus;
+extern PFN_GENRENDERBUFFERS glGenRenderbuffers;
+extern PFN_DELETERENDERBUFFERS glDeleteRenderbuffers;
+extern PFN_BINDRENDERBUFFER glBindRenderbuffer;
+extern PFN_RENDERBUFFERSTORAGE glRenderbufferStorage;
+extern PFN_FRAMEBUFFERRENDERBUFFER glFramebufferRenderbuffer;
+extern PFN_GENQUERIES    glGenQueries;
+extern PFN_DELETEQUERIES glDeleteQueries;
+extern PFN_QUERYCOUNTER  glQueryCounter;
+extern PFN_GETQUERYOBJECTIV glGetQueryObjectiv;
+extern PFN_GETQUERYOBJECTUI64V glGetQueryObjectui64v;
+extern PFN_DRAWELEMENTSINSTANCED glDrawElementsInstanced;
+extern PFN_VERTEXATTRIBDIVISOR glVertexAttribDivisor;
+
+// Feature flags filled in by loadGLExtensions()
+extern bool hasVertexBuffers;   // Buffer objects are available
+extern bool hasShaders;         // GLSL programs are available
+extern bool hasFramebuffers;    // Offscreen framebuffer objects are available
+extern bool hasTimerQueries;    // GPU timestamp queries are available
+extern bool hasInstancing;      // Instanced draws with per-instance attributes are available
+extern bool hasPixelBuffers;    // Asynchronous glReadPixels into mapped buffers is available
+
+// Looks up a GL entry point by name in the current context
+typedef void* (*GLProcResolver)(const char* name);
+
+// Resolve all entry points; call once after the GL context exists. Contexts not made by the
+// window system (EGL) pass their own resolver; otherwise wgl/glX look the names up.
+void loadGLExtensions(GLProcResolver resolver = 0);
+
+// Vertical blanks to wait per buffer swap (0 = off, 1 = vsync) for the current window.
+// Returns false when the platform offers no way to set it.
+bool setSwapInterval(int interval);
+
+// Compile and link a GLSL program from vertex and fragment source.
+// Attribute names are bound to the matching locations. Avoid 0 (gl_Vertex) and the slots some
+// drivers alias onto fixed-function arrays: 2 (gl_Normal), 3 (gl_Color), 4, 5 and 8-15.
+// Returns 0 and prints the log on failure.
+GLuint buildProgram(const char* vertexSource, const char* fragmentSource,
+                    const char* const* attributes = 0, const GLuint* locations = 0, int attributeCount = 0);
+
+// Byte offset into the bound buffer object, for gl*Pointer calls
+#define BUFFER_OFFSET(bytes) ((const GLvoid*)(size_t)(bytes))
@@ -0,0 +1,145 @@
+// Offscreen rendering without a window, for batch frame generation and CI benchmarks
+#ifndef _WIN32
+#include <EGL/egl.h>          // Display-less context creation
+#include <X11/Xlib.h>         // XOpenDisplay, to see whether GLUT can start
+#endif
+#include "Headless.h"
+#include <stdio.h>            // Error output
+
+#ifndef _WIN32
+#ifndef EGL_PLATFORM_SURFACELESS_MESA
+#define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+#endif
+typedef EGLDisplay (EGLAPIENTRY* PFN_GETPLATFORMDISPLAYEXT)(EGLenum platform, void* nativeDisplay, const EGLint* attribs);
+
+static EGLDisplay eglDisplay = EGL_NO_DISPLAY;
+static EGLContext eglContext = EGL_NO_CONTEXT;
+static EGLSurface eglSurface = EGL_NO_SURFACE;  // Only when surfaceless contexts are unsupported
+#endif
+
+static GLuint framebuffer = 0;
+static GLuint renderbuffers[2] = { 0, 0 };  // Color and depth
+static int frameWidth = 0, frameHeight = 0;
+static bool glutStarted = false;
+
+#ifndef _WIN32
+// GL entry points for the EGL context (glX would answer for a context that isn't current)
+static void* getEGLProc(const char* name) {
+    return (void*)eglGetProcAddress(name);
+}
+
+// Bring up EGL on the Mesa surfaceless platform if present, else the default display
+static bool createEGLContext() {
+    PFN_GETPLATFORMDISPLAYEXT getPlatformDisplay =
+        (PFN_GETPLATFORMDISPLAYEXT)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (getPlatformDisplay)
+        eglDisplay = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, 0);
+    if (eglDisplay == EGL_NO_DISPLAY)
+        eglDisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    EGLint major, minor;
+    if (eglDisplay == EGL_NO_DISPLAY || !eglInitialize(eglDisplay, &major, &minor)) {
+        printf("Headless: no EGL display\n");
+        return false;
+    }
+
+    const EGLint configAttribs[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT, EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8, EGL_DEPTH_SIZE, 24, EGL_NONE
+    };
+    EGLConfig config;
+    EGLint configCount = 0;
+    if (!eglChooseConfig(eglDisplay, configAttribs, &config, 1, &configCount) || configCount < 1 ||
+        !eglBindAPI(EGL_OPENGL_API)) {
+        printf("Headless: no desktop OpenGL config\n");
+        return false;
+    }
+    eglContext = eglCreateContext(eglDisplay, config, EGL_NO_CONTEXT, 0);
+    if (eglContext == EGL_NO_CONTEXT) {
+        printf("Headless: context creation failed\n");
+        return false;
+    }
+
+    // Drawing goes to our framebuffer, so a surface is only needed when the driver insists
+    if (eglMakeCurrent(eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, eglContext)) return true;
+    const EGLint pbufferAttribs[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+    eglSurface = eglCreatePbufferSurface(eglDisplay, config, pbufferAttribs);
+    if (eglSurface != EGL_NO_SURFACE && eglMakeCurrent(eglDisplay, eglSurface, eglSurface, eglContext))
+        return true;
+    printf("Headless: could not make the context current\n");
+    return false;
+}
+#endif
+
+bool createHeadlessContext(int width, int height, int* argc, char** argv) {
+#ifdef _WIN32
+    // WGL needs a window for its context; it just never gets shown
+    glutInit(argc, argv);
+    glutInitDisplayMode(GLUT_SINGLE | GLUT_RGB | GLUT_DEPTH);
+    glutInitWindowSize(1, 1);
+    glutCreateWindow("Solar System (headless)");
+    glutHideWindow();
+    glutStarted = true;
+#else
+    if (!createEGLContext()) return false;
+    // GLUT only supplies the overlay font here, but glutInit() exits without a reachable X display
+    Display* display = XOpenDisplay(0);
+    if (display) {
+        XCloseDisplay(display);
+        glutInit(argc, argv);
+        glutStarted = true;
+    }
+#endif
+
+#ifdef _WIN32
+    loadGLExtensions();
+#else
+    loadGLExtensions(getEGLProc);
+#endif
+    if (!hasFramebuffers) {
+        printf("Headless: framebuffer objects are not supported\n");
+        return false;
+    }
+
+    // Color and depth renderbuffers at the requested size
+    frameWidth = width;
+    frameHeight = height;
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glGenRenderbuffers(2, renderbuffers);
+    glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[0]);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderbuffers[0]);
+    glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[1]);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, renderbuffers[1]);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        printf("Headless: %dx%d framebuffer is incomplete\n", width, height);
+        return false;
+    }
+    glViewport(0, 0, width, height);
+    return true;
+}
+
+bool headlessHasGlut() {
+    return glutStarted;
+}
+
+void destroyHeadlessContext() {
+    if (framebuffer) {
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glDeleteFramebuffers(1, &framebuffer);
+        glDeleteRenderbuffers(2, renderbuffers);
+        framebuffer = 0;
+    }
+#ifndef _WIN32
+    if (eglDisplay != EGL_NO_DISPLAY) {
+        eglMakeCurrent(eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if (eglSurface != EGL_NO_SURFACE) eglDestroySurface(eglDisplay, eglSurface);
+        if (eglContext != EGL_NO_CONTEXT) eglDestroyContext(eglDisplay, eglContext);
+        eglTerminate(eglDisplay);
+        eglDisplay = EGL_NO_DISPLAY;
+        eglContext = EGL_NO_CONTEXT;
+        eglSurface = EGL_NO_SURFACE;
+    }
+#endif
+}
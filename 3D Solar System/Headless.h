@@ -0,0 +1,17 @@
+// Offscreen rendering without a window, for batch frame generation and CI benchmarks
+#pragma once
+
+#include "GLExtensions.h"     // Framebuffer objects
+
+// Create a GL context with no visible window and bind a width x height framebuffer
+// for all drawing. Uses EGL (surfaceless or a 1x1 pbuffer) on Linux and a hidden
+// GLUT window on Windows. Prints the reason and returns false on failure.
+bool createHeadlessContext(int width, int height, int* argc, char** argv);
+
+// Whether GLUT was initialized along with the context (always on Windows; on Linux only
+// when an X display is reachable). The text overlay needs it for its font.
+bool headlessHasGlut();
+
+// Release the framebuffer and the context
+void destroyHeadlessContext();
+
@@ -0,0 +1,137 @@
+// Keplerian orbits evaluated analytically at any time
+#include "Kepler.h"
+#include <math.h>             // sin, cos, sqrt
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>        // SSE2 double-precision lanes
+#define KEPLER_SSE2 1
+#endif
+
+static const int KEPLER_ITERATIONS = 6;  // Newton steps; converged to double precision for e < 0.9
+static const double TWO_PI = 6.283185307179586;
+static const double INV_TWO_PI = 0.15915494309189535;
+static const double ROUND_MAGIC = 6755399441055744.0;  // 1.5 * 2^52: adding it rounds to an integer
+
+void orbitalBasis(const OrbitalElements& orbit, double P[3], double Q[3]) {
+    double cw = cos(orbit.periapsis), sw = sin(orbit.periapsis);
+    double ci = cos(orbit.inclination), si = sin(orbit.inclination);
+    double cn = cos(orbit.ascendingNode), sn = sin(orbit.ascendingNode);
+
+    // Rotate within the plane by the argument of periapsis (about +Y)
+    double p[3] = { -sw, 0.0, cw };
+    double q[3] = { -cw, 0.0, -sw };
+    // Tilt about the node line (+Z) so the ascending half rises above the ecliptic
+    double pi[3] = { p[0] * ci, -p[0] * si, p[2] };
+    double qi[3] = { q[0] * ci, -q[0] * si, q[2] };
+    // Turn the node line to its longitude (about +Y)
+    P[0] = pi[0] * cn - pi[2] * sn; P[1] = pi[1]; P[2] = pi[0] * sn + pi[2] * cn;
+    Q[0] = qi[0] * cn - qi[2] * sn; Q[1] = qi[1]; Q[2] = qi[0] * sn + qi[2] * cn;
+}
+
+// Mean anomaly at time t wrapped to [-pi, pi] (the same rounding as the SIMD path)
+static double meanAnomalyAt(double epoch, double motion, double t) {
+    double m = epoch + motion * t;
+    double turns = (m * INV_TWO_PI + ROUND_MAGIC) - ROUND_MAGIC;
+    return m - turns * TWO_PI;
+}
+
+double solveKepler(double meanAnomaly, double e) {
+    // Second-order starting guess, then a fixed number of Newton steps (no data-dependent exit)
+    double sm = sin(meanAnomaly), cm = cos(meanAnomaly);
+    double E = meanAnomaly + e * sm * (1.0 + e * cm);
+    for (int k = 0; k < KEPLER_ITERATIONS; ++k)
+        E -= (E - e * sin(E) - meanAnomaly) / (1.0 - e * cos(E));
+    return E;
+}
+
+void propagateKeplerScalar(const KeplerOrbits& o, double t, int begin, int end,
+                           double* x, double* y, double* z) {
+    for (int i = begin; i < end; ++i) {
+        double e = o.eccentricity[i];
+        double E = solveKepler(meanAnomalyAt(o.epochAnomaly[i], o.meanMotion[i], t), e);
+        double a = cos(E) - e, b = sin(E);
+        x[i] = a * o.px[i] + b * o.qx[i];
+        y[i] = a * o.py[i] + b * o.qy[i];
+        z[i] = a * o.pz[i] + b * o.qz[i];
+    }
+}
+
+#ifdef KEPLER_SSE2
+// Bitwise select: mask ? a : b
+static inline __m128d selectPd(__m128d mask, __m128d a, __m128d b) {
+    return _mm_or_pd(_mm_and_pd(mask, a), _mm_andnot_pd(mask, b));
+}
+
+static inline __m128d roundPd(__m128d v) {
+    const __m128d magic = _mm_set1_pd(ROUND_MAGIC);
+    return _mm_sub_pd(_mm_add_pd(v, magic), magic);
+}
+
+// sin and cos of two angles of moderate size (|x| < 1e4): quadrant reduction by pi/2,
+// then the Cephes minimax polynomials on [-pi/4, pi/4]
+static inline void sincosPd(__m128d x, __m128d& s, __m128d& c) {
+    const __m128d q = roundPd(_mm_mul_pd(x, _mm_set1_pd(0.63661977236758134)));  // x / (pi/2)
+    // Cody-Waite: pi/2 split so q * PIO2_HI is exact
+    __m128d r = _mm_sub_pd(x, _mm_mul_pd(q, _mm_set1_pd(1.57079632673412561417e+00)));
+    r = _mm_sub_pd(r, _mm_mul_pd(q, _mm_set1_pd(6.07710050650619224932e-11)));
+    const __m128d z = _mm_mul_pd(r, r);
+
+    __m128d ps = _mm_set1_pd(1.58962301576546568060e-10);
+    ps = _mm_add_pd(_mm_mul_pd(ps, z), _mm_set1_pd(-2.50507477628578072866e-8));
+    ps = _mm_add_pd(_mm_mul_pd(ps, z), _mm_set1_pd(2.75573136213857245213e-6));
+    ps = _mm_add_pd(_mm_mul_pd(ps, z), _mm_set1_pd(-1.98412698295895385996e-4));
+    ps = _mm_add_pd(_mm_mul_pd(ps, z), _mm_set1_pd(8.33333333332211858878e-3));
+    ps = _mm_add_pd(_mm_mul_pd(ps, z), _mm_set1_pd(-1.66666666666666307295e-1));
+    const __m128d sr = _mm_add_pd(r, _mm_mul_pd(_mm_mul_pd(r, z), ps));
+
+    __m128d pc = _mm_set1_pd(-1.13585365213876817300e-11);
+    pc = _mm_add_pd(_mm_mul_pd(pc, z), _mm_set1_pd(2.08757008419747316778e-9));
+    pc = _mm_add_pd(_mm_mul_pd(pc, z), _mm_set1_pd(-2.75573141792967388112e-7));
+    pc = _mm_add_pd(_mm_mul_pd(pc, z), _mm_set1_pd(2.48015872888517045348e-5));
+    pc = _mm_add_pd(_mm_mul_pd(pc, z), _mm_set1_pd(-1.38888888888730564116e-3));
+    pc = _mm_add_pd(_mm_mul_pd(pc, z), _mm_set1_pd(4.16666666666665929218e-2));
+    const __m128d cr = _mm_add_pd(_mm_sub_pd(_mm_set1_pd(1.0), _mm_mul_pd(_mm_set1_pd(0.5), z)),
+                                  _mm_mul_pd(_mm_mul_pd(z, z), pc));
+
+    // Quadrant q mod 4 picks which polynomial and sign each result takes
+    const __m128d quadrant = _mm_sub_pd(q, _mm_mul_pd(_mm_set1_pd(4.0),
+        roundPd(_mm_mul_pd(_mm_sub_pd(q, _mm_set1_pd(1.5)), _mm_set1_pd(0.25)))));
+    const __m128d q1 = _mm_cmpeq_pd(quadrant, _mm_set1_pd(1.0));
+    const __m128d q2 = _mm_cmpeq_pd(quadrant, _mm_set1_pd(2.0));
+    const __m128d q3 = _mm_cmpeq_pd(quadrant, _mm_set1_pd(3.0));
+    const __m128d swap = _mm_or_pd(q1, q3);
+    const __m128d signBit = _mm_set1_pd(-0.0);
+    s = _mm_xor_pd(selectPd(swap, cr, sr), _mm_and_pd(_mm_or_pd(q2, q3), signBit));
+    c = _mm_xor_pd(selectPd(swap, sr, cr), _mm_and_pd(_mm_or_pd(q1, q2), signBit));
+}
+#endif
+
+void propagateKepler(const KeplerOrbits& o, double t, int begin, int end,
+                     double* x, double* y, double* z) {
+    int i = begin;
+#ifdef KEPLER_SSE2
+    const __m128d vt = _mm_set1_pd(t);
+    const __m128d one = _mm_set1_pd(1.0);
+    for (; i + 2 <= end; i += 2) {
+        __m128d e = _mm_loadu_pd(o.eccentricity + i);
+        __m128d m = _mm_add_pd(_mm_loadu_pd(o.epochAnomaly + i), _mm_mul_pd(_mm_loadu_pd(o.meanMotion + i), vt));
+        m = _mm_sub_pd(m, _mm_mul_pd(roundPd(_mm_mul_pd(m, _mm_set1_pd(INV_TWO_PI))), _mm_set1_pd(TWO_PI)));
+
+        __m128d s, c;
+        sincosPd(m, s, c);
+        __m128d E = _mm_add_pd(m, _mm_mul_pd(_mm_mul_pd(e, s), _mm_add_pd(one, _mm_mul_pd(e, c))));
+        for (int k = 0; k < KEPLER_ITERATIONS; ++k) {
+            sincosPd(E, s, c);
+            __m128d f = _mm_sub_pd(_mm_sub_pd(E, _mm_mul_pd(e, s)), m);
+            E = _mm_sub_pd(E, _mm_div_pd(f, _mm_sub_pd(one, _mm_mul_pd(e, c))));
+        }
+        sincosPd(E, s, c);
+
+        __m128d a = _mm_sub_pd(c, e);
+        _mm_storeu_pd(x + i, _mm_add_pd(_mm_mul_pd(a, _mm_loadu_pd(o.px + i)), _mm_mul_pd(s, _mm_loadu_pd(o.qx + i))));
+        _mm_storeu_pd(y + i, _mm_add_pd(_mm_mul_pd(a, _mm_loadu_pd(o.py + i)), _mm_mul_pd(s, _mm_loadu_pd(o.qy + i))));
+        _mm_storeu_pd(z + i, _mm_add_pd(_mm_mul_pd(a, _mm_loadu_pd(o.pz + i)), _mm_mul_pd(s, _mm_loadu_pd(o.qz + i))));
+    }
+#endif
+    propagateKeplerScalar(o, t, i, end, x, y, z);  // Remainder (or everything without SSE2)
+}
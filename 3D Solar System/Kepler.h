@@ -0,0 +1,39 @@
+// Keplerian orbits evaluated analytically at any time (no OpenGL dependency)
+#pragma once
+
+// Keplerian shape and orientation of an orbit (angles in radians).
+// Angles are measured in the direction the bodies travel, with the
+// reference direction along +Z and the orbit normal along +Y.
+struct OrbitalElements {
+    double semiMajor;      // Semi-major axis
+    double eccentricity;   // 0 = circle, < 1 = ellipse
+    double inclination;    // Tilt of the orbit plane from the ecliptic (XZ plane)
+    double ascendingNode;  // Longitude of the ascending node
+    double periapsis;      // Argument of periapsis
+};
+
+// Unit vectors of the orbit plane: P points to periapsis, Q is 90 degrees ahead.
+// A body at eccentric anomaly E sits at a(cos E - e) P + b sin E Q.
+void orbitalBasis(const OrbitalElements& orbit, double P[3], double Q[3]);
+
+// Eccentric anomaly for mean anomaly M (Newton's method, fixed iteration count)
+double solveKepler(double meanAnomaly, double eccentricity);
+
+// Many orbits in structure-of-arrays form. The basis vectors are pre-scaled:
+// p = a * P and q = b * Q, so a body sits at (cos E - e) p + sin E q.
+struct KeplerOrbits {
+    const double* meanMotion;    // Radians per second
+    const double* epochAnomaly;  // Mean anomaly at time 0
+    const double* eccentricity;
+    const double* px; const double* py; const double* pz;
+    const double* qx; const double* qy; const double* qz;
+};
+
+// Positions of orbits [begin, end) at time t, relative to the body they orbit.
+// Uses SSE2 two bodies at a time where available; the cost does not depend on t.
+void propagateKepler(const KeplerOrbits& orbits, double t, int begin, int end,
+                     double* x, double* y, double* z);
+
+// Same result one body at a time with the C library's sin and cos (reference and fallback)
+void propagateKeplerScalar(const KeplerOrbits& orbits, double t, int begin, int end,
+                           double* x, double* y, double* z);
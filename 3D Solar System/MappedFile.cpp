@@ -0,0 +1,70 @@
+// Read-only memory-mapped files
+#include "MappedFile.h"
+#ifdef _WIN32
+#include <windows.h>          // CreateFileMapping, MapViewOfFile
+#else
+#include <fcntl.h>            // open
+#include <sys/mman.h>         // mmap
+#include <sys/stat.h>         // fstat
+#include <unistd.h>           // close
+#endif
+
+bool mapFile(const char* path, MappedFile& file) {
+    file.data = 0;
+    file.size = 0;
+    file.fileHandle = 0;
+    file.mappingHandle = 0;
+#ifdef _WIN32
+    HANDLE handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+    if (handle == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(handle, &size) || size.QuadPart == 0) {
+        CloseHandle(handle);
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingA(handle, 0, PAGE_READONLY, 0, 0, 0);
+    if (!mapping) {
+        CloseHandle(handle);
+        return false;
+    }
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view) {
+        CloseHandle(mapping);
+        CloseHandle(handle);
+        return false;
+    }
+    file.data = (const unsigned char*)view;
+    file.size = (size_t)size.QuadPart;
+    file.fileHandle = handle;
+    file.mappingHandle = mapping;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        close(fd);
+        return false;
+    }
+    void* view = mmap(0, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);  // The mapping stays valid after the descriptor is closed
+    if (view == MAP_FAILED) return false;
+    file.data = (const unsigned char*)view;
+    file.size = (size_t)info.st_size;
+#endif
+    return true;
+}
+
+void unmapFile(MappedFile& file) {
+    if (!file.data) return;
+#ifdef _WIN32
+    UnmapViewOfFile(file.data);
+    CloseHandle((HANDLE)file.mappingHandle);
+    CloseHandle((HANDLE)file.fileHandle);
+#else
+    munmap((void*)file.data, file.size);
+#endif
+    file.data = 0;
+    file.size = 0;
+    file.fileHandle = 0;
+    file.mappingHandle = 0;
+}
@@ -0,0 +1,17 @@
+// Read-only memory-mapped files
+#pragma once
+
+#include <stddef.h>           // size_t
+
+struct MappedFile {
+    const unsigned char* data;  // Start of the mapping (null when not mapped)
+    size_t size;                // Length in bytes
+    void* fileHandle;           // Platform handles kept for unmapping
+    void* mappingHandle;
+};
+
+// Map a whole file read-only; returns false if it is missing or empty
+bool mapFile(const char* path, MappedFile& file);
+
+// Release a mapping made by mapFile (safe on an unmapped file)
+void unmapFile(MappedFile& file);
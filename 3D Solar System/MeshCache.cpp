@@ -0,0 +1,120 @@
+// Sphere meshes built once into vertex/index buffers and shared by every body
+#include "MeshCache.h"
+#include <math.h>             // sin, cos
+#include <map>                // Cache keyed by tessellation
+
+static const double MESH_PI = 3.141592653589793;
+static const float QUANT = 32767.0f;  // Scale of the 16-bit quantized attributes
+
+static std::map<int, SphereMesh> meshCache;  // Meshes by segment count
+
+// Build a unit sphere with the same layout and texture mapping as gluSphere
+static SphereMesh buildSphere(int segments) {
+    const int slices = segments, stacks = segments;
+    const int vertexCount = (stacks + 1) * (slices + 1);
+    SphereMesh mesh = { segments, 0, 0, (GLsizei)(stacks * slices * 6), 0, 0 };
+    mesh.vertices = new MeshVertex[vertexCount];
+    mesh.indices = new GLushort[mesh.indexCount];
+
+    // Vertices: rho runs from the +z pole down, theta around the axis
+    for (int i = 0; i <= stacks; ++i) {
+        double rho = MESH_PI * i / stacks;
+        for (int j = 0; j <= slices; ++j) {
+            double theta = (j == slices) ? 0.0 : 2.0 * MESH_PI * j / slices;
+            MeshVertex& v = mesh.vertices[i * (slices + 1) + j];
+            v.px = (GLshort)lround(-sin(theta) * sin(rho) * QUANT);
+            v.py = (GLshort)lround(cos(theta) * sin(rho) * QUANT);
+            v.pz = (GLshort)lround(cos(rho) * QUANT);
+            v.pad = 0;
+            v.s = (GLshort)lround((double)j / slices * QUANT);
+            v.t = (GLshort)lround((1.0 - (double)i / stacks) * QUANT);
+        }
+    }
+
+    // Two triangles per quad between neighbouring stacks
+    GLushort* idx = mesh.indices;
+    for (int i = 0; i < stacks; ++i) {
+        for (int j = 0; j < slices; ++j) {
+            GLushort a = (GLushort)(i * (slices + 1) + j);
+            GLushort b = (GLushort)(a + slices + 1);
+            *idx++ = a; *idx++ = b; *idx++ = (GLushort)(a + 1);
+            *idx++ = (GLushort)(a + 1); *idx++ = b; *idx++ = (GLushort)(b + 1);
+        }
+    }
+
+    // Upload once; the client copies are only kept when buffers are unavailable
+    if (hasVertexBuffers) {
+        glGenBuffers(1, &mesh.vertexBuffer);
+        glBindBuffer(GL_ARRAY_BUFFER, mesh.vertexBuffer);
+        glBufferData(GL_ARRAY_BUFFER, vertexCount * sizeof(MeshVertex), mesh.vertices, GL_STATIC_DRAW);
+        glGenBuffers(1, &mesh.indexBuffer);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.indexBuffer);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.indexCount * sizeof(GLushort), mesh.indices, GL_STATIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        delete[] mesh.vertices;
+        delete[] mesh.indices;
+        mesh.vertices = 0;
+        mesh.indices = 0;
+    }
+    return mesh;
+}
+
+const SphereMesh& getSphereMesh(int segments) {
+    auto it = meshCache.find(segments);
+    if (it == meshCache.end())
+        it = meshCache.insert(std::make_pair(segments, buildSphere(segments))).first;
+    return it->second;
+}
+
+void drawSphereMesh(const SphereMesh& mesh, double radius) {
+    // Point the fixed-function arrays at the mesh (offsets when it lives in buffers)
+    const char* base = (const char*)mesh.vertices;
+    const GLvoid* indices = mesh.indices;
+    if (mesh.vertexBuffer) {
+        glBindBuffer(GL_ARRAY_BUFFER, mesh.vertexBuffer);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.indexBuffer);
+        base = 0;
+        indices = BUFFER_OFFSET(0);
+    }
+    glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_NORMAL_ARRAY);
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    glVertexPointer(3, GL_SHORT, sizeof(MeshVertex), base);
+    glNormalPointer(GL_SHORT, sizeof(MeshVertex), base);  // Normals are normalized by GL
+    glTexCoordPointer(2, GL_SHORT, sizeof(MeshVertex), base + 4 * sizeof(GLshort));
+
+    // Undo the quantization with the modelview and texture matrices
+    glMatrixMode(GL_TEXTURE);
+    glPushMatrix();
+    glLoadIdentity();
+    glScalef(1.0f / QUANT, 1.0f / QUANT, 1.0f);
+    glMatrixMode(GL_MODELVIEW);
+    glPushMatrix();
+    float scale = (float)(radius / QUANT);
+    glScalef(scale, scale, scale);
+
+    glDrawElements(GL_TRIANGLES, mesh.indexCount, GL_UNSIGNED_SHORT, indices);
+
+    glPopMatrix();
+    glMatrixMode(GL_TEXTURE);
+    glPopMatrix();
+    glMatrixMode(GL_MODELVIEW);
+    glPopClientAttrib();
+    if (mesh.vertexBuffer) {
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    }
+}
+
+void clearMeshCache() {
+    for (auto& entry : meshCache) {
+        SphereMesh& mesh = entry.second;
+        if (mesh.vertexBuffer) glDeleteBuffers(1, &mesh.vertexBuffer);
+        if (mesh.indexBuffer) glDeleteBuffers(1, &mesh.indexBuffer);
+        delete[] mesh.vertices;
+        delete[] mesh.indices;
+    }
+    meshCache.clear();
+}
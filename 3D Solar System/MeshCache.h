@@ -0,0 +1,29 @@
+// Sphere meshes built once into vertex/index buffers and shared by every body
+#pragma once
+
+#include "GLExtensions.h"     // Buffer object entry points
+
+// Compact sphere vertex: the unit-sphere position doubles as the normal
+struct MeshVertex {
+    GLshort px, py, pz, pad;  // Position/normal quantized to signed 16-bit
+    GLshort s, t;             // Texture coordinates quantized to 0..32767
+};
+
+// One tessellated unit sphere living on the GPU (or in client memory as a fallback)
+struct SphereMesh {
+    int segments;             // Slices and stacks used to build it
+    GLuint vertexBuffer;      // Buffer object ids (0 when buffers are unavailable)
+    GLuint indexBuffer;
+    GLsizei indexCount;
+    MeshVertex* vertices;     // Client-side copies used when buffers are unavailable
+    GLushort* indices;
+};
+
+// Get the shared sphere with the given tessellation, building it on first use
+const SphereMesh& getSphereMesh(int segments);
+
+// Draw a cached sphere of the given radius with the current transform and texture
+void drawSphereMesh(const SphereMesh& mesh, double radius);
+
+// Release every cached mesh
+void clearMeshCache();
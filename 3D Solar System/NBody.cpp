@@ -0,0 +1,170 @@
+// Gravitational N-body force evaluation using a Barnes-Hut octree
+#include "NBody.h"
+#include <math.h>             // sqrt, fabs
+
+static const int MAX_DEPTH = 32;  // Deeper cells just keep a list (coincident bodies)
+
+BarnesHutTree::BarnesHutTree()
+    : theta(0.5), softening(0.05), G(1.0), leafCapacity(8),
+      px(0), py(0), pz(0), pm(0) {
+}
+
+int BarnesHutTree::newNode(double cx, double cy, double cz, double halfSize) {
+    OctreeNode node;
+    node.cx = cx; node.cy = cy; node.cz = cz;
+    node.halfSize = halfSize;
+    node.mass = 0.0;
+    node.comX = node.comY = node.comZ = 0.0;
+    for (int i = 0; i < 8; ++i) node.children[i] = -1;
+    node.firstBody = -1;
+    node.bodyCount = 0;
+    node.isLeaf = true;
+    nodes.push_back(node);
+    return (int)nodes.size() - 1;
+}
+
+// Octant of (x, y, z) relative to a node center (bit 0 = x, bit 1 = y, bit 2 = z)
+static int octantOf(const OctreeNode& n, double x, double y, double z) {
+    return (x >= n.cx ? 1 : 0) | (y >= n.cy ? 2 : 0) | (z >= n.cz ? 4 : 0);
+}
+
+void BarnesHutTree::build(const double* x, const double* y, const double* z, const double* mass, int n) {
+    px = x; py = y; pz = z; pm = mass;
+    nodes.clear();
+    nextInLeaf.assign(n, -1);
+    if (n == 0) return;
+
+    // Bounding cube of all bodies
+    double minX = x[0], maxX = x[0], minY = y[0], maxY = y[0], minZ = z[0], maxZ = z[0];
+    for (int i = 1; i < n; ++i) {
+        minX = fmin(minX, x[i]); maxX = fmax(maxX, x[i]);
+        minY = fmin(minY, y[i]); maxY = fmax(maxY, y[i]);
+        minZ = fmin(minZ, z[i]); maxZ = fmax(maxZ, z[i]);
+    }
+    double half = 0.5 * fmax(maxX - minX, fmax(maxY - minY, maxZ - minZ)) + 1e-6;
+    nodes.reserve(n / 2 + 16);
+    newNode(0.5 * (minX + maxX), 0.5 * (minY + maxY), 0.5 * (minZ + maxZ), half);
+
+    for (int i = 0; i < n; ++i)
+        insert(i);
+    summarize(0);
+}
+
+void BarnesHutTree::insert(int body) {
+    int node = 0;
+    int depth = 0;
+    // Walk down to the leaf that holds this position
+    while (!nodes[node].isLeaf) {
+        int oct = octantOf(nodes[node], px[body], py[body], pz[body]);
+        int child = nodes[node].children[oct];
+        if (child < 0) {
+            double h = nodes[node].halfSize * 0.5;
+            child = newNode(nodes[node].cx + ((oct & 1) ? h : -h),
+                            nodes[node].cy + ((oct & 2) ? h : -h),
+                            nodes[node].cz + ((oct & 4) ? h : -h), h);
+            nodes[node].children[oct] = child;
+        }
+        node = child;
+        ++depth;
+    }
+
+    // Add to the leaf's body list
+    nextInLeaf[body] = nodes[node].firstBody;
+    nodes[node].firstBody = body;
+    nodes[node].bodyCount++;
+    if (nodes[node].bodyCount <= leafCapacity || depth >= MAX_DEPTH) return;
+
+    // Leaf overflowed: turn it into an internal node and push its bodies down
+    int list = nodes[node].firstBody;
+    nodes[node].firstBody = -1;
+    nodes[node].bodyCount = 0;
+    nodes[node].isLeaf = false;
+    while (list >= 0) {
+        int next = nextInLeaf[list];
+        insert(list);
+        list = next;
+    }
+}
+
+void BarnesHutTree::summarize(int index) {
+    OctreeNode& node = nodes[index];
+    double m = 0.0, mx = 0.0, my = 0.0, mz = 0.0;
+    if (node.isLeaf) {
+        for (int b = node.firstBody; b >= 0; b = nextInLeaf[b]) {
+            m += pm[b];
+            mx += pm[b] * px[b];
+            my += pm[b] * py[b];
+            mz += pm[b] * pz[b];
+        }
+    }
+    else {
+        for (int c = 0; c < 8; ++c) {
+            int child = node.children[c];
+            if (child < 0) continue;
+            summarize(child);
+            const OctreeNode& ch = nodes[child];
+            m += ch.mass;
+            mx += ch.mass * ch.comX;
+            my += ch.mass * ch.comY;
+            mz += ch.mass * ch.comZ;
+        }
+    }
+    node.mass = m;
+    if (m > 0.0) {
+        node.comX = mx / m; node.comY = my / m; node.comZ = mz / m;
+    }
+    else {
+        node.comX = node.cx; node.comY = node.cy; node.comZ = node.cz;
+    }
+}
+
+void BarnesHutTree::acceleration(int i, double& ax, double& ay, double& az) const {
+    ax = ay = az = 0.0;
+    if (nodes.empty()) return;
+
+    const double eps2 = softening * softening;
+    const double theta2 = theta * theta;
+    const double xi = px[i], yi = py[i], zi = pz[i];
+
+    int stack[8 * MAX_DEPTH + 8];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        const OctreeNode& node = nodes[stack[--top]];
+        if (node.mass <= 0.0) continue;
+
+        if (node.isLeaf) {
+            // Direct summation over the bodies in this leaf
+            for (int b = node.firstBody; b >= 0; b = nextInLeaf[b]) {
+                if (b == i || pm[b] <= 0.0) continue;
+                double dx = px[b] - xi, dy = py[b] - yi, dz = pz[b] - zi;
+                double r2 = dx * dx + dy * dy + dz * dz + eps2;
+                double inv = 1.0 / sqrt(r2);
+                double s = G * pm[b] * inv * inv * inv;
+                ax += dx * s; ay += dy * s; az += dz * s;
+            }
+            continue;
+        }
+
+        double dx = node.comX - xi, dy = node.comY - yi, dz = node.comZ - zi;
+        double d2 = dx * dx + dy * dy + dz * dz;
+        double size = 2.0 * node.halfSize;
+        if (size * size < theta2 * d2) {
+            // Far enough away: treat the whole cell as a point mass
+            double r2 = d2 + eps2;
+            double inv = 1.0 / sqrt(r2);
+            double s = G * node.mass * inv * inv * inv;
+            ax += dx * s; ay += dy * s; az += dz * s;
+        }
+        else {
+            // Too close: open the cell
+            for (int c = 0; c < 8; ++c)
+                if (node.children[c] >= 0) stack[top++] = node.children[c];
+        }
+    }
+}
+
+void BarnesHutTree::accelerations(int begin, int end, double* ax, double* ay, double* az) const {
+    for (int i = begin; i < end; ++i)
+        acceleration(i, ax[i], ay[i], az[i]);
+}
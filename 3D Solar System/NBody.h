@@ -0,0 +1,50 @@
+// Gravitational N-body force evaluation using a Barnes-Hut octree
+#pragma once
+
+#include <vector>
+
+// Node of the Barnes-Hut octree (stored in a flat array)
+struct OctreeNode {
+    double cx, cy, cz;       // Geometric center of the cube
+    double halfSize;         // Half the edge length of the cube
+    double mass;             // Total mass inside the cube
+    double comX, comY, comZ; // Center of mass
+    int children[8];         // Child node indices (-1 when absent)
+    int firstBody;           // First body in this leaf (-1 for none or internal nodes)
+    int bodyCount;           // Number of bodies stored in this leaf
+    bool isLeaf;             // True until the node is split
+};
+
+// Barnes-Hut octree built over a set of bodies each step
+class BarnesHutTree {
+public:
+    BarnesHutTree();
+
+    // Rebuild the tree over n bodies (positions and masses in structure-of-arrays form)
+    void build(const double* x, const double* y, const double* z, const double* mass, int n);
+
+    // Gravitational acceleration at body i from every other body in the tree
+    void acceleration(int i, double& ax, double& ay, double& az) const;
+
+    // Compute accelerations for bodies in the range [begin, end)
+    void accelerations(int begin, int end, double* ax, double* ay, double* az) const;
+
+    double theta;       // Opening angle: smaller is more accurate, larger is faster
+    double softening;   // Plummer softening length to avoid singular close encounters
+    double G;           // Gravitational constant in scene units
+    int leafCapacity;   // Bodies stored in a leaf before it is split
+
+    int nodeCount() const { return (int)nodes.size(); }
+
+private:
+    int newNode(double cx, double cy, double cz, double halfSize);
+    void insert(int body);
+    void summarize(int node);  // Compute mass and center of mass bottom-up
+
+    std::vector<OctreeNode> nodes;
+    std::vector<int> nextInLeaf;  // Linked list of bodies sharing a leaf
+    const double* px;             // Body arrays from the last build()
+    const double* py;
+    const double* pz;
+    const double* pm;
+};
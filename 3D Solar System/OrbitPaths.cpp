@@ -0,0 +1,99 @@
+// Orbit paths drawn from one shared unit-circle buffer, scaled per orbit
+#include "OrbitPaths.h"
+#include "GLExtensions.h"     // Buffer objects
+#include <math.h>             // sin, cos, sqrt
+#include <vector>
+
+static const double ORBIT_PI = 3.141592653589793;
+static const int ORBIT_SEGMENTS = 360;  // Vertices in the shared circle
+
+static GLuint circleBuffer = 0;              // Unit circle in the XZ plane
+static std::vector<float> circleVertices;    // Client copy when buffers are unavailable
+
+// Cached column-major transform that maps the unit circle onto each orbit
+struct OrbitTransform {
+    float matrix[16];
+    float center[3];  // Position of the body being orbited
+    bool active;      // False for indices without an orbit (e.g. the Sun)
+};
+static std::vector<OrbitTransform> orbitTransforms;
+
+void initOrbitPaths() {
+    circleVertices.resize(ORBIT_SEGMENTS * 3);
+    for (int i = 0; i < ORBIT_SEGMENTS; ++i) {
+        double angle = 2.0 * ORBIT_PI * i / ORBIT_SEGMENTS;
+        circleVertices[i * 3 + 0] = (float)cos(angle);
+        circleVertices[i * 3 + 1] = 0.0f;
+        circleVertices[i * 3 + 2] = (float)sin(angle);
+    }
+    if (hasVertexBuffers) {
+        glGenBuffers(1, &circleBuffer);
+        glBindBuffer(GL_ARRAY_BUFFER, circleBuffer);
+        glBufferData(GL_ARRAY_BUFFER, circleVertices.size() * sizeof(float), circleVertices.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        std::vector<float>().swap(circleVertices);
+    }
+}
+
+void setOrbitPath(int idx, const OrbitalElements& orbit) {
+    if (idx >= (int)orbitTransforms.size()) orbitTransforms.resize(idx + 1);
+
+    double P[3], Q[3];
+    orbitalBasis(orbit, P, Q);
+    double a = orbit.semiMajor;
+    double b = a * sqrt(1.0 - orbit.eccentricity * orbit.eccentricity);
+    double N[3] = { P[1] * Q[2] - P[2] * Q[1], P[2] * Q[0] - P[0] * Q[2], P[0] * Q[1] - P[1] * Q[0] };
+
+    // Circle vertex (cos t, 0, sin t) with t = E + 90 degrees lands on the ellipse point for E
+    float* m = orbitTransforms[idx].matrix;
+    for (int r = 0; r < 3; ++r) {
+        m[0 + r] = (float)(-b * Q[r]);                     // Column 0: circle X
+        m[4 + r] = (float)N[r];                            // Column 1: orbit normal
+        m[8 + r] = (float)(a * P[r]);                      // Column 2: circle Z
+        m[12 + r] = (float)(-a * orbit.eccentricity * P[r]);  // Sun sits at a focus
+    }
+    m[3] = m[7] = m[11] = 0.0f;
+    m[15] = 1.0f;
+    orbitTransforms[idx].active = true;
+}
+
+void setOrbitCenter(int idx, float x, float y, float z) {
+    if (idx >= (int)orbitTransforms.size()) return;
+    float* c = orbitTransforms[idx].center;
+    c[0] = x; c[1] = y; c[2] = z;
+}
+
+void drawOrbitPaths() {
+    if (orbitTransforms.empty()) return;
+
+    // Save current OpenGL state
+    glPushAttrib(GL_ENABLE_BIT | GL_CURRENT_BIT | GL_LINE_BIT);
+    glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
+    glDisable(GL_LIGHTING);      // Orbits don't need lighting
+    glColor3f(1.0f, 1.0f, 1.0f);  // White orbit rings
+    glLineWidth(1.5f);           // Set line width
+    glEnable(GL_LINE_SMOOTH);    // Anti-aliased lines
+
+    // Bind the shared circle once, then one transform and draw per orbit
+    glEnableClientState(GL_VERTEX_ARRAY);
+    if (circleBuffer) {
+        glBindBuffer(GL_ARRAY_BUFFER, circleBuffer);
+        glVertexPointer(3, GL_FLOAT, 0, BUFFER_OFFSET(0));
+    }
+    else {
+        glVertexPointer(3, GL_FLOAT, 0, circleVertices.data());
+    }
+    for (const auto& orbit : orbitTransforms) {
+        if (!orbit.active) continue;
+        glPushMatrix();
+        glTranslatef(orbit.center[0], orbit.center[1], orbit.center[2]);
+        glMultMatrixf(orbit.matrix);
+        glDrawArrays(GL_LINE_LOOP, 0, ORBIT_SEGMENTS);
+        glPopMatrix();
+    }
+    if (circleBuffer) glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    // Restore OpenGL state
+    glPopClientAttrib();
+    glPopAttrib();
+}
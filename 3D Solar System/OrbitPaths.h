@@ -0,0 +1,16 @@
+// Orbit paths drawn from one shared unit-circle buffer, scaled per orbit
+#pragma once
+
+#include "Kepler.h"           // OrbitalElements, orbitalBasis
+
+// Build the shared unit-circle buffer (call once after the GL context exists)
+void initOrbitPaths();
+
+// Set (or change) the shape of orbit idx; only this rebuilds its transform
+void setOrbitPath(int idx, const OrbitalElements& orbit);
+
+// Move the focus of orbit idx (the origin by default), e.g. to a moon's parent
+void setOrbitCenter(int idx, float x, float y, float z);
+
+// Draw every registered orbit path
+void drawOrbitPaths();
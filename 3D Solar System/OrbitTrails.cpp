@@ -0,0 +1,221 @@
+// Orbit trails: per-body sample rings in one streamed vertex buffer
+#include "OrbitTrails.h"
+#include "GLExtensions.h"     // Buffer objects, glMultiDrawElements
+#include <algorithm>          // min, max
+#include <string.h>           // memcpy
+#include <vector>
+
+// Define GL_CLAMP_TO_EDGE if not already defined by the system
+#ifndef GL_CLAMP_TO_EDGE
+#define GL_CLAMP_TO_EDGE 0x812F
+#endif
+
+static const int FADE_TEXELS = 64;  // Resolution of the age fade
+
+// Layout: slot s of trail b is vertex s * bodies + b, so one sample of every body is one
+// contiguous row and adding a sample is one small upload. Each trail has 2 * length slots and
+// sample k goes to rows k % length and k % length + length, so the newest samples are always
+// contiguous in slot order and each trail is a single line strip.
+static std::vector<int> trailBodies;   // Simulation index of each trail
+static int trailLength = 0;            // Samples kept per trail
+static int trailDecimation = 1;        // Fixed steps between samples
+static long long sampleTotal = 0;      // Samples recorded since init
+static long long uploadedTotal = 0;    // Samples already sent to the vertex buffer
+static long long lastSampleStep = -1;  // Simulation step of the newest sample (-1 = none yet)
+static int lastUploadBytes = 0;
+
+static std::vector<float> vertices;    // Client copy of every row, the source of each upload
+static std::vector<GLuint> indices;    // Each trail's slots in order (client copy when buffers are unavailable)
+static std::vector<float> fadeCoords;  // Per vertex, its slot / length (likewise)
+static GLuint vertexBuffer = 0, indexBuffer = 0, coordBuffer = 0;
+static GLuint fadeTexture = 0;         // 1D alpha ramp from transparent to opaque
+
+// Per-trail arguments of the batched draw
+static std::vector<GLsizei> drawCounts;
+static std::vector<const void*> drawOffsets;
+
+void initOrbitTrails(const int* bodyIndices, int bodyCount, int length, int decimation) {
+    trailBodies.assign(bodyIndices, bodyIndices + bodyCount);
+    trailLength = std::max(length, 2);
+    trailDecimation = std::max(decimation, 1);
+    sampleTotal = uploadedTotal = 0;
+    lastSampleStep = -1;
+    lastUploadBytes = 0;
+    drawCounts.resize(bodyCount);
+    drawOffsets.resize(bodyCount);
+
+    const int slots = 2 * trailLength;
+    vertices.assign((size_t)slots * bodyCount * 3, 0.0f);
+    indices.resize((size_t)slots * bodyCount);
+    fadeCoords.resize((size_t)slots * bodyCount);
+    for (int b = 0; b < bodyCount; ++b) {
+        for (int s = 0; s < slots; ++s) {
+            indices[(size_t)b * slots + s] = (GLuint)(s * bodyCount + b);
+            fadeCoords[(size_t)s * bodyCount + b] = (float)s / trailLength;
+        }
+    }
+
+    if (hasVertexBuffers) {
+        if (!vertexBuffer) {
+            glGenBuffers(1, &vertexBuffer);
+            glGenBuffers(1, &coordBuffer);
+            glGenBuffers(1, &indexBuffer);
+        }
+        // Positions are rewritten a row at a time; the rest never changes
+        glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), 0, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, coordBuffer);
+        glBufferData(GL_ARRAY_BUFFER, fadeCoords.size() * sizeof(float), fadeCoords.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        std::vector<GLuint>().swap(indices);
+        std::vector<float>().swap(fadeCoords);
+    }
+
+    if (!fadeTexture) {
+        GLubyte ramp[FADE_TEXELS];
+        for (int t = 0; t < FADE_TEXELS; ++t) ramp[t] = (GLubyte)(255 * t / (FADE_TEXELS - 1));
+        glGenTextures(1, &fadeTexture);
+        glBindTexture(GL_TEXTURE_1D, fadeTexture);
+        glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexImage1D(GL_TEXTURE_1D, 0, GL_ALPHA, FADE_TEXELS, 0, GL_ALPHA, GL_UNSIGNED_BYTE, ramp);
+        glBindTexture(GL_TEXTURE_1D, 0);
+    }
+}
+
+void recordOrbitTrails(const Simulation& sim) {
+    long long step = sim.stepCount();
+    if (trailBodies.empty() || (lastSampleStep >= 0 && step - lastSampleStep < trailDecimation)) return;
+    lastSampleStep = step;
+
+    const int count = (int)trailBodies.size();
+    float* row = &vertices[(size_t)(sampleTotal % trailLength) * count * 3];
+    for (int b = 0; b < count; ++b) {
+        int i = trailBodies[b];
+        row[b * 3 + 0] = (float)sim.posX[i];
+        row[b * 3 + 1] = (float)sim.posY[i];
+        row[b * 3 + 2] = (float)sim.posZ[i];
+    }
+    memcpy(row + (size_t)trailLength * count * 3, row, count * 3 * sizeof(float));  // Second copy
+    ++sampleTotal;
+}
+
+// Send rows [first, first + rows) of the client copy to the bound vertex buffer
+static void uploadRows(int first, int rows) {
+    const size_t rowFloats = trailBodies.size() * 3;
+    glBufferSubData(GL_ARRAY_BUFFER, first * rowFloats * sizeof(float), rows * rowFloats * sizeof(float),
+                    &vertices[first * rowFloats]);
+    lastUploadBytes += (int)(rows * rowFloats * sizeof(float));
+}
+
+void drawOrbitTrails(const BodySnapshot& bodies) {
+    lastUploadBytes = 0;
+    const int count = (int)trailBodies.size();
+    if (count == 0 || sampleTotal == 0) return;
+
+    // Draw up to length - 1 recorded samples, then one row holding the displayed positions.
+    // Once the ring is full that row is the second copy of the oldest sample, which is dropped.
+    int first, recorded;
+    if (sampleTotal < trailLength) {
+        first = 0;
+        recorded = (int)sampleTotal;
+    }
+    else {
+        first = (int)(sampleTotal % trailLength) + 1;
+        recorded = trailLength - 1;
+    }
+    const int head = first + recorded;
+    float* row = &vertices[(size_t)head * count * 3];
+    for (int b = 0; b < count; ++b) {
+        int i = trailBodies[b];
+        row[b * 3 + 0] = bodies.x[i];
+        row[b * 3 + 1] = bodies.y[i];
+        row[b * 3 + 2] = bodies.z[i];
+    }
+
+    if (vertexBuffer) {
+        // Only the samples added since the last draw (at most one ring's worth) and the head row
+        glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+        for (long long k = std::max(uploadedTotal, sampleTotal - trailLength); k < sampleTotal;) {
+            int slot = (int)(k % trailLength);
+            int run = (int)std::min<long long>(sampleTotal - k, trailLength - slot);
+            uploadRows(slot, run);
+            uploadRows(slot + trailLength, run);
+            k += run;
+        }
+        uploadedTotal = sampleTotal;
+        uploadRows(head, 1);
+    }
+
+    // Save current OpenGL state
+    glPushAttrib(GL_ENABLE_BIT | GL_CURRENT_BIT | GL_LINE_BIT | GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_TEXTURE_BIT);
+    glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
+    glDisable(GL_LIGHTING);
+    glDisable(GL_TEXTURE_2D);
+    glEnable(GL_TEXTURE_1D);
+    glBindTexture(GL_TEXTURE_1D, fadeTexture);
+    glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glDepthMask(GL_FALSE);                  // Trails never hide what is drawn after them
+    glColor4f(0.45f, 0.75f, 1.0f, 0.9f);   // Pale blue, apart from the white orbit paths
+    glLineWidth(1.5f);
+    glEnable(GL_LINE_SMOOTH);
+
+    // Fade coordinates are slot / length; map the drawn slots onto 0 (oldest) to 1 (now)
+    glMatrixMode(GL_TEXTURE);
+    glPushMatrix();
+    glLoadIdentity();
+    glScalef((float)trailLength / std::max(recorded, 1), 1.0f, 1.0f);
+    glTranslatef(-(float)first / trailLength, 0.0f, 0.0f);
+    glMatrixMode(GL_MODELVIEW);
+
+    const int slots = 2 * trailLength;
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    if (vertexBuffer) {
+        glBindBuffer(GL_ARRAY_BUFFER, coordBuffer);
+        glTexCoordPointer(1, GL_FLOAT, 0, BUFFER_OFFSET(0));
+        glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+        glVertexPointer(3, GL_FLOAT, 0, BUFFER_OFFSET(0));
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+        for (int b = 0; b < count; ++b) drawOffsets[b] = BUFFER_OFFSET(((size_t)b * slots + first) * sizeof(GLuint));
+    }
+    else {
+        glTexCoordPointer(1, GL_FLOAT, 0, fadeCoords.data());
+        glVertexPointer(3, GL_FLOAT, 0, vertices.data());
+        for (int b = 0; b < count; ++b) drawOffsets[b] = &indices[(size_t)b * slots + first];
+    }
+    std::fill(drawCounts.begin(), drawCounts.end(), recorded + 1);
+
+    // Every trail in one call where the driver offers it
+    if (glMultiDrawElements) {
+        glMultiDrawElements(GL_LINE_STRIP, drawCounts.data(), GL_UNSIGNED_INT, drawOffsets.data(), count);
+    }
+    else {
+        for (int b = 0; b < count; ++b) glDrawElements(GL_LINE_STRIP, drawCounts[b], GL_UNSIGNED_INT, drawOffsets[b]);
+    }
+    if (vertexBuffer) {
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    }
+
+    // Restore OpenGL state
+    glMatrixMode(GL_TEXTURE);
+    glPopMatrix();
+    glMatrixMode(GL_MODELVIEW);
+    glPopClientAttrib();
+    glPopAttrib();
+}
+
+void getOrbitTrailStats(TrailStats& stats) {
+    const size_t vertexCount = (size_t)2 * trailLength * trailBodies.size();
+    stats.bodies = (int)trailBodies.size();
+    stats.samples = (int)std::min<long long>(sampleTotal, trailLength - 1);
+    stats.bufferBytes = (int)(vertexCount * (3 * sizeof(float) + sizeof(float) + sizeof(GLuint)));
+    stats.uploadBytes = lastUploadBytes;
+}
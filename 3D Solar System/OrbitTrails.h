@@ -0,0 +1,26 @@
+// Trails of where bodies have actually been: a fixed ring of samples per body, streamed to one
+// vertex buffer and drawn with one call
+#pragma once
+
+#include "Simulation.h"       // Simulation, BodySnapshot
+
+// Memory held and data sent by the trails
+struct TrailStats {
+    int bodies;         // Bodies with a trail
+    int samples;        // Samples drawn in each trail (up to length - 1, plus the current position)
+    int bufferBytes;    // Vertex buffer size, fixed at init
+    int uploadBytes;    // Bytes sent for the last drawn frame
+};
+
+// Keep length samples for each listed simulation body, one every decimation fixed steps.
+// Call after the GL context exists; calling again starts empty trails.
+void initOrbitTrails(const int* bodyIndices, int bodyCount, int length, int decimation);
+
+// Sample the simulation when decimation steps have passed since the last sample
+void recordOrbitTrails(const Simulation& sim);
+
+// Upload the samples added since the last draw and draw every trail, fading with age and
+// ending at the displayed positions
+void drawOrbitTrails(const BodySnapshot& bodies);
+
+void getOrbitTrailStats(TrailStats& stats);
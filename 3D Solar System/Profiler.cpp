@@ -0,0 +1,224 @@
+// Per-phase frame profiler: scoped CPU timers, GL timer queries, rolling statistics and trace export
+#include "Profiler.h"
+#include "GLExtensions.h"     // Timer queries
+#include <stdio.h>            // CSV and JSON output
+#include <algorithm>          // sort
+#include <chrono>             // CPU timers
+#include <vector>
+
+static const int HISTORY = 240;      // Frames in the rolling statistics window (4 s at 60 FPS)
+static const int QUERY_FRAMES = 4;   // GPU results are read this many frames later, so we never stall
+
+static const char* PHASE_NAMES[PHASE_COUNT] = {
+    "frame", "simulation", "visibility", "streaming", "background", "stars",
+    "orbits", "submit", "bodies", "overlay", "present"
+};
+
+// Timings of one frame; GPU values stay negative until their queries resolve
+struct FrameRecord {
+    double startMs;                    // Frame start since the profiler started
+    double cpuStartMs[PHASE_COUNT];    // First entry into each phase, relative to the frame start
+    double cpuMs[PHASE_COUNT];
+    double gpuStartMs[PHASE_COUNT];    // Relative to the GPU frame start
+    double gpuMs[PHASE_COUNT];
+};
+
+static const std::chrono::steady_clock::time_point profileEpoch = std::chrono::steady_clock::now();
+static FrameRecord history[HISTORY];     // Ring of recent frames for statistics
+static std::vector<FrameRecord> records; // Every frame since recording was enabled
+static bool recording = false;
+static int recordBase = 0;               // Frame number of records[0]
+static int frameNumber = -1;             // Current frame (-1 before the first)
+static bool inFrame = false;
+static double phaseBegin[PHASE_COUNT];   // CPU time each open phase started
+
+// GPU timestamps: a begin/end pair per phase for each frame in flight
+static bool useQueries = false;
+static GLuint queries[QUERY_FRAMES][PHASE_COUNT][2];
+static bool queryIssued[QUERY_FRAMES][PHASE_COUNT];
+static int queryFrame[QUERY_FRAMES];     // Frame that owns each query slot (-1 for none)
+
+static double nowMs() {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - profileEpoch).count();
+}
+
+// Record for a frame if it is still held anywhere (history or export)
+static FrameRecord* findRecord(int frame, bool inHistory) {
+    if (inHistory) return (frameNumber - frame < HISTORY) ? &history[frame % HISTORY] : 0;
+    int index = frame - recordBase;
+    return (recording && index >= 0 && index < (int)records.size()) ? &records[index] : 0;
+}
+
+// Collect the results of a query slot into the frame that issued it
+static void resolveQueries(int slot) {
+    int frame = queryFrame[slot];
+    if (frame < 0) return;
+    GLuint64 frameBegin = 0;
+    if (queryIssued[slot][PHASE_FRAME])
+        glGetQueryObjectui64v(queries[slot][PHASE_FRAME][0], GL_QUERY_RESULT, &frameBegin);
+
+    FrameRecord* targets[2] = { findRecord(frame, true), findRecord(frame, false) };
+    for (int p = 0; p < PHASE_COUNT; ++p) {
+        if (!queryIssued[slot][p]) continue;
+        GLuint64 begin = 0, end = 0;
+        glGetQueryObjectui64v(queries[slot][p][0], GL_QUERY_RESULT, &begin);
+        glGetQueryObjectui64v(queries[slot][p][1], GL_QUERY_RESULT, &end);
+        for (int t = 0; t < 2; ++t) {
+            if (!targets[t]) continue;
+            targets[t]->gpuStartMs[p] = (double)(long long)(begin - frameBegin) * 1e-6;
+            targets[t]->gpuMs[p] = (double)(end - begin) * 1e-6;
+        }
+        queryIssued[slot][p] = false;
+    }
+    queryFrame[slot] = -1;
+}
+
+void initProfiler() {
+    if (useQueries || !hasTimerQueries) return;
+    glGenQueries(QUERY_FRAMES * PHASE_COUNT * 2, &queries[0][0][0]);
+    for (int s = 0; s < QUERY_FRAMES; ++s) {
+        queryFrame[s] = -1;
+        for (int p = 0; p < PHASE_COUNT; ++p) queryIssued[s][p] = false;
+    }
+    useQueries = true;
+}
+
+bool hasGpuTimings() {
+    return useQueries;
+}
+
+void beginProfileFrame() {
+    ++frameNumber;
+    inFrame = true;
+    FrameRecord& rec = history[frameNumber % HISTORY];
+    rec.startMs = nowMs();
+    for (int p = 0; p < PHASE_COUNT; ++p) {
+        rec.cpuStartMs[p] = rec.gpuStartMs[p] = 0.0;
+        rec.cpuMs[p] = 0.0;
+        rec.gpuMs[p] = -1.0;
+    }
+    if (useQueries) resolveQueries(frameNumber % QUERY_FRAMES);  // Results from QUERY_FRAMES ago
+    beginPhase(PHASE_FRAME);
+}
+
+void endProfileFrame() {
+    if (!inFrame) return;
+    endPhase(PHASE_FRAME);
+    inFrame = false;
+    if (useQueries) queryFrame[frameNumber % QUERY_FRAMES] = frameNumber;
+    if (recording) {
+        if (records.empty()) recordBase = frameNumber;
+        records.push_back(history[frameNumber % HISTORY]);
+    }
+}
+
+void beginPhase(ProfilePhase phase) {
+    if (!inFrame) return;
+    FrameRecord& rec = history[frameNumber % HISTORY];
+    phaseBegin[phase] = nowMs();
+    if (rec.cpuMs[phase] == 0.0) rec.cpuStartMs[phase] = phaseBegin[phase] - rec.startMs;
+    if (useQueries) {
+        int slot = frameNumber % QUERY_FRAMES;
+        // Only the first entry of a phase is timed on the GPU
+        if (!queryIssued[slot][phase]) glQueryCounter(queries[slot][phase][0], GL_TIMESTAMP);
+    }
+}
+
+void endPhase(ProfilePhase phase) {
+    if (!inFrame) return;
+    history[frameNumber % HISTORY].cpuMs[phase] += nowMs() - phaseBegin[phase];
+    if (useQueries) {
+        int slot = frameNumber % QUERY_FRAMES;
+        if (!queryIssued[slot][phase]) {
+            glQueryCounter(queries[slot][phase][1], GL_TIMESTAMP);
+            queryIssued[slot][phase] = true;
+        }
+    }
+}
+
+const char* phaseName(ProfilePhase phase) {
+    return PHASE_NAMES[phase];
+}
+
+void summarizeSamples(double* samples, int count, PhaseStats& out) {
+    out.count = count;
+    out.mean = out.p50 = out.p99 = 0.0;
+    if (count <= 0) return;
+    std::sort(samples, samples + count);
+    double sum = 0.0;
+    for (int i = 0; i < count; ++i) sum += samples[i];
+    out.mean = sum / count;
+    out.p50 = samples[count / 2];
+    out.p99 = samples[std::min(count - 1, (int)(count * 0.99))];
+}
+
+void getPhaseStats(ProfilePhase phase, PhaseStats& cpu, PhaseStats& gpu) {
+    // Completed frames only (the current one is still being timed)
+    int last = inFrame ? frameNumber - 1 : frameNumber;
+    int count = std::min(last + 1, HISTORY);
+    std::vector<double> cpuSamples, gpuSamples;
+    cpuSamples.reserve(count);
+    gpuSamples.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        const FrameRecord& rec = history[(last - i) % HISTORY];
+        cpuSamples.push_back(rec.cpuMs[phase]);
+        if (rec.gpuMs[phase] >= 0.0) gpuSamples.push_back(rec.gpuMs[phase]);
+    }
+    summarizeSamples(cpuSamples.data(), (int)cpuSamples.size(), cpu);
+    summarizeSamples(gpuSamples.data(), (int)gpuSamples.size(), gpu);
+}
+
+void setProfileRecording(bool enabled) {
+    recording = enabled;
+    if (!enabled) records.clear();
+}
+
+void resolveProfileQueries() {
+    if (!useQueries) return;
+    for (int i = 1; i <= QUERY_FRAMES; ++i)
+        resolveQueries((frameNumber + i) % QUERY_FRAMES);
+}
+
+bool writeProfileCSV(const char* path) {
+    FILE* out = fopen(path, "w");
+    if (!out) return false;
+    fprintf(out, "frame,start_ms");
+    for (int p = 0; p < PHASE_COUNT; ++p)
+        fprintf(out, ",%s_cpu_ms,%s_gpu_ms", PHASE_NAMES[p], PHASE_NAMES[p]);
+    fprintf(out, "\n");
+    for (size_t i = 0; i < records.size(); ++i) {
+        const FrameRecord& rec = records[i];
+        fprintf(out, "%d,%.3f", recordBase + (int)i, rec.startMs);
+        for (int p = 0; p < PHASE_COUNT; ++p) {
+            fprintf(out, ",%.4f,", rec.cpuMs[p]);
+            if (rec.gpuMs[p] >= 0.0) fprintf(out, "%.4f", rec.gpuMs[p]);  // Blank when unavailable
+        }
+        fprintf(out, "\n");
+    }
+    fclose(out);
+    return true;
+}
+
+bool writeProfileTrace(const char* path) {
+    FILE* out = fopen(path, "w");
+    if (!out) return false;
+    // Complete ("X") events in microseconds; CPU phases on one track, GPU phases on another
+    fprintf(out, "{\"traceEvents\":[\n");
+    fprintf(out, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"CPU\"}},\n");
+    fprintf(out, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"GPU\"}}");
+    for (size_t i = 0; i < records.size(); ++i) {
+        const FrameRecord& rec = records[i];
+        for (int p = 0; p < PHASE_COUNT; ++p) {
+            if (rec.cpuMs[p] > 0.0)
+                fprintf(out, ",\n{\"name\":\"%s\",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.1f,\"dur\":%.1f}",
+                        PHASE_NAMES[p], (rec.startMs + rec.cpuStartMs[p]) * 1000.0, rec.cpuMs[p] * 1000.0);
+            // GPU work is placed relative to the CPU frame start (the clocks are not synchronized)
+            if (rec.gpuMs[p] >= 0.0)
+                fprintf(out, ",\n{\"name\":\"%s\",\"cat\":\"gpu\",\"ph\":\"X\",\"pid\":1,\"tid\":2,\"ts\":%.1f,\"dur\":%.1f}",
+                        PHASE_NAMES[p], (rec.startMs + rec.gpuStartMs[p]) * 1000.0, rec.gpuMs[p] * 1000.0);
+        }
+    }
+    fprintf(out, "\n]}\n");
+    fclose(out);
+    return true;
+}
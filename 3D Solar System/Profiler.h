@@ -0,0 +1,61 @@
+// Per-phase frame profiler: scoped CPU timers, GL timer queries, rolling statistics and trace export
+#pragma once
+
+// Timed sections of a frame (PHASE_FRAME spans the whole frame)
+enum ProfilePhase {
+    PHASE_FRAME,
+    PHASE_SIMULATION,
+    PHASE_VISIBILITY,
+    PHASE_STREAMING,    // Virtual texture tile selection and uploads
+    PHASE_BACKGROUND,
+    PHASE_STARS,
+    PHASE_ORBITS,
+    PHASE_SUBMIT,       // Recording body draw commands
+    PHASE_BODIES,       // Sorted execution of the draw commands
+    PHASE_OVERLAY,
+    PHASE_PRESENT,
+    PHASE_COUNT
+};
+
+// Rolling statistics over recent frames, in milliseconds (count is 0 when there is no data)
+struct PhaseStats {
+    int count;
+    double mean, p50, p99;
+};
+
+// Create the GPU timer queries; call once after loadGLExtensions(). Without it only CPU times are kept.
+void initProfiler();
+
+// Bracket every frame; phases are only recorded between these
+void beginProfileFrame();
+void endProfileFrame();
+
+// Bracket one phase of the current frame (a phase entered twice accumulates)
+void beginPhase(ProfilePhase phase);
+void endPhase(ProfilePhase phase);
+
+// Times the enclosing block as one phase
+struct ProfileScope {
+    explicit ProfileScope(ProfilePhase p) : phase(p) { beginPhase(p); }
+    ~ProfileScope() { endPhase(phase); }
+    ProfilePhase phase;
+};
+
+const char* phaseName(ProfilePhase phase);
+bool hasGpuTimings();  // True when timer queries are running
+
+// Mean, median and 99th percentile of a phase over the recent frame window
+void getPhaseStats(ProfilePhase phase, PhaseStats& cpu, PhaseStats& gpu);
+
+// Mean, median and 99th percentile of count samples (sorts them in place)
+void summarizeSamples(double* samples, int count, PhaseStats& out);
+
+// Keep every frame for export (off by default so long sessions don't grow without bound)
+void setProfileRecording(bool enabled);
+
+// Wait for the GPU results still in flight (needs the GL context; call before it is destroyed)
+void resolveProfileQueries();
+
+// Write the recorded frames as CSV (one row per frame) or Chrome trace JSON (chrome://tracing)
+bool writeProfileCSV(const char* path);
+bool writeProfileTrace(const char* path);
@@ -0,0 +1,182 @@
+// Shadowed GL render state and a state-sorted draw command list
+#include "RenderState.h"
+#include <algorithm>          // stable_sort
+#include <string.h>           // memcmp, memcpy
+#include <vector>
+
+// Capabilities we shadow; anything else passes straight through
+static const GLenum TRACKED_CAPS[] = {
+    GL_LIGHTING, GL_DEPTH_TEST, GL_TEXTURE_1D, GL_TEXTURE_2D, GL_BLEND, GL_CULL_FACE
+};
+static const int CAP_COUNT = sizeof(TRACKED_CAPS) / sizeof(TRACKED_CAPS[0]);
+
+// Material parameters we shadow (front face)
+static const GLenum TRACKED_MATERIALS[] = { GL_AMBIENT_AND_DIFFUSE, GL_SPECULAR, GL_EMISSION, GL_SHININESS };
+static const int MATERIAL_COUNT = sizeof(TRACKED_MATERIALS) / sizeof(TRACKED_MATERIALS[0]);
+
+// Shadow copy of GL state; "known" flags are cleared at the start of every frame
+static signed char capState[CAP_COUNT];           // -1 unknown, 0 off, 1 on
+static GLuint boundTexture[2];                    // 1D, 2D
+static bool textureKnown[2];
+static GLfloat material[MATERIAL_COUNT][4];
+static bool materialKnown[MATERIAL_COUNT];
+static GLfloat currentColor[4];
+static bool colorKnown;
+static GLenum blendSource, blendDestination;
+static bool blendKnown;
+static signed char depthWrite;                    // -1 unknown
+static GLint textureMode;
+static bool textureModeKnown;
+static GLfloat pointSize;
+static bool pointSizeKnown;
+
+static RenderStateStats frameStats = { 0, 0 };    // Current frame
+static RenderStateStats lastStats = { 0, 0 };     // Last completed frame
+
+// One recorded draw
+struct DrawCommand {
+    unsigned long long key;
+    DrawCallback draw;
+    int item;
+};
+static std::vector<DrawCommand> drawList;
+
+void beginRenderStateFrame() {
+    lastStats = frameStats;
+    frameStats.issued = frameStats.elided = 0;
+    // Code outside the tracker may have changed anything since last frame
+    for (int i = 0; i < CAP_COUNT; ++i) capState[i] = -1;
+    textureKnown[0] = textureKnown[1] = false;
+    for (int i = 0; i < MATERIAL_COUNT; ++i) materialKnown[i] = false;
+    colorKnown = blendKnown = textureModeKnown = pointSizeKnown = false;
+    depthWrite = -1;
+}
+
+RenderStateStats getRenderStateStats() {
+    return lastStats;
+}
+
+// Count a change and report whether it must be issued
+static bool changed(bool same) {
+    if (same) {
+        frameStats.elided++;
+        return false;
+    }
+    frameStats.issued++;
+    return true;
+}
+
+void setCapability(GLenum cap, bool enabled) {
+    int index = 0;
+    while (index < CAP_COUNT && TRACKED_CAPS[index] != cap) ++index;
+    if (index < CAP_COUNT) {
+        if (!changed(capState[index] == (enabled ? 1 : 0))) return;
+        capState[index] = enabled ? 1 : 0;
+    }
+    else {
+        frameStats.issued++;
+    }
+    if (enabled) glEnable(cap);
+    else glDisable(cap);
+}
+
+void bindTexture(GLenum target, GLuint texture) {
+    int index = (target == GL_TEXTURE_1D) ? 0 : 1;
+    if (!changed(textureKnown[index] && boundTexture[index] == texture)) return;
+    boundTexture[index] = texture;
+    textureKnown[index] = true;
+    glBindTexture(target, texture);
+}
+
+void setMaterial(GLenum pname, const GLfloat* values) {
+    int index = 0;
+    while (index < MATERIAL_COUNT && TRACKED_MATERIALS[index] != pname) ++index;
+    if (index == MATERIAL_COUNT) {
+        frameStats.issued++;
+        glMaterialfv(GL_FRONT, pname, values);
+        return;
+    }
+    int components = (pname == GL_SHININESS) ? 1 : 4;
+    size_t bytes = components * sizeof(GLfloat);
+    if (!changed(materialKnown[index] && memcmp(material[index], values, bytes) == 0)) return;
+    memcpy(material[index], values, bytes);
+    materialKnown[index] = true;
+    glMaterialfv(GL_FRONT, pname, values);
+}
+
+void setColor(GLfloat r, GLfloat g, GLfloat b, GLfloat a) {
+    if (!changed(colorKnown && currentColor[0] == r && currentColor[1] == g &&
+                 currentColor[2] == b && currentColor[3] == a)) return;
+    currentColor[0] = r; currentColor[1] = g; currentColor[2] = b; currentColor[3] = a;
+    colorKnown = true;
+    glColor4f(r, g, b, a);
+}
+
+void setBlendFunc(GLenum source, GLenum destination) {
+    if (!changed(blendKnown && blendSource == source && blendDestination == destination)) return;
+    blendSource = source;
+    blendDestination = destination;
+    blendKnown = true;
+    glBlendFunc(source, destination);
+}
+
+void setDepthMask(bool write) {
+    if (!changed(depthWrite == (write ? 1 : 0))) return;
+    depthWrite = write ? 1 : 0;
+    glDepthMask(write ? GL_TRUE : GL_FALSE);
+}
+
+void setTextureMode(GLint mode) {
+    if (!changed(textureModeKnown && textureMode == mode)) return;
+    textureMode = mode;
+    textureModeKnown = true;
+    glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, mode);
+}
+
+void setPointSize(GLfloat size) {
+    if (!changed(pointSizeKnown && pointSize == size)) return;
+    pointSize = size;
+    pointSizeKnown = true;
+    glPointSize(size);
+}
+
+void setDefaultRenderState() {
+    static const GLfloat black[] = { 0.0f, 0.0f, 0.0f, 1.0f };
+    setCapability(GL_LIGHTING, true);
+    setCapability(GL_DEPTH_TEST, true);
+    setCapability(GL_TEXTURE_1D, false);
+    setCapability(GL_TEXTURE_2D, false);
+    setCapability(GL_BLEND, false);
+    setDepthMask(true);
+    setTextureMode(GL_MODULATE);
+    setMaterial(GL_EMISSION, black);
+}
+
+unsigned long long opaqueDrawKey(GLuint texture, MaterialSlot slot) {
+    return ((unsigned long long)(texture & 0xFFFFFF) << 32) | ((unsigned long long)slot << 16);
+}
+
+unsigned long long translucentDrawKey(float eyeDistance) {
+    // Non-negative floats order like their bit patterns; invert so far sorts first
+    unsigned int bits;
+    float d = eyeDistance > 0.0f ? eyeDistance : 0.0f;
+    memcpy(&bits, &d, sizeof(bits));
+    return (1ULL << 63) | (unsigned long long)(0xFFFFFFFFu - bits);
+}
+
+void submitDraw(unsigned long long key, DrawCallback draw, int item) {
+    DrawCommand command = { key, draw, item };
+    drawList.push_back(command);
+}
+
+void executeDrawList() {
+    // Commands rely on the default state for blending and depth writes
+    setDefaultRenderState();
+    // Stable, so draws with equal keys keep their submission order
+    std::stable_sort(drawList.begin(), drawList.end(),
+        [](const DrawCommand& a, const DrawCommand& b) { return a.key < b.key; });
+    for (size_t i = 0; i < drawList.size(); ++i)
+        drawList[i].draw(drawList[i].item);
+    drawList.clear();
+    setDefaultRenderState();
+}
@@ -0,0 +1,52 @@
+// Shadowed GL render state and a state-sorted draw command list
+#pragma once
+
+#include "GLExtensions.h"     // GL types
+
+// Material slots used in sort keys (draws with equal slots share material state)
+enum MaterialSlot {
+    MATERIAL_NONE,      // Unlit draws (points, rings)
+    MATERIAL_PLANET,    // Lit, textured planet surfaces
+    MATERIAL_SUN,       // Emissive
+    MATERIAL_ROCK       // Lit, untextured minor bodies
+};
+
+// State changes issued to GL and skipped as redundant during one frame
+struct RenderStateStats {
+    int issued;
+    int elided;
+};
+
+// Start a frame: forget the shadowed state and roll the counters over
+void beginRenderStateFrame();
+
+// Counts from the last completed frame
+RenderStateStats getRenderStateStats();
+
+// State setters that only reach GL when the value actually changes
+void setCapability(GLenum cap, bool enabled);
+void bindTexture(GLenum target, GLuint texture);
+void setMaterial(GLenum pname, const GLfloat* values);  // GL_FRONT; GL_SHININESS reads one value
+void setColor(GLfloat r, GLfloat g, GLfloat b, GLfloat a = 1.0f);
+void setBlendFunc(GLenum source, GLenum destination);
+void setDepthMask(bool write);
+void setTextureMode(GLint mode);                          // Texture environment mode
+void setPointSize(GLfloat size);
+
+// The state every draw outside the command list may assume: lit, depth-tested and
+// depth-written, untextured, opaque, non-emissive, modulating textures
+void setDefaultRenderState();
+
+// Draw commands are recorded, sorted by key, then run in order
+typedef void (*DrawCallback)(int item);
+
+// Opaque draws group by texture, then material
+unsigned long long opaqueDrawKey(GLuint texture, MaterialSlot material);
+// Translucent draws come after every opaque draw, furthest from the eye first
+unsigned long long translucentDrawKey(float eyeDistance);
+
+void submitDraw(unsigned long long key, DrawCallback draw, int item);
+
+// Sort and run every submitted command. Each command starts from the default state
+// as changed by the commands before it; the default state is restored afterwards.
+void executeDrawList();
@@ -0,0 +1,126 @@
+// Planetary ring systems drawn as flat textured annuli built once
+#include "RingSystem.h"
+#include "GLExtensions.h"     // Buffer objects
+#include "RenderState.h"      // Shadowed blend and texture state
+#include <math.h>             // sin, cos
+#include <vector>
+
+static const double RING_PI = 3.141592653589793;
+static const int RING_SEGMENTS = 128;      // Segments around the annulus
+static const int PROFILE_TEXELS = 256;     // Resolution of the radial profile
+
+// Annulus vertex: position in planet radii and radial texture coordinate
+struct RingVertex {
+    float x, y, z;
+    float s;
+};
+
+// GPU resources of one ring system
+struct RingSystem {
+    bool active;
+    float tilt;                        // Tilt about the planet's X axis in degrees
+    GLuint vertexBuffer;               // Triangle strip (0 when buffers are unavailable)
+    std::vector<RingVertex> vertices;  // Client copy when buffers are unavailable
+    GLuint profileTexture;             // 1D RGBA radial profile
+};
+static std::vector<RingSystem> ringSystems;
+
+void setRingSystem(int idx, float tilt, const RingBand* bands, int bandCount) {
+    if (bandCount <= 0) return;
+    if (idx >= (int)ringSystems.size()) ringSystems.resize(idx + 1, RingSystem{ false, 0.0f, 0, {}, 0 });
+    RingSystem& ring = ringSystems[idx];
+
+    // Overall extent of the bands
+    float inner = bands[0].inner, outer = bands[0].outer;
+    for (int b = 1; b < bandCount; ++b) {
+        if (bands[b].inner < inner) inner = bands[b].inner;
+        if (bands[b].outer > outer) outer = bands[b].outer;
+    }
+
+    // Radial profile: composite the bands in order over a transparent background
+    std::vector<GLubyte> texels(PROFILE_TEXELS * 4);
+    for (int t = 0; t < PROFILE_TEXELS; ++t) {
+        float r = inner + (outer - inner) * (t + 0.5f) / PROFILE_TEXELS;
+        float c[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        for (int b = 0; b < bandCount; ++b) {
+            if (r < bands[b].inner || r > bands[b].outer) continue;
+            float a = bands[b].color[3];
+            for (int k = 0; k < 3; ++k) c[k] = bands[b].color[k] * a + c[k] * (1.0f - a);
+            c[3] = a + c[3] * (1.0f - a);
+        }
+        // Store un-premultiplied color for regular alpha blending
+        for (int k = 0; k < 3; ++k) texels[t * 4 + k] = (GLubyte)(c[3] > 0.0f ? 255.0f * c[k] / c[3] : 0.0f);
+        texels[t * 4 + 3] = (GLubyte)(255.0f * c[3]);
+    }
+    if (!ring.profileTexture) glGenTextures(1, &ring.profileTexture);
+    glBindTexture(GL_TEXTURE_1D, ring.profileTexture);
+    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexImage1D(GL_TEXTURE_1D, 0, GL_RGBA, PROFILE_TEXELS, 0, GL_RGBA, GL_UNSIGNED_BYTE, texels.data());
+    glBindTexture(GL_TEXTURE_1D, 0);
+
+    // Annulus as one triangle strip: inner and outer vertex per segment
+    std::vector<RingVertex> vertices;
+    for (int i = 0; i <= RING_SEGMENTS; ++i) {
+        double angle = 2.0 * RING_PI * (i % RING_SEGMENTS) / RING_SEGMENTS;
+        float c = (float)cos(angle), s = (float)sin(angle);
+        RingVertex in = { inner * c, inner * s, 0.0f, 0.0f };
+        RingVertex out = { outer * c, outer * s, 0.0f, 1.0f };
+        vertices.push_back(in);
+        vertices.push_back(out);
+    }
+    if (hasVertexBuffers) {
+        if (!ring.vertexBuffer) glGenBuffers(1, &ring.vertexBuffer);
+        glBindBuffer(GL_ARRAY_BUFFER, ring.vertexBuffer);
+        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(RingVertex), vertices.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        ring.vertices.clear();
+    }
+    else {
+        ring.vertices.swap(vertices);
+    }
+    ring.tilt = tilt;
+    ring.active = true;
+}
+
+bool hasRingSystem(int idx) {
+    return idx >= 0 && idx < (int)ringSystems.size() && ringSystems[idx].active;
+}
+
+void drawRingSystem(int idx, double planetSize, float angle) {
+    if (!hasRingSystem(idx)) return;
+    const RingSystem& ring = ringSystems[idx];
+
+    glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
+    setCapability(GL_LIGHTING, false);
+    setCapability(GL_CULL_FACE, false);    // Visible from both sides
+    setCapability(GL_BLEND, true);
+    setBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    setDepthMask(false);                   // Translucent: test depth but don't write it
+    setCapability(GL_TEXTURE_2D, false);   // 2D texturing would take precedence
+    setCapability(GL_TEXTURE_1D, true);
+    bindTexture(GL_TEXTURE_1D, ring.profileTexture);
+    setTextureMode(GL_REPLACE);
+
+    glPushMatrix();
+    glRotatef(ring.tilt, 1.0f, 0.0f, 0.0f);  // Tilt rings for more realistic appearance
+    glRotatef(angle, 0.0f, 0.0f, 1.0f);      // Rotate rings over time
+    float scale = (float)planetSize;
+    glScalef(scale, scale, scale);
+
+    const char* base = (const char*)ring.vertices.data();
+    if (ring.vertexBuffer) {
+        glBindBuffer(GL_ARRAY_BUFFER, ring.vertexBuffer);
+        base = 0;
+    }
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    glVertexPointer(3, GL_FLOAT, sizeof(RingVertex), base);
+    glTexCoordPointer(1, GL_FLOAT, sizeof(RingVertex), base + 3 * sizeof(float));
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, (RING_SEGMENTS + 1) * 2);
+    if (ring.vertexBuffer) glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glPopMatrix();
+    glPopClientAttrib();
+}
@@ -0,0 +1,18 @@
+// Planetary ring systems drawn as flat textured annuli built once
+#pragma once
+
+// One band of a ring system; radii are in planet radii
+struct RingBand {
+    float inner, outer;   // Radial extent
+    float color[4];       // RGBA; alpha is the band's opacity
+};
+
+// Build the annulus mesh and radial color/opacity profile for planet idx
+void setRingSystem(int idx, float tilt, const RingBand* bands, int bandCount);
+
+// True when planet idx has a ring system registered
+bool hasRingSystem(int idx);
+
+// Draw planet idx's rings in the planet's local frame (rings lie in its XY plane).
+// Blending and texture state go through the render-state tracker and are left set.
+void drawRingSystem(int idx, double planetSize, float angle);
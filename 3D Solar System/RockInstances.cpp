@@ -0,0 +1,294 @@
+// Hardware-instanced rock meshes for asteroid belts and moon swarms
+#include "RockInstances.h"
+#include "GLExtensions.h"     // Buffer objects, shaders and instanced draws
+#include "MeshCache.h"        // Per-rock spheres for the benchmark comparison
+#include "Visibility.h"       // lodSegments
+#include <math.h>             // sin, sqrt
+#include <stdio.h>            // Benchmark output
+#include <stdlib.h>           // rand
+#include <chrono>             // Benchmark timing
+#include <map>                // Edge midpoints while subdividing
+#include <vector>
+
+// Generic slots that no driver aliases onto the normal and color arrays the mesh also uses
+static const GLuint POSITION_ATTRIB = 6;
+static const GLuint SPIN_ATTRIB = 7;
+static const GLuint TINT_ATTRIB = 1;
+
+// Rock vertex: position on a lumpy unit sphere and its smoothed normal
+struct RockVertex {
+    float x, y, z;
+    float nx, ny, nz;
+};
+
+// Everything that varies per rock, streamed to the GPU each frame
+struct RockInstance {
+    float position[4];    // Center and radius
+    float spin[4];        // Unit tumble axis and angle in degrees
+    GLubyte tint[4];      // Multiplies the current color
+};
+
+static GLuint rockVertexBuffer = 0, rockIndexBuffer = 0;
+static GLsizei rockIndexCount = 0;
+static GLuint instanceBuffer = 0;
+static GLuint rockProgram = 0;
+static std::vector<RockInstance> instances;  // Queued since the last draw
+
+// Rotate the mesh about the instance axis, scale, place, then light like fixed function
+static const char* rockVertexShader =
+    "#version 110\n"
+    "attribute vec4 instancePosition;  // center, radius\n"
+    "attribute vec4 instanceSpin;      // axis, angle in degrees\n"
+    "attribute vec4 instanceTint;\n"
+    "vec3 rotate(vec3 v, vec3 axis, float c, float s) {\n"
+    "    return v * c + cross(axis, v) * s + axis * dot(axis, v) * (1.0 - c);\n"
+    "}\n"
+    "void main() {\n"
+    "    float angle = radians(instanceSpin.w);\n"
+    "    float c = cos(angle), s = sin(angle);\n"
+    "    vec3 local = rotate(gl_Vertex.xyz, instanceSpin.xyz, c, s);\n"
+    "    vec4 eye = gl_ModelViewMatrix * vec4(instancePosition.xyz + local * instancePosition.w, 1.0);\n"
+    "    vec3 n = normalize(gl_NormalMatrix * rotate(gl_Normal, instanceSpin.xyz, c, s));\n"
+    "    vec3 toLight = normalize(gl_LightSource[0].position.xyz - eye.xyz);\n"
+    "    vec3 light = gl_LightModel.ambient.rgb + gl_LightSource[0].ambient.rgb +\n"
+    "                 gl_LightSource[0].diffuse.rgb * max(dot(n, toLight), 0.0);\n"
+    "    vec4 color = gl_Color * instanceTint;\n"
+    "    gl_FrontColor = vec4(color.rgb * light, color.a);\n"
+    "    gl_Position = gl_ProjectionMatrix * eye;\n"
+    "}\n";
+
+static const char* rockFragmentShader =
+    "#version 110\n"
+    "void main() {\n"
+    "    gl_FragColor = gl_Color;\n"
+    "}\n";
+
+// Radial bumps that make the sphere read as a rock
+static float lumpiness(float x, float y, float z) {
+    return 1.0f + 0.14f * sinf(5.0f * x + 1.3f) * sinf(4.0f * y + 0.7f) * sinf(6.0f * z + 2.1f)
+                + 0.06f * sinf(11.0f * x - 7.0f * z + 0.4f);
+}
+
+// Once-subdivided icosahedron (80 triangles) with displaced vertices
+static void buildRockMesh(std::vector<RockVertex>& vertices, std::vector<GLushort>& indices) {
+    const float t = (1.0f + sqrtf(5.0f)) / 2.0f;
+    const float corners[12][3] = {
+        {-1, t, 0}, {1, t, 0}, {-1, -t, 0}, {1, -t, 0}, {0, -1, t}, {0, 1, t},
+        {0, -1, -t}, {0, 1, -t}, {t, 0, -1}, {t, 0, 1}, {-t, 0, -1}, {-t, 0, 1}
+    };
+    const GLushort faces[20][3] = {
+        {0, 11, 5}, {0, 5, 1}, {0, 1, 7}, {0, 7, 10}, {0, 10, 11}, {1, 5, 9}, {5, 11, 4},
+        {11, 10, 2}, {10, 7, 6}, {7, 1, 8}, {3, 9, 4}, {3, 4, 2}, {3, 2, 6}, {3, 6, 8},
+        {3, 8, 9}, {4, 9, 5}, {2, 4, 11}, {6, 2, 10}, {8, 6, 7}, {9, 8, 1}
+    };
+    std::vector<float> points;  // Unit directions, three floats each
+    for (const auto& c : corners) {
+        float len = sqrtf(c[0] * c[0] + c[1] * c[1] + c[2] * c[2]);
+        points.insert(points.end(), { c[0] / len, c[1] / len, c[2] / len });
+    }
+
+    // Split every triangle into four, sharing the new edge midpoints
+    std::map<std::pair<int, int>, GLushort> midpoints;
+    auto midpoint = [&](int a, int b) -> GLushort {
+        std::pair<int, int> key(a < b ? a : b, a < b ? b : a);
+        auto it = midpoints.find(key);
+        if (it != midpoints.end()) return it->second;
+        float m[3] = { points[a * 3] + points[b * 3], points[a * 3 + 1] + points[b * 3 + 1],
+                       points[a * 3 + 2] + points[b * 3 + 2] };
+        float len = sqrtf(m[0] * m[0] + m[1] * m[1] + m[2] * m[2]);
+        points.insert(points.end(), { m[0] / len, m[1] / len, m[2] / len });
+        GLushort index = (GLushort)(points.size() / 3 - 1);
+        midpoints[key] = index;
+        return index;
+    };
+    indices.clear();
+    for (const auto& f : faces) {
+        GLushort ab = midpoint(f[0], f[1]), bc = midpoint(f[1], f[2]), ca = midpoint(f[2], f[0]);
+        indices.insert(indices.end(), { f[0], ab, ca, f[1], bc, ab, f[2], ca, bc, ab, bc, ca });
+    }
+
+    // Displace, then average the face normals around each vertex
+    vertices.assign(points.size() / 3, RockVertex());
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        float x = points[i * 3], y = points[i * 3 + 1], z = points[i * 3 + 2];
+        float r = lumpiness(x, y, z);
+        RockVertex v = { x * r, y * r, z * r, 0.0f, 0.0f, 0.0f };
+        vertices[i] = v;
+    }
+    for (size_t i = 0; i < indices.size(); i += 3) {
+        RockVertex& a = vertices[indices[i]];
+        RockVertex& b = vertices[indices[i + 1]];
+        RockVertex& c = vertices[indices[i + 2]];
+        float ux = b.x - a.x, uy = b.y - a.y, uz = b.z - a.z;
+        float vx = c.x - a.x, vy = c.y - a.y, vz = c.z - a.z;
+        float nx = uy * vz - uz * vy, ny = uz * vx - ux * vz, nz = ux * vy - uy * vx;
+        RockVertex* corner[3] = { &a, &b, &c };
+        for (RockVertex* v : corner) {
+            v->nx += nx; v->ny += ny; v->nz += nz;
+        }
+    }
+}
+
+bool initRockInstances() {
+    if (!hasInstancing) return false;
+    if (rockProgram) return true;
+
+    const char* attributes[] = { "instancePosition", "instanceSpin", "instanceTint" };
+    const GLuint locations[] = { POSITION_ATTRIB, SPIN_ATTRIB, TINT_ATTRIB };
+    rockProgram = buildProgram(rockVertexShader, rockFragmentShader, attributes, locations, 3);
+    if (!rockProgram) return false;
+
+    std::vector<RockVertex> vertices;
+    std::vector<GLushort> indices;
+    buildRockMesh(vertices, indices);
+    rockIndexCount = (GLsizei)indices.size();
+    glGenBuffers(1, &rockVertexBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, rockVertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(RockVertex), vertices.data(), GL_STATIC_DRAW);
+    glGenBuffers(1, &rockIndexBuffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, rockIndexBuffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLushort), indices.data(), GL_STATIC_DRAW);
+    glGenBuffers(1, &instanceBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    return true;
+}
+
+void addRockInstance(float x, float y, float z, float radius, float spinDegrees, unsigned seed) {
+    // Integer hash of the seed gives a stable axis and a small brightness/hue variation
+    unsigned h = seed * 2654435761u;
+    h ^= h >> 15; h *= 2246822519u; h ^= h >> 13;
+    float ax = (float)(h & 0xFF) - 127.5f, ay = (float)((h >> 8) & 0xFF) - 127.5f, az = (float)((h >> 16) & 0xFF) - 127.5f;
+    float len = sqrtf(ax * ax + ay * ay + az * az);
+    float shade = 0.8f + 0.2f * ((h >> 24) & 0x0F) / 15.0f;   // 0.8 - 1.0
+    float warmth = 0.05f * (((h >> 28) & 0x0F) / 15.0f);     // Slightly redder rocks
+
+    RockInstance rock;
+    rock.position[0] = x; rock.position[1] = y; rock.position[2] = z; rock.position[3] = radius;
+    rock.spin[0] = ax / len; rock.spin[1] = ay / len; rock.spin[2] = az / len; rock.spin[3] = spinDegrees;
+    rock.tint[0] = (GLubyte)(255.0f * shade);
+    rock.tint[1] = (GLubyte)(255.0f * shade * (1.0f - warmth));
+    rock.tint[2] = (GLubyte)(255.0f * shade * (1.0f - 2.0f * warmth));
+    rock.tint[3] = 255;
+    instances.push_back(rock);
+}
+
+int queuedRockInstances() {
+    return (int)instances.size();
+}
+
+void drawRockInstances() {
+    if (instances.empty() || !rockProgram) {
+        instances.clear();
+        return;
+    }
+
+    // Orphan and refill the instance buffer, then one draw for every rock. The push comes first so
+    // the pop can't bring back the per-instance arrays enabled below.
+    glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(RockInstance), instances.data(), GL_STREAM_DRAW);
+    glEnableVertexAttribArray(POSITION_ATTRIB);
+    glEnableVertexAttribArray(SPIN_ATTRIB);
+    glEnableVertexAttribArray(TINT_ATTRIB);
+    glVertexAttribPointer(POSITION_ATTRIB, 4, GL_FLOAT, GL_FALSE, sizeof(RockInstance), BUFFER_OFFSET(0));
+    glVertexAttribPointer(SPIN_ATTRIB, 4, GL_FLOAT, GL_FALSE, sizeof(RockInstance), BUFFER_OFFSET(4 * sizeof(float)));
+    glVertexAttribPointer(TINT_ATTRIB, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(RockInstance), BUFFER_OFFSET(8 * sizeof(float)));
+    glVertexAttribDivisor(POSITION_ATTRIB, 1);
+    glVertexAttribDivisor(SPIN_ATTRIB, 1);
+    glVertexAttribDivisor(TINT_ATTRIB, 1);
+
+    glBindBuffer(GL_ARRAY_BUFFER, rockVertexBuffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, rockIndexBuffer);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_NORMAL_ARRAY);
+    glVertexPointer(3, GL_FLOAT, sizeof(RockVertex), BUFFER_OFFSET(0));
+    glNormalPointer(GL_FLOAT, sizeof(RockVertex), BUFFER_OFFSET(3 * sizeof(float)));
+
+    glUseProgram(rockProgram);
+    glDrawElementsInstanced(GL_TRIANGLES, rockIndexCount, GL_UNSIGNED_SHORT, BUFFER_OFFSET(0), (GLsizei)instances.size());
+    glUseProgram(0);
+
+    // Divisors are vertex-array state: reset them so other users of these attributes are unaffected
+    glVertexAttribDivisor(POSITION_ATTRIB, 0);
+    glVertexAttribDivisor(SPIN_ATTRIB, 0);
+    glVertexAttribDivisor(TINT_ATTRIB, 0);
+    glDisableVertexAttribArray(POSITION_ATTRIB);
+    glDisableVertexAttribArray(SPIN_ATTRIB);
+    glDisableVertexAttribArray(TINT_ATTRIB);
+    glPopClientAttrib();
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    instances.clear();
+}
+
+// Milliseconds per frame for drawing a belt of rocks, averaged over frames
+static double timeBelt(const std::vector<float>& belt, bool instanced, int frames) {
+    const int count = (int)belt.size() / 4;
+    const SphereMesh& sphere = getSphereMesh(lodSegments[LOD_LEVELS - 1]);  // Coarsest asteroid sphere
+    glFinish();
+    auto start = std::chrono::steady_clock::now();
+    for (int f = 0; f < frames; ++f) {
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        float spin = f * 3.0f;
+        if (instanced) {
+            for (int i = 0; i < count; ++i)
+                addRockInstance(belt[i * 4], belt[i * 4 + 1], belt[i * 4 + 2], belt[i * 4 + 3], spin, i);
+            drawRockInstances();
+        }
+        else {
+            // The per-body path: a transform and an indexed draw for every rock
+            for (int i = 0; i < count; ++i) {
+                glPushMatrix();
+                glTranslatef(belt[i * 4], belt[i * 4 + 1], belt[i * 4 + 2]);
+                glRotatef(spin, 0.0f, 1.0f, 0.0f);
+                drawSphereMesh(sphere, belt[i * 4 + 3]);
+                glPopMatrix();
+            }
+        }
+        glFinish();
+    }
+    return 1000.0 * std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / frames;
+}
+
+void benchRockInstances(int maxInstances, int width, int height) {
+    if (!initRockInstances()) {
+        printf("bench-instancing: instanced drawing is not supported\n");
+        return;
+    }
+
+    // The default camera looking at a belt between Mars and Jupiter, lit from the Sun
+    const GLfloat lightPosition[] = { 0.0f, 0.0f, 0.0f, 1.0f };
+    glViewport(0, 0, width, height);
+    glMatrixMode(GL_PROJECTION);
+    glLoadIdentity();
+    gluPerspective(75.0, (double)width / height, 0.1, 400.0);
+    glMatrixMode(GL_MODELVIEW);
+    glLoadIdentity();
+    gluLookAt(0.0, 15.0, 60.0, 0.0, 5.0, 0.0, 0.0, 1.0, 0.0);
+    glLightfv(GL_LIGHT0, GL_POSITION, lightPosition);
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_LIGHTING);
+    glEnable(GL_LIGHT0);
+    glEnable(GL_NORMALIZE);
+    glEnable(GL_COLOR_MATERIAL);
+    glColor3f(0.7f, 0.65f, 0.6f);
+
+    printf("bench-instancing: %dx%d, ms per frame (rock mesh %d triangles)\n", width, height, rockIndexCount / 3);
+    srand(12345);
+    for (int n = 1000; n <= maxInstances; n *= 10) {
+        std::vector<float> belt(n * 4);
+        for (int i = 0; i < n; ++i) {
+            double r = 22.0 + 6.0 * (rand() / (double)RAND_MAX);
+            double phase = 6.283185307179586 * (rand() / (double)RAND_MAX);
+            belt[i * 4] = (float)(-r * sin(phase));
+            belt[i * 4 + 1] = (float)(0.6 * (rand() / (double)RAND_MAX - 0.5));
+            belt[i * 4 + 2] = (float)(r * cos(phase));
+            belt[i * 4 + 3] = 0.05f + 0.1f * (float)(rand() / (double)RAND_MAX);
+        }
+        double instanced = timeBelt(belt, true, 10);
+        double perBody = timeBelt(belt, false, n >= 100000 ? 2 : 10);
+        printf("  N=%8d  instanced %8.2f ms  per-body %9.2f ms  (%.1fx)\n",
+            n, instanced, perBody, perBody / instanced);
+    }
+}
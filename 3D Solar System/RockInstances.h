@@ -0,0 +1,20 @@
+// Hardware-instanced rock meshes for asteroid belts and moon swarms
+#pragma once
+
+// Build the shared rock mesh, its shader and the instance buffer.
+// Returns false when instanced drawing is unavailable (callers then draw rocks one by one).
+bool initRockInstances();
+
+// Queue one rock; seed picks its tumble axis and tint so a body always looks the same
+void addRockInstance(float x, float y, float z, float radius, float spinDegrees, unsigned seed);
+
+// Rocks queued since the last draw
+int queuedRockInstances();
+
+// Upload the queued rocks and draw them all with one instanced call, then empty the queue.
+// Lit by light 0 and tinted by the current color, like the fixed-function rocks.
+void drawRockInstances();
+
+// Time the instanced path against one draw per rock for 1000, 10000, ... instances
+// up to maxInstances. Needs a current GL context with extensions loaded.
+void benchRockInstances(int maxInstances, int width, int height);
@@ -0,0 +1,119 @@
+// Session logs: header, starting snapshot, then fixed-size event records until the end of the file
+#include "SessionLog.h"
+#include <stdio.h>            // FILE, snprintf
+#include <string.h>           // memcpy, memcmp
+#include <stdint.h>           // Fixed-width header fields
+#include <vector>
+
+static const char SESSION_MAGIC[4] = { 'S', 'S', 'E', 'S' };
+static const uint32_t SESSION_VERSION = 1;
+
+// Fixed-layout header (64 bytes, so the snapshot's columns stay aligned). Rewritten on close.
+struct SessionHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t width, height;
+    uint32_t frames;
+    uint32_t complete;        // Set once the log was closed properly
+    uint64_t snapshotBytes;   // Starting snapshot right after this header
+    uint64_t finalHash;
+    uint32_t reserved[6];
+};
+
+static FILE* logFile = 0;
+static SessionHeader logHeader;
+static char logPath[512];
+
+bool startSessionRecording(const char* path, const Simulation& sim, const SceneState& scene, int width, int height) {
+    if (logFile) stopSessionRecording(sim);
+    std::vector<unsigned char> snapshot;
+    packSnapshot(sim, scene, snapshot);
+
+    memset(&logHeader, 0, sizeof(logHeader));
+    memcpy(logHeader.magic, SESSION_MAGIC, 4);
+    logHeader.version = SESSION_VERSION;
+    logHeader.width = (uint32_t)width;
+    logHeader.height = (uint32_t)height;
+    logHeader.snapshotBytes = snapshot.size();
+
+    logFile = fopen(path, "wb");
+    bool ok = logFile && fwrite(&logHeader, sizeof(logHeader), 1, logFile) == 1 &&
+        fwrite(snapshot.data(), 1, snapshot.size(), logFile) == snapshot.size();
+    if (!ok) {
+        printf("Could not write session log %s\n", path);
+        if (logFile) fclose(logFile);
+        logFile = 0;
+        remove(path);
+        return false;
+    }
+    snprintf(logPath, sizeof(logPath), "%s", path);
+    return true;
+}
+
+bool isRecordingSession() {
+    return logFile != 0;
+}
+
+void recordSessionEvent(int type, int a, int b, double value) {
+    if (!logFile) return;
+    SessionEvent event = { type, a, b, 0, value };
+    fwrite(&event, sizeof(event), 1, logFile);
+    if (type == SESSION_FRAME) logHeader.frames++;
+}
+
+void stopSessionRecording(const Simulation& sim) {
+    if (!logFile) return;
+    logHeader.complete = 1;
+    logHeader.finalHash = simulationStateHash(sim);
+    bool ok = fseek(logFile, 0, SEEK_SET) == 0 && fwrite(&logHeader, sizeof(logHeader), 1, logFile) == 1;
+    if (fclose(logFile) != 0) ok = false;
+    logFile = 0;
+    if (ok) printf("Session recorded to %s: %u frames\n", logPath, logHeader.frames);
+    else printf("Could not finish session log %s\n", logPath);
+}
+
+bool openSessionReplay(const char* path, SessionReplay& replay, Simulation& sim, SceneState& scene,
+                       char* error, int errorSize) {
+    memset(&replay, 0, sizeof(replay));
+    if (!mapFile(path, replay.file)) {
+        snprintf(error, errorSize, "cannot open %s", path);
+        return false;
+    }
+    SessionHeader header;
+    const size_t size = replay.file.size;
+    bool ok = size >= sizeof(header);
+    if (ok) memcpy(&header, replay.file.data, sizeof(header));
+    if (!ok || memcmp(header.magic, SESSION_MAGIC, 4) != 0 || header.version != SESSION_VERSION) {
+        snprintf(error, errorSize, "not a version %u session log", SESSION_VERSION);
+        closeSessionReplay(replay);
+        return false;
+    }
+    if (header.snapshotBytes > size - sizeof(header)) {
+        snprintf(error, errorSize, "session log is truncated");
+        closeSessionReplay(replay);
+        return false;
+    }
+    const unsigned char* snapshot = replay.file.data + sizeof(header);
+    if (!unpackSnapshot(snapshot, (size_t)header.snapshotBytes, sim, scene, error, errorSize)) {
+        closeSessionReplay(replay);
+        return false;
+    }
+
+    // Records run to the end of the file; a log cut short by a crash still replays up to there
+    const size_t eventBytes = size - sizeof(header) - (size_t)header.snapshotBytes;
+    replay.events = (const SessionEvent*)(snapshot + header.snapshotBytes);
+    replay.eventCount = (int)(eventBytes / sizeof(SessionEvent));
+    for (int i = 0; i < replay.eventCount; ++i)
+        if (replay.events[i].type == SESSION_FRAME) replay.frames++;
+    replay.width = (int)header.width;
+    replay.height = (int)header.height;
+    replay.complete = header.complete != 0 && header.frames == (uint32_t)replay.frames;
+    replay.finalHash = header.finalHash;
+    return true;
+}
+
+void closeSessionReplay(SessionReplay& replay) {
+    unmapFile(replay.file);
+    replay.events = 0;
+    replay.eventCount = 0;
+}
@@ -0,0 +1,51 @@
+// Session logs: a snapshot of the starting state, then every input event and frame time of a
+// windowed run, so headless mode can replay it bit for bit
+#pragma once
+
+#include "Snapshot.h"         // SceneState and the starting snapshot
+#include "MappedFile.h"       // Logs are replayed from a mapping
+
+// What a log record holds
+enum SessionEventType {
+    SESSION_FRAME,    // A frame began; value is the real time handed to Simulation::advance()
+    SESSION_KEY,      // Keyboard key a
+    SESSION_SPECIAL,  // GLUT special key a
+    SESSION_CLICK,    // Left click at window pixel (a, b)
+    SESSION_RESIZE    // Window resized to a x b
+};
+
+// One fixed-size log record. Input events come before the frame they were handled ahead of.
+struct SessionEvent {
+    int type;         // SessionEventType
+    int a, b;
+    int reserved;
+    double value;
+};
+
+// Start a log at path from the current state, for a window of width x height.
+// Prints the reason and returns false on failure.
+bool startSessionRecording(const char* path, const Simulation& sim, const SceneState& scene, int width, int height);
+bool isRecordingSession();
+
+// Append a record (does nothing unless recording)
+void recordSessionEvent(int type, int a = 0, int b = 0, double value = 0.0);
+
+// Finish the log with the final state's hash so a replay can check itself against it
+void stopSessionRecording(const Simulation& sim);
+
+// A log opened for replay; events point into the mapped file
+struct SessionReplay {
+    MappedFile file;
+    const SessionEvent* events;
+    int eventCount;
+    int frames;                   // SESSION_FRAME records
+    int width, height;            // Window size when recording started
+    bool complete;                // The log was closed properly, so finalHash is set
+    unsigned long long finalHash; // simulationStateHash() after the last frame
+};
+
+// Map a log and restore its starting state into sim and scene. On failure returns false and
+// describes the problem in error.
+bool openSessionReplay(const char* path, SessionReplay& replay, Simulation& sim, SceneState& scene,
+                       char* error, int errorSize);
+void closeSessionReplay(SessionReplay& replay);
@@ -0,0 +1,331 @@
+// Headless simulation core for the solar system
+#include "Simulation.h"
+#include <math.h>             // Math functions (sin, cos, fmod, sqrt)
+#include <algorithm>          // std::min
+
+static const double TWO_PI = 6.283185307179586;  // Full turn in radians
+static const double RING_SPEED = 18.0;            // Ring rotation in degrees per second
+static const double MAX_FRAME_TIME = 0.25;        // Clamp for long stalls (avoids a spiral of catch-up steps)
+static const double SUN_GM = 1692.7;              // Sun's GM: a body at distance 14 (Earth) orbits in 8 s
+static const int SIM_GRAIN = 4096;                // Bodies per task for cheap per-body updates
+static const int FORCE_GRAIN = 256;               // Bodies per task for tree walks
+static const int EVAL_BLOCK = 256;                // Bodies per stack block when evaluating orbits for a frame
+
+Simulation::Simulation()
+    : fixedStep(SIM_FIXED_STEP), timeWarp(1.0), centralMass(SUN_GM), scheduler(0), ringAngle(0.0),
+      prevRingAngle(0.0), mode(SIM_ORBITS), simTime(0.0), clockTime(0.0), accumulator(0.0),
+      stepTotal(0) {
+}
+
+int Simulation::addBody(double dist, double orbitalPeriod, double rotationalPeriod,
+                        double phase, double bodyMass, int parentIndex) {
+    const int idx = bodyCount();
+    if (parentIndex >= 0) childBodies.push_back(idx);
+    distance.push_back(dist);
+    orbitSpeed.push_back(orbitalPeriod > 0.0 ? TWO_PI / orbitalPeriod : 0.0);
+    // Circular orbit in the ecliptic: periapsis along +Z, travelling towards -X
+    epochAnomaly.push_back(phase);
+    eccentricity.push_back(0.0);
+    basisPX.push_back(0.0); basisPY.push_back(0.0); basisPZ.push_back(dist);
+    basisQX.push_back(-dist); basisQY.push_back(0.0); basisQZ.push_back(0.0);
+    spinSpeed.push_back(rotationalPeriod > 0.0 ? 360.0 / rotationalPeriod : 0.0);
+    mass.push_back(bodyMass);
+    parent.push_back(parentIndex);
+    spinAngle.push_back(0.0);
+    posX.push_back(0.0); posY.push_back(0.0); posZ.push_back(0.0);
+    prevPosX.push_back(0.0); prevPosY.push_back(0.0); prevPosZ.push_back(0.0);
+    prevSpinAngle.push_back(0.0);
+    velX.push_back(0.0); velY.push_back(0.0); velZ.push_back(0.0);
+    accX.push_back(0.0); accY.push_back(0.0); accZ.push_back(0.0);
+
+    // Place it at the current time
+    spinAngle[idx] = prevSpinAngle[idx] = fmod(spinSpeed[idx] * simTime, 360.0);
+    OrbitalElements circle = { dist, 0.0, 0.0, 0.0, 0.0 };
+    setOrbit(idx, circle);
+    return idx;
+}
+
+void Simulation::setOrbit(int idx, const OrbitalElements& orbit) {
+    double P[3], Q[3];
+    orbitalBasis(orbit, P, Q);
+    const double a = orbit.semiMajor;
+    const double b = a * sqrt(1.0 - orbit.eccentricity * orbit.eccentricity);
+    distance[idx] = a;
+    eccentricity[idx] = orbit.eccentricity;
+    basisPX[idx] = a * P[0]; basisPY[idx] = a * P[1]; basisPZ[idx] = a * P[2];
+    basisQX[idx] = b * Q[0]; basisQY[idx] = b * Q[1]; basisQZ[idx] = b * Q[2];
+
+    propagateKeplerScalar(orbits(), simTime, idx, idx + 1, posX.data(), posY.data(), posZ.data());
+    if (parent[idx] >= 0) {
+        posX[idx] += posX[parent[idx]];
+        posY[idx] += posY[parent[idx]];
+        posZ[idx] += posZ[parent[idx]];
+    }
+    prevPosX[idx] = posX[idx]; prevPosY[idx] = posY[idx]; prevPosZ[idx] = posZ[idx];
+}
+
+KeplerOrbits Simulation::orbits() const {
+    KeplerOrbits o = { orbitSpeed.data(), epochAnomaly.data(), eccentricity.data(),
+                       basisPX.data(), basisPY.data(), basisPZ.data(),
+                       basisQX.data(), basisQY.data(), basisQZ.data() };
+    return o;
+}
+
+// The same orbits starting at body first, so a block can be evaluated into small buffers
+static KeplerOrbits orbitSlice(const KeplerOrbits& o, int first) {
+    KeplerOrbits s = { o.meanMotion + first, o.epochAnomaly + first, o.eccentricity + first,
+                       o.px + first, o.py + first, o.pz + first,
+                       o.qx + first, o.qy + first, o.qz + first };
+    return s;
+}
+
+double Simulation::keplerPeriod(double dist) const {
+    return TWO_PI * sqrt(dist * dist * dist / centralMass);
+}
+
+void Simulation::setMode(SimMode newMode) {
+    if (newMode == mode) return;
+    const int count = bodyCount();
+    if (newMode == SIM_NBODY) {
+        // Start every body with the speed gravity needs for its orbit's size (vis-viva),
+        // along the direction it was already moving.
+        // Moons stay on their analytic orbits: the scene isn't to scale, so their drawn
+        // orbits lie far outside the region where their parent's gravity would hold them.
+        for (int i = 0; i < count; ++i) {
+            if (parent[i] >= 0) continue;
+            double r = sqrt(posX[i] * posX[i] + posY[i] * posY[i] + posZ[i] * posZ[i]);
+            double v2 = (r > 0.0) ? centralMass * (2.0 / r - 1.0 / distance[i]) : 0.0;
+            double E = solveKepler(epochAnomaly[i] + orbitSpeed[i] * simTime, eccentricity[i]);
+            double tx = -sin(E) * basisPX[i] + cos(E) * basisQX[i];
+            double ty = -sin(E) * basisPY[i] + cos(E) * basisQY[i];
+            double tz = -sin(E) * basisPZ[i] + cos(E) * basisQZ[i];
+            double len = sqrt(tx * tx + ty * ty + tz * tz);
+            double s = (v2 > 0.0 && len > 0.0) ? sqrt(v2) / len : 0.0;
+            velX[i] = tx * s;
+            velY[i] = ty * s;
+            velZ[i] = tz * s;
+        }
+        computeForces();
+    }
+    else {
+        // Resume the analytic orbits from wherever gravity left each body, keeping their shapes
+        for (int i = 0; i < count; ++i) {
+            if (parent[i] >= 0 || distance[i] <= 0.0) continue;
+            double a2 = basisPX[i] * basisPX[i] + basisPY[i] * basisPY[i] + basisPZ[i] * basisPZ[i];
+            double b2 = basisQX[i] * basisQX[i] + basisQY[i] * basisQY[i] + basisQZ[i] * basisQZ[i];
+            double cosE = (posX[i] * basisPX[i] + posY[i] * basisPY[i] + posZ[i] * basisPZ[i]) / a2 + eccentricity[i];
+            double sinE = (posX[i] * basisQX[i] + posY[i] * basisQY[i] + posZ[i] * basisQZ[i]) / b2;
+            double E = atan2(sinE, cosE);
+            double M = E - eccentricity[i] * sin(E);
+            epochAnomaly[i] = fmod(M - orbitSpeed[i] * simTime, TWO_PI);
+        }
+    }
+    mode = newMode;
+    if (mode == SIM_ORBITS) evaluate(true);
+}
+
+void Simulation::storePrevious(int begin, int end) {
+    for (int i = begin; i < end; ++i) {
+        prevPosX[i] = posX[i];
+        prevPosY[i] = posY[i];
+        prevPosZ[i] = posZ[i];
+        prevSpinAngle[i] = spinAngle[i];
+    }
+}
+
+void Simulation::evaluate(bool rootOrbits) {
+    const int count = bodyCount();
+    const KeplerOrbits o = orbits();
+    ringAngle = fmod(RING_SPEED * simTime, 360.0);
+    parallelFor(scheduler, 0, count, SIM_GRAIN, [&](int begin, int end) {
+        for (int i = begin; i < end; ++i)
+            spinAngle[i] = fmod(spinSpeed[i] * simTime, 360.0);
+        if (rootOrbits)
+            propagateKepler(o, simTime, begin, end, posX.data(), posY.data(), posZ.data());
+    });
+    if (!rootOrbits) {
+        // Moons keep following their orbits while gravity moves everything else
+        for (int i : childBodies)
+            propagateKeplerScalar(o, simTime, i, i + 1, posX.data(), posY.data(), posZ.data());
+    }
+    attachChildren();
+}
+
+void Simulation::attachChildren() {
+    // Parents precede their children, so one pass in index order resolves nested orbits
+    for (int i : childBodies) {
+        posX[i] += posX[parent[i]];
+        posY[i] += posY[parent[i]];
+        posZ[i] += posZ[parent[i]];
+    }
+}
+
+void Simulation::computeForces() {
+    const int count = bodyCount();
+    // Tree build is serial; the per-body walks are independent and run in parallel
+    gravity.build(posX.data(), posY.data(), posZ.data(), mass.data(), count);
+
+    const double eps2 = gravity.softening * gravity.softening;
+    parallelFor(scheduler, 0, count, FORCE_GRAIN, [&](int begin, int end) {
+        gravity.accelerations(begin, end, accX.data(), accY.data(), accZ.data());
+
+        // The Sun is a fixed point mass at the origin, added analytically
+        for (int i = begin; i < end; ++i) {
+            double r2 = posX[i] * posX[i] + posY[i] * posY[i] + posZ[i] * posZ[i] + eps2;
+            double inv = 1.0 / sqrt(r2);
+            double s = -centralMass * inv * inv * inv;
+            accX[i] += posX[i] * s;
+            accY[i] += posY[i] * s;
+            accZ[i] += posZ[i] * s;
+        }
+    });
+}
+
+void Simulation::stepNBody(double dt) {
+    const int count = bodyCount();
+    const double half = 0.5 * dt;
+    // Kick (half step) and drift (full step)
+    parallelFor(scheduler, 0, count, SIM_GRAIN, [&](int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+            if (parent[i] >= 0) continue;  // Moons follow their parents (see setMode)
+            velX[i] += accX[i] * half;
+            velY[i] += accY[i] * half;
+            velZ[i] += accZ[i] * half;
+            posX[i] += velX[i] * dt;
+            posY[i] += velY[i] * dt;
+            posZ[i] += velZ[i] * dt;
+        }
+    });
+    // Forces at the new positions, then the closing half kick
+    computeForces();
+    parallelFor(scheduler, 0, count, SIM_GRAIN, [&](int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+            if (parent[i] >= 0) continue;
+            velX[i] += accX[i] * half;
+            velY[i] += accY[i] * half;
+            velZ[i] += accZ[i] * half;
+        }
+    });
+}
+
+void Simulation::step(double dt, int n) {
+    if (n <= 0) return;
+    const int count = bodyCount();
+    const double warp = (mode == SIM_ORBITS) ? timeWarp : 1.0;
+    if (mode == SIM_ORBITS) {
+        // Everything is a function of time, so n steps cost the same as one
+        parallelFor(scheduler, 0, count, SIM_GRAIN, [&](int begin, int end) {
+            storePrevious(begin, end);
+        });
+        prevRingAngle = ringAngle;
+        simTime += dt * n;
+        evaluate(true);
+    }
+    else {
+        for (int s = 0; s < n; ++s) {
+            parallelFor(scheduler, 0, count, SIM_GRAIN, [&](int begin, int end) {
+                storePrevious(begin, end);
+            });
+            prevRingAngle = ringAngle;
+            simTime += dt;
+            stepNBody(dt);
+            evaluate(false);
+        }
+    }
+    clockTime += dt * n / warp;
+    stepTotal += n;
+}
+
+double Simulation::stepDuration() const {
+    return (mode == SIM_ORBITS) ? fixedStep * timeWarp : fixedStep;
+}
+
+void Simulation::seek(double t) {
+    if (mode != SIM_ORBITS) setMode(SIM_ORBITS);
+    simTime = t;
+    evaluate(true);
+    const int count = bodyCount();
+    parallelFor(scheduler, 0, count, SIM_GRAIN, [&](int begin, int end) {
+        storePrevious(begin, end);
+    });
+    prevRingAngle = ringAngle;
+}
+
+void Simulation::restore(SimMode savedMode, double time, double unwarped, double pending, long long steps) {
+    childBodies.clear();
+    for (int i = 0; i < bodyCount(); ++i)
+        if (parent[i] >= 0) childBodies.push_back(i);
+    mode = savedMode;
+    simTime = time;
+    clockTime = unwarped;
+    accumulator = pending;
+    stepTotal = steps;
+}
+
+double Simulation::advance(double elapsedSeconds) {
+    if (elapsedSeconds > MAX_FRAME_TIME) elapsedSeconds = MAX_FRAME_TIME;
+    if (elapsedSeconds < 0.0) elapsedSeconds = 0.0;
+    accumulator += elapsedSeconds;
+
+    // Consume as many whole fixed steps as the accumulated time allows
+    int steps = (int)(accumulator / fixedStep);
+    if (steps > 0) {
+        step(stepDuration(), steps);
+        accumulator -= steps * fixedStep;
+    }
+    return accumulator / fixedStep;
+}
+
+// Blend two angles in degrees along the shortest arc
+static double lerpDegrees(double a, double b, double t) {
+    double delta = b - a;
+    if (delta > 180.0) delta -= 360.0;
+    else if (delta < -180.0) delta += 360.0;
+    return a + delta * t;
+}
+
+void Simulation::interpolate(double alpha, BodySnapshot& out) const {
+    const int count = bodyCount();
+    out.x.resize(count);
+    out.y.resize(count);
+    out.z.resize(count);
+    out.spin.resize(count);
+    out.time = simTime - (1.0 - alpha) * stepDuration();
+    out.clock = clockTime - (1.0 - alpha) * fixedStep;
+
+    if (mode == SIM_ORBITS) {
+        // Exact state at the frame's time: a blend would cut across orbits once warped
+        const double t = out.time;
+        const KeplerOrbits o = orbits();
+        parallelFor(scheduler, 0, count, SIM_GRAIN, [&](int begin, int end) {
+            double x[EVAL_BLOCK], y[EVAL_BLOCK], z[EVAL_BLOCK];
+            for (int first = begin; first < end; first += EVAL_BLOCK) {
+                const int n = std::min(EVAL_BLOCK, end - first);
+                propagateKepler(orbitSlice(o, first), t, 0, n, x, y, z);
+                for (int k = 0; k < n; ++k) {
+                    out.x[first + k] = (float)x[k];
+                    out.y[first + k] = (float)y[k];
+                    out.z[first + k] = (float)z[k];
+                    out.spin[first + k] = (float)fmod(spinSpeed[first + k] * t, 360.0);
+                }
+            }
+        });
+        for (int i : childBodies) {
+            out.x[i] += out.x[parent[i]];
+            out.y[i] += out.y[parent[i]];
+            out.z[i] += out.z[parent[i]];
+        }
+        out.ringAngle = (float)fmod(RING_SPEED * t, 360.0);
+        return;
+    }
+
+    parallelFor(scheduler, 0, count, SIM_GRAIN, [&](int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+            out.x[i] = (float)(prevPosX[i] + (posX[i] - prevPosX[i]) * alpha);
+            out.y[i] = (float)(prevPosY[i] + (posY[i] - prevPosY[i]) * alpha);
+            out.z[i] = (float)(prevPosZ[i] + (posZ[i] - prevPosZ[i]) * alpha);
+            out.spin[i] = (float)lerpDegrees(prevSpinAngle[i], spinAngle[i], alpha);
+        }
+    });
+    out.ringAngle = (float)lerpDegrees(prevRingAngle, ringAngle, alpha);
+}
@@ -0,0 +1,116 @@
+// Headless simulation core for the solar system (no OpenGL dependency)
+#pragma once
+
+#include <vector>
+#include "NBody.h"            // Barnes-Hut gravity for N-body mode
+#include "TaskScheduler.h"    // Parallel per-body updates
+#include "Kepler.h"           // Analytic orbit evaluation
+
+// Default fixed simulation step in seconds (matches the old 60 Hz redraw step)
+static const double SIM_FIXED_STEP = 1.0 / 60.0;
+
+// Fastest time warp: simulated seconds per real second in orbit mode
+static const double SIM_MAX_TIME_WARP = 1e7;
+
+// How body positions are advanced
+enum SimMode {
+    SIM_ORBITS,   // Keplerian orbits evaluated analytically at the current time
+    SIM_NBODY     // Gravitational N-body integration (leapfrog + Barnes-Hut)
+};
+
+// Interpolated view of all bodies, consumed by the renderer
+struct BodySnapshot {
+    std::vector<float> x, y, z;  // World position of each body
+    std::vector<float> spin;     // Spin angle in degrees
+    float ringAngle;             // Rotation angle for ring systems in degrees
+    double time;                 // Simulation time the snapshot represents
+    double clock;                // Unwarped time, for effects that shouldn't speed up (star flicker)
+};
+
+// Fixed-timestep simulation that owns body state in structure-of-arrays form
+class Simulation {
+public:
+    Simulation();
+
+    // Add a body on a circular orbit starting at the given phase (mean anomaly); returns its index.
+    // A body with a parent orbits that body (which must already exist) instead of the origin,
+    // and a period of 0 leaves the orbit or spin fixed.
+    int addBody(double distance, double orbitalPeriod, double rotationalPeriod,
+                double phase = 0.0, double mass = 0.0, int parent = -1);
+    int bodyCount() const { return (int)distance.size(); }
+
+    // Give body idx an elliptical or inclined orbit (its semi-major axis replaces the distance)
+    void setOrbit(int idx, const OrbitalElements& orbit);
+
+    // Orbital period of a circular orbit around the central mass
+    double keplerPeriod(double distance) const;
+
+    // Switch between analytic orbits and N-body integration
+    void setMode(SimMode newMode);
+    SimMode getMode() const { return mode; }
+
+    // Advance the simulation by n fixed steps of dt seconds
+    void step(double dt, int n = 1);
+
+    // Feed real elapsed time; runs whole fixed steps and returns the blend factor (0-1)
+    double advance(double elapsedSeconds);
+
+    // Simulated seconds per fixed step: warped in orbit mode, while N-body always runs at 1x
+    double stepDuration() const;
+
+    // Jump straight to simulation time t. Orbits, spins and rings are all functions of time,
+    // so this costs the same however far it jumps (N-body mode returns to orbits first).
+    void seek(double t);
+
+    // Blend previous and current state into a snapshot for rendering. Orbit mode evaluates the
+    // orbits at the in-between time instead, so a warped step of many orbits still draws correctly.
+    void interpolate(double alpha, BodySnapshot& out) const;
+
+    double time() const { return simTime; }
+    long long stepCount() const { return stepTotal; }  // Fixed steps taken since the start
+    double unwarpedTime() const { return clockTime; }
+    double pendingTime() const { return accumulator; }  // Real time not yet consumed by fixed steps
+
+    // Resume from saved state: the per-body arrays must already hold it. Rebuilds the list of
+    // moons and sets the clocks without evaluating anything, so stepping continues bit for bit.
+    void restore(SimMode savedMode, double time, double unwarped, double pending, long long steps);
+    double fixedStep;  // Step used by advance()
+    double timeWarp;   // Simulated seconds per real second in orbit mode (1 to SIM_MAX_TIME_WARP)
+    double centralMass;      // Gravitational parameter of the Sun at the origin
+    BarnesHutTree gravity;   // Mutual gravity between bodies (theta is the accuracy knob)
+    TaskScheduler* scheduler;  // Splits per-body work across cores (null runs serially)
+
+    // Per-body parameters
+    std::vector<double> distance;    // Orbit radius (semi-major axis)
+    std::vector<double> orbitSpeed;  // Mean motion in radians per second
+    std::vector<double> epochAnomaly;  // Mean anomaly at time 0
+    std::vector<double> eccentricity;
+    std::vector<double> basisPX, basisPY, basisPZ;  // Semi-major axis times the periapsis direction
+    std::vector<double> basisQX, basisQY, basisQZ;  // Semi-minor axis times the direction 90 degrees on
+    std::vector<double> spinSpeed;   // Degrees per second
+    std::vector<double> mass;        // Gravitational mass (0 for test particles)
+    std::vector<int> parent;         // Body orbited (-1 for the origin)
+    std::vector<int> childBodies;    // Bodies with a parent, in index order
+
+    // Per-body state (current and previous step)
+    std::vector<double> spinAngle;
+    std::vector<double> posX, posY, posZ;
+    std::vector<double> prevPosX, prevPosY, prevPosZ, prevSpinAngle;
+    std::vector<double> velX, velY, velZ;  // Velocities (N-body mode)
+    std::vector<double> accX, accY, accZ;  // Accelerations from the last force pass
+    double ringAngle, prevRingAngle;
+
+private:
+    void storePrevious(int begin, int end);    // Copy current state into the previous-step arrays
+    KeplerOrbits orbits() const;  // Views of the orbit arrays for propagateKepler()
+    void evaluate(bool rootOrbits);  // Spins, rings and orbit positions at simTime (moons only unless rootOrbits)
+    void attachChildren();   // Offset child bodies by their parents' positions
+    void computeForces();    // Sun + Barnes-Hut accelerations for every body
+    void stepNBody(double dt);  // One kick-drift-kick leapfrog step
+
+    SimMode mode;        // Current motion model
+    double simTime;      // Total simulated time
+    double clockTime;    // Unwarped time
+    double accumulator;  // Real time not yet consumed by fixed steps
+    long long stepTotal; // Fixed steps taken
+};
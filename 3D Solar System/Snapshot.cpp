@@ -0,0 +1,224 @@
+// Simulation snapshots: a fixed header and the per-body arrays as packed, aligned columns
+#include "Snapshot.h"
+#include "MappedFile.h"       // Snapshots are read straight from a mapping
+#include <stdio.h>            // FILE, rename, snprintf
+#include <string.h>           // memcpy, memcmp
+#include <stdint.h>           // Fixed-width header fields
+#include <chrono>             // Write timing
+#include <string>
+#include <thread>
+
+static const char SNAPSHOT_MAGIC[4] = { 'S', 'S', 'N', 'P' };
+static const uint32_t SNAPSHOT_VERSION = 1;
+static const size_t COLUMN_ALIGN = 64;  // Every column starts on a cache line
+
+// Per-body double arrays in file order (the int parent column follows them)
+static std::vector<double> Simulation::* const BODY_COLUMNS[] = {
+    &Simulation::distance, &Simulation::orbitSpeed, &Simulation::epochAnomaly, &Simulation::eccentricity,
+    &Simulation::basisPX, &Simulation::basisPY, &Simulation::basisPZ,
+    &Simulation::basisQX, &Simulation::basisQY, &Simulation::basisQZ,
+    &Simulation::spinSpeed, &Simulation::mass, &Simulation::spinAngle,
+    &Simulation::posX, &Simulation::posY, &Simulation::posZ,
+    &Simulation::prevPosX, &Simulation::prevPosY, &Simulation::prevPosZ, &Simulation::prevSpinAngle,
+    &Simulation::velX, &Simulation::velY, &Simulation::velZ,
+    &Simulation::accX, &Simulation::accY, &Simulation::accZ
+};
+static const uint32_t COLUMN_COUNT = sizeof(BODY_COLUMNS) / sizeof(BODY_COLUMNS[0]);
+
+// The arrays that change as the simulation runs (the rest only change through setOrbit())
+static std::vector<double> Simulation::* const STATE_COLUMNS[] = {
+    &Simulation::epochAnomaly, &Simulation::spinAngle, &Simulation::posX, &Simulation::posY, &Simulation::posZ,
+    &Simulation::prevPosX, &Simulation::prevPosY, &Simulation::prevPosZ, &Simulation::prevSpinAngle,
+    &Simulation::velX, &Simulation::velY, &Simulation::velZ, &Simulation::accX, &Simulation::accY, &Simulation::accZ
+};
+
+// Fixed-layout header, naturally aligned so it has no padding
+struct SnapshotHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t bodyCount;
+    uint32_t columnCount;   // Double columns
+    uint32_t mode;          // SimMode
+    uint32_t starSeed;
+    int32_t targetBody;
+    int32_t cameraMoving;
+    int32_t showTrails;
+    int32_t showDate;
+    float camera[6];
+    int64_t stepTotal;
+    double simTime, unwarpedTime, pendingTime;
+    double fixedStep, timeWarp, centralMass;
+    double theta, softening;  // Barnes-Hut settings
+    double ringAngle, prevRingAngle;
+};
+
+// Background writer: one snapshot at a time
+static std::thread writer;
+static std::vector<unsigned char> writeBuffer;
+
+static size_t alignColumn(size_t bytes) {
+    return (bytes + COLUMN_ALIGN - 1) / COLUMN_ALIGN * COLUMN_ALIGN;
+}
+
+static size_t snapshotSize(size_t bodies) {
+    return alignColumn(sizeof(SnapshotHeader)) + COLUMN_COUNT * alignColumn(bodies * sizeof(double)) +
+        alignColumn(bodies * sizeof(int));
+}
+
+void packSnapshot(const Simulation& sim, const SceneState& scene, std::vector<unsigned char>& out) {
+    const size_t n = sim.bodyCount();
+    out.assign(snapshotSize(n), 0);
+
+    SnapshotHeader header;
+    memcpy(header.magic, SNAPSHOT_MAGIC, 4);
+    header.version = SNAPSHOT_VERSION;
+    header.bodyCount = (uint32_t)n;
+    header.columnCount = COLUMN_COUNT;
+    header.mode = (uint32_t)sim.getMode();
+    header.starSeed = scene.starSeed;
+    header.targetBody = scene.targetBody;
+    header.cameraMoving = scene.cameraMoving;
+    header.showTrails = scene.showTrails;
+    header.showDate = scene.showDate;
+    memcpy(header.camera, scene.camera, sizeof(header.camera));
+    header.stepTotal = sim.stepCount();
+    header.simTime = sim.time();
+    header.unwarpedTime = sim.unwarpedTime();
+    header.pendingTime = sim.pendingTime();
+    header.fixedStep = sim.fixedStep;
+    header.timeWarp = sim.timeWarp;
+    header.centralMass = sim.centralMass;
+    header.theta = sim.gravity.theta;
+    header.softening = sim.gravity.softening;
+    header.ringAngle = sim.ringAngle;
+    header.prevRingAngle = sim.prevRingAngle;
+    memcpy(out.data(), &header, sizeof(header));
+
+    unsigned char* column = out.data() + alignColumn(sizeof(header));
+    for (uint32_t c = 0; c < COLUMN_COUNT; ++c) {
+        if (n > 0) memcpy(column, (sim.*BODY_COLUMNS[c]).data(), n * sizeof(double));
+        column += alignColumn(n * sizeof(double));
+    }
+    if (n > 0) memcpy(column, sim.parent.data(), n * sizeof(int));
+}
+
+bool unpackSnapshot(const unsigned char* data, size_t size, Simulation& sim, SceneState& scene,
+                    char* error, int errorSize) {
+    SnapshotHeader header;
+    if (size < sizeof(header)) {
+        snprintf(error, errorSize, "not a snapshot");
+        return false;
+    }
+    memcpy(&header, data, sizeof(header));
+    if (memcmp(header.magic, SNAPSHOT_MAGIC, 4) != 0 || header.version != SNAPSHOT_VERSION ||
+        header.columnCount != COLUMN_COUNT) {
+        snprintf(error, errorSize, "not a version %u snapshot", SNAPSHOT_VERSION);
+        return false;
+    }
+    const size_t n = header.bodyCount;
+    if (snapshotSize(n) > size) {
+        snprintf(error, errorSize, "snapshot is truncated");
+        return false;
+    }
+    const unsigned char* column = data + alignColumn(sizeof(header));
+    const int* parents = (const int*)(column + COLUMN_COUNT * alignColumn(n * sizeof(double)));
+    for (size_t i = 0; i < n; ++i) {
+        if (parents[i] < -1 || parents[i] >= (int)i) {
+            snprintf(error, errorSize, "body %d is malformed", (int)i);
+            return false;
+        }
+    }
+    if (header.mode > SIM_NBODY) {
+        snprintf(error, errorSize, "unknown simulation mode %u", header.mode);
+        return false;
+    }
+
+    for (uint32_t c = 0; c < COLUMN_COUNT; ++c) {
+        const double* values = (const double*)column;
+        (sim.*BODY_COLUMNS[c]).assign(values, values + n);
+        column += alignColumn(n * sizeof(double));
+    }
+    sim.parent.assign(parents, parents + n);
+    sim.fixedStep = header.fixedStep;
+    sim.timeWarp = header.timeWarp;
+    sim.centralMass = header.centralMass;
+    sim.gravity.theta = header.theta;
+    sim.gravity.softening = header.softening;
+    sim.ringAngle = header.ringAngle;
+    sim.prevRingAngle = header.prevRingAngle;
+    sim.restore((SimMode)header.mode, header.simTime, header.unwarpedTime, header.pendingTime, header.stepTotal);
+
+    scene.starSeed = header.starSeed;
+    memcpy(scene.camera, header.camera, sizeof(scene.camera));
+    scene.targetBody = header.targetBody < (int)n ? header.targetBody : -1;
+    scene.cameraMoving = header.cameraMoving;
+    scene.showTrails = header.showTrails;
+    scene.showDate = header.showDate;
+    return true;
+}
+
+bool loadSnapshot(const char* path, Simulation& sim, SceneState& scene, char* error, int errorSize) {
+    MappedFile file;
+    if (!mapFile(path, file)) {
+        snprintf(error, errorSize, "cannot open %s", path);
+        return false;
+    }
+    bool ok = unpackSnapshot(file.data, file.size, sim, scene, error, errorSize);
+    unmapFile(file);
+    return ok;
+}
+
+size_t saveSnapshotAsync(const char* path, const Simulation& sim, const SceneState& scene) {
+    finishSnapshotWrites();
+    packSnapshot(sim, scene, writeBuffer);
+    std::string target = path;
+    writer = std::thread([target] {
+        auto start = std::chrono::steady_clock::now();
+        // Write beside the old snapshot and replace it only once the new one is complete
+        std::string temporary = target + ".tmp";
+        FILE* out = fopen(temporary.c_str(), "wb");
+        bool ok = out && fwrite(writeBuffer.data(), 1, writeBuffer.size(), out) == writeBuffer.size();
+        if (out && fclose(out) != 0) ok = false;
+        if (ok) {
+            remove(target.c_str());  // rename() won't replace an existing file on Windows
+            ok = rename(temporary.c_str(), target.c_str()) == 0;
+        }
+        else {
+            remove(temporary.c_str());
+        }
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (ok) printf("Snapshot written to %s (%.1f MB in %.1f ms)\n", target.c_str(), writeBuffer.size() / 1048576.0, ms);
+        else printf("Could not write snapshot %s\n", target.c_str());
+    });
+    return writeBuffer.size();
+}
+
+void finishSnapshotWrites() {
+    if (writer.joinable()) writer.join();
+    std::vector<unsigned char>().swap(writeBuffer);  // Large states shouldn't stay in memory twice
+}
+
+// FNV-1a over raw bytes
+static uint64_t hashBytes(uint64_t hash, const void* data, size_t bytes) {
+    const unsigned char* p = (const unsigned char*)data;
+    for (size_t i = 0; i < bytes; ++i) {
+        hash ^= p[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+unsigned long long simulationStateHash(const Simulation& sim) {
+    uint64_t hash = 14695981039346656037ULL;
+    const double clocks[] = { sim.time(), sim.unwarpedTime(), sim.pendingTime(), sim.ringAngle, sim.prevRingAngle };
+    const long long steps = sim.stepCount();
+    const uint32_t mode = (uint32_t)sim.getMode();
+    hash = hashBytes(hash, clocks, sizeof(clocks));
+    hash = hashBytes(hash, &steps, sizeof(steps));
+    hash = hashBytes(hash, &mode, sizeof(mode));
+    for (auto column : STATE_COLUMNS) {
+        const std::vector<double>& values = sim.*column;
+        hash = hashBytes(hash, values.data(), values.size() * sizeof(double));
+    }
+    return hash;
+}
@@ -0,0 +1,41 @@
+// Simulation snapshots: the whole scene state in one binary file, written in the background and
+// memory-mapped back to resume
+#pragma once
+
+#include <stddef.h>           // size_t
+#include <vector>
+#include "Simulation.h"       // Simulation
+
+// What a resumed session needs besides the simulation to look the same
+struct SceneState {
+    unsigned starSeed;     // Seed the background stars were generated from
+    float camera[6];       // Eye position, then look-at point
+    int targetBody;        // Body the camera follows (-1 for none)
+    int cameraMoving;      // Camera is gliding back to the default view
+    int showTrails;        // Overlay toggles
+    int showDate;
+};
+
+// Pack the simulation and scene into a snapshot image: a header and one aligned column per
+// per-body array
+void packSnapshot(const Simulation& sim, const SceneState& scene, std::vector<unsigned char>& out);
+
+// Restore from a snapshot image (usually a mapped file). The simulation's body arrays are
+// replaced wholesale, so it continues bit for bit from where the snapshot was taken.
+// On failure returns false, leaves the simulation alone and describes the problem in error.
+bool unpackSnapshot(const unsigned char* data, size_t size, Simulation& sim, SceneState& scene,
+                    char* error, int errorSize);
+
+// Map a snapshot file and restore from it
+bool loadSnapshot(const char* path, Simulation& sim, SceneState& scene, char* error, int errorSize);
+
+// Pack now and write the file on a background thread (after the previous write has finished).
+// Returns the snapshot's size in bytes.
+size_t saveSnapshotAsync(const char* path, const Simulation& sim, const SceneState& scene);
+
+// Wait for a background write to finish (also needed before exit)
+void finishSnapshotWrites();
+
+// Hash of everything that evolves in a simulation (clocks, positions, velocities, spins and
+// rings), for checking that two runs match bit for bit
+unsigned long long simulationStateHash(const Simulation& sim);
@@ -0,0 +1,295 @@
+// Bounding volume hierarchy over body spheres for picking and proximity queries
+#include "SpatialIndex.h"
+#include <algorithm>          // nth_element, push_heap, pop_heap, sort_heap
+#include <float.h>            // FLT_MAX
+#include <math.h>             // sqrtf, fabsf
+
+// Traversal stack entries. Median splits keep the depth near log2(n / leafCapacity),
+// and a traversal holds at most two entries per level.
+static const int STACK_DEPTH = 96;
+static const int REFIT_GRAIN = 1024;  // Leaves per refit task
+
+// Sphere center and index, reordered while building
+struct BuildItem {
+    float c[3];
+    int index;
+};
+
+SpatialIndex::SpatialIndex()
+    : leafCapacity(4), rebuildRatio(1.5f), scheduler(0), px(0), py(0), pz(0), pr(0), sphereCount(0),
+      builtArea(0.0), rebuilds(0) {
+}
+
+// Split entries [begin, end) at the median of their longest axis under a new node; returns it
+static int buildNodes(std::vector<BvhNode>& nodes, std::vector<BuildItem>& entries, int begin, int end,
+                      int leafCapacity) {
+    const int node = (int)nodes.size();
+    nodes.push_back(BvhNode());
+    if (end - begin <= leafCapacity) {
+        nodes[node].offset = begin;
+        nodes[node].count = end - begin;
+        return node;
+    }
+
+    float lo[3] = { FLT_MAX, FLT_MAX, FLT_MAX }, hi[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+    for (int i = begin; i < end; ++i) {
+        for (int a = 0; a < 3; ++a) {
+            lo[a] = std::min(lo[a], entries[i].c[a]);
+            hi[a] = std::max(hi[a], entries[i].c[a]);
+        }
+    }
+    int axis = 0;
+    if (hi[1] - lo[1] > hi[axis] - lo[axis]) axis = 1;
+    if (hi[2] - lo[2] > hi[axis] - lo[axis]) axis = 2;
+
+    const int mid = (begin + end) / 2;
+    std::nth_element(entries.begin() + begin, entries.begin() + mid, entries.begin() + end,
+        [axis](const BuildItem& a, const BuildItem& b) { return a.c[axis] < b.c[axis]; });
+    buildNodes(nodes, entries, begin, mid, leafCapacity);  // The first child follows its parent
+    int second = buildNodes(nodes, entries, mid, end, leafCapacity);
+    nodes[node].offset = second;
+    nodes[node].count = 0;
+    return node;
+}
+
+void SpatialIndex::build(const float* x, const float* y, const float* z, const float* radius, int n) {
+    px = x; py = y; pz = z; pr = radius;
+    sphereCount = n;
+    nodes.clear();
+    items.clear();
+    leaves.clear();
+    builtArea = 0.0;
+    ++rebuilds;
+    if (n == 0) return;
+
+    std::vector<BuildItem> entries(n);
+    for (int i = 0; i < n; ++i) {
+        entries[i].c[0] = x[i];
+        entries[i].c[1] = y[i];
+        entries[i].c[2] = z[i];
+        entries[i].index = i;
+    }
+    const int capacity = std::max(leafCapacity, 1);
+    nodes.reserve(2 * (n / capacity + 1));
+    buildNodes(nodes, entries, 0, n, capacity);
+    items.resize(n);
+    for (int i = 0; i < n; ++i) items[i] = entries[i].index;
+    for (int i = 0; i < (int)nodes.size(); ++i) {
+        if (nodes[i].count > 0) leaves.push_back(i);
+    }
+    builtArea = refit();
+}
+
+bool SpatialIndex::update(const float* x, const float* y, const float* z, const float* radius, int n) {
+    if (n != sphereCount || nodes.empty()) {
+        build(x, y, z, radius, n);
+        return true;
+    }
+    px = x; py = y; pz = z; pr = radius;
+    // Bodies that started out together drift apart, so the bounds only grow looser
+    if (refit() > rebuildRatio * builtArea) {
+        build(x, y, z, radius, n);
+        return true;
+    }
+    return false;
+}
+
+double SpatialIndex::refit() {
+    // Leaves read the scattered sphere arrays, so they are the expensive part and run in parallel
+    parallelFor(scheduler, 0, (int)leaves.size(), REFIT_GRAIN, [&](int begin, int end) {
+        for (int l = begin; l < end; ++l) {
+            BvhNode& node = nodes[leaves[l]];
+            float minX = FLT_MAX, minY = FLT_MAX, minZ = FLT_MAX;
+            float maxX = -FLT_MAX, maxY = -FLT_MAX, maxZ = -FLT_MAX;
+            for (int j = node.offset; j < node.offset + node.count; ++j) {
+                const int s = items[j];
+                const float r = pr[s];
+                minX = std::min(minX, px[s] - r); maxX = std::max(maxX, px[s] + r);
+                minY = std::min(minY, py[s] - r); maxY = std::max(maxY, py[s] + r);
+                minZ = std::min(minZ, pz[s] - r); maxZ = std::max(maxZ, pz[s] + r);
+            }
+            node.minX = minX; node.minY = minY; node.minZ = minZ;
+            node.maxX = maxX; node.maxY = maxY; node.maxZ = maxZ;
+        }
+    });
+
+    // Children always come after their parent, so a reverse sweep sees them first
+    double area = 0.0;
+    for (int i = (int)nodes.size() - 1; i >= 0; --i) {
+        BvhNode& node = nodes[i];
+        if (node.count == 0) {
+            const BvhNode& a = nodes[i + 1];
+            const BvhNode& b = nodes[node.offset];
+            node.minX = std::min(a.minX, b.minX); node.maxX = std::max(a.maxX, b.maxX);
+            node.minY = std::min(a.minY, b.minY); node.maxY = std::max(a.maxY, b.maxY);
+            node.minZ = std::min(a.minZ, b.minZ); node.maxZ = std::max(a.maxZ, b.maxZ);
+            double dx = node.maxX - node.minX, dy = node.maxY - node.minY, dz = node.maxZ - node.minZ;
+            area += dx * dy + dy * dz + dz * dx;
+        }
+    }
+    return area;
+}
+
+// Distance along the ray to where it enters the box grown by pad, or -1 when it misses
+// before limit. inv holds 1 / direction per axis.
+static float rayEnter(const BvhNode& n, const float o[3], const float inv[3], float pad, float limit) {
+    float t0 = 0.0f, t1 = limit;
+    const float lo[3] = { n.minX - pad, n.minY - pad, n.minZ - pad };
+    const float hi[3] = { n.maxX + pad, n.maxY + pad, n.maxZ + pad };
+    for (int a = 0; a < 3; ++a) {
+        float tLo = (lo[a] - o[a]) * inv[a], tHi = (hi[a] - o[a]) * inv[a];
+        if (tLo > tHi) std::swap(tLo, tHi);
+        t0 = std::max(t0, tLo);
+        t1 = std::min(t1, tHi);
+    }
+    return t0 <= t1 ? t0 : -1.0f;
+}
+
+// Growth of a box under a widening ray: spread times the distance to its far side
+static float conePad(const BvhNode& n, const float o[3], float spread) {
+    if (spread <= 0.0f) return 0.0f;
+    float cx = 0.5f * (n.minX + n.maxX) - o[0], hx = 0.5f * (n.maxX - n.minX);
+    float cy = 0.5f * (n.minY + n.maxY) - o[1], hy = 0.5f * (n.maxY - n.minY);
+    float cz = 0.5f * (n.minZ + n.maxZ) - o[2], hz = 0.5f * (n.maxZ - n.minZ);
+    return spread * (sqrtf(cx * cx + cy * cy + cz * cz) + sqrtf(hx * hx + hy * hy + hz * hz));
+}
+
+int SpatialIndex::raycast(const float origin[3], const float dir[3], float spread, float* hitDistance) const {
+    if (nodes.empty()) return -1;
+    float length = sqrtf(dir[0] * dir[0] + dir[1] * dir[1] + dir[2] * dir[2]);
+    if (length <= 0.0f) return -1;
+    const float d[3] = { dir[0] / length, dir[1] / length, dir[2] / length };
+    float inv[3];
+    for (int a = 0; a < 3; ++a) inv[a] = fabsf(d[a]) > 1e-12f ? 1.0f / d[a] : 1e30f;
+
+    float best = FLT_MAX;
+    int hit = -1;
+    int stack[STACK_DEPTH];
+    float enter[STACK_DEPTH];
+    int top = 0;
+    float t = rayEnter(nodes[0], origin, inv, conePad(nodes[0], origin, spread), best);
+    if (t >= 0.0f) { stack[top] = 0; enter[top++] = t; }
+
+    while (top > 0) {
+        --top;
+        if (enter[top] > best) continue;  // Something nearer was hit since this was pushed
+        const BvhNode& node = nodes[stack[top]];
+        if (node.count > 0) {
+            for (int j = node.offset; j < node.offset + node.count; ++j) {
+                const int s = items[j];
+                float ox = px[s] - origin[0], oy = py[s] - origin[1], oz = pz[s] - origin[2];
+                float along = ox * d[0] + oy * d[1] + oz * d[2];
+                float r = pr[s] + spread * std::max(along, 0.0f);
+                float miss2 = ox * ox + oy * oy + oz * oz - along * along;  // Squared distance from the ray
+                if (miss2 > r * r) continue;
+                float half = sqrtf(r * r - miss2);
+                if (along + half < 0.0f) continue;  // Behind the origin
+                float tHit = std::max(along - half, 0.0f);
+                if (tHit < best) {
+                    best = tHit;
+                    hit = s;
+                }
+            }
+            continue;
+        }
+        // Visit the child the ray enters first before the other
+        const int a = stack[top] + 1, b = node.offset;
+        float ta = rayEnter(nodes[a], origin, inv, conePad(nodes[a], origin, spread), best);
+        float tb = rayEnter(nodes[b], origin, inv, conePad(nodes[b], origin, spread), best);
+        if (ta >= 0.0f && tb >= 0.0f && ta < tb) {
+            stack[top] = b; enter[top++] = tb;
+            stack[top] = a; enter[top++] = ta;
+        }
+        else {
+            if (ta >= 0.0f) { stack[top] = a; enter[top++] = ta; }
+            if (tb >= 0.0f) { stack[top] = b; enter[top++] = tb; }
+        }
+    }
+    if (hitDistance && hit >= 0) *hitDistance = best;
+    return hit;
+}
+
+// Squared distance from a point to a node's box (0 inside)
+static float boxDistance2(const BvhNode& n, float x, float y, float z) {
+    float dx = std::max(std::max(n.minX - x, x - n.maxX), 0.0f);
+    float dy = std::max(std::max(n.minY - y, y - n.maxY), 0.0f);
+    float dz = std::max(std::max(n.minZ - z, z - n.maxZ), 0.0f);
+    return dx * dx + dy * dy + dz * dz;
+}
+
+int SpatialIndex::nearest(float x, float y, float z, int k, int* indices, float* distances) const {
+    k = std::min(k, sphereCount);
+    if (k <= 0 || nodes.empty()) return 0;
+
+    // Max-heap of the best k so far: the worst of them is at the front
+    std::vector<std::pair<float, int> > heap;
+    heap.reserve(k);
+    int stack[STACK_DEPTH];
+    float bound[STACK_DEPTH];
+    int top = 0;
+    stack[top] = 0; bound[top++] = boxDistance2(nodes[0], x, y, z);
+
+    while (top > 0) {
+        --top;
+        if ((int)heap.size() == k && bound[top] >= heap.front().first) continue;
+        const BvhNode& node = nodes[stack[top]];
+        if (node.count > 0) {
+            for (int j = node.offset; j < node.offset + node.count; ++j) {
+                const int s = items[j];
+                float dx = px[s] - x, dy = py[s] - y, dz = pz[s] - z;
+                float d2 = dx * dx + dy * dy + dz * dz;
+                if ((int)heap.size() < k) {
+                    heap.push_back(std::make_pair(d2, s));
+                    std::push_heap(heap.begin(), heap.end());
+                }
+                else if (d2 < heap.front().first) {
+                    std::pop_heap(heap.begin(), heap.end());
+                    heap.back() = std::make_pair(d2, s);
+                    std::push_heap(heap.begin(), heap.end());
+                }
+            }
+            continue;
+        }
+        // Nearer child on top of the stack
+        const int a = stack[top] + 1, b = node.offset;
+        float da = boxDistance2(nodes[a], x, y, z), db = boxDistance2(nodes[b], x, y, z);
+        if (da < db) {
+            stack[top] = b; bound[top++] = db;
+            stack[top] = a; bound[top++] = da;
+        }
+        else {
+            stack[top] = a; bound[top++] = da;
+            stack[top] = b; bound[top++] = db;
+        }
+    }
+
+    std::sort_heap(heap.begin(), heap.end());
+    for (int i = 0; i < (int)heap.size(); ++i) {
+        indices[i] = heap[i].second;
+        if (distances) distances[i] = sqrtf(heap[i].first);
+    }
+    return (int)heap.size();
+}
+
+void SpatialIndex::withinRadius(float x, float y, float z, float radius, std::vector<int>& out) const {
+    if (nodes.empty()) return;
+    int stack[STACK_DEPTH];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        const int index = stack[--top];
+        const BvhNode& node = nodes[index];
+        if (boxDistance2(node, x, y, z) > radius * radius) continue;  // Boxes already include the radii
+        if (node.count > 0) {
+            for (int j = node.offset; j < node.offset + node.count; ++j) {
+                const int s = items[j];
+                float dx = px[s] - x, dy = py[s] - y, dz = pz[s] - z;
+                float reach = radius + pr[s];
+                if (dx * dx + dy * dy + dz * dz <= reach * reach) out.push_back(s);
+            }
+            continue;
+        }
+        stack[top++] = index + 1;
+        stack[top++] = node.offset;
+    }
+}
@@ -0,0 +1,60 @@
+// Bounding volume hierarchy over body spheres for picking and proximity queries
+#pragma once
+
+#include <vector>
+#include "TaskScheduler.h"    // Parallel refit of the leaves
+
+// Node of the hierarchy (stored in a flat array, depth first)
+struct BvhNode {
+    float minX, minY, minZ;  // Bounds of every sphere below this node
+    float maxX, maxY, maxZ;
+    int offset;              // Internal: index of the second child (the first follows this node).
+                             // Leaf: first entry in the item list.
+    int count;               // Spheres in a leaf (0 for internal nodes)
+};
+
+// Hierarchy built once over a set of spheres, then refitted as they move. The topology is kept
+// until refitting has loosened the bounds too far, and then rebuilt.
+class SpatialIndex {
+public:
+    SpatialIndex();
+
+    // Build over n spheres in structure-of-arrays form
+    void build(const float* x, const float* y, const float* z, const float* radius, int n);
+
+    // Refresh the bounds from the spheres' current positions (a rebuild when n changed or the
+    // tree has degraded). The arrays are read again by the queries. Returns true when it rebuilt.
+    bool update(const float* x, const float* y, const float* z, const float* radius, int n);
+
+    // First sphere hit by the ray from origin along dir (-1 for none), with the distance to it.
+    // spread widens every sphere by that much per unit of distance, so tiny far bodies stay
+    // pickable within a few pixels of the cursor.
+    int raycast(const float origin[3], const float dir[3], float spread, float* hitDistance = 0) const;
+
+    // Up to k sphere centers nearest to a point, nearest first; returns how many were found
+    int nearest(float px, float py, float pz, int k, int* indices, float* distances) const;
+
+    // Every sphere that touches the ball of the given radius around a point (appended to out)
+    void withinRadius(float px, float py, float pz, float radius, std::vector<int>& out) const;
+
+    int leafCapacity;     // Spheres per leaf
+    float rebuildRatio;   // Rebuild once the nodes' total surface area grows by this factor
+    TaskScheduler* scheduler;  // Splits the leaf refit across cores (null runs serially)
+
+    int nodeCount() const { return (int)nodes.size(); }
+    int buildCount() const { return rebuilds; }  // Builds so far, the first included
+
+private:
+    double refit();                      // Bottom-up bounds; returns the internal nodes' total area
+
+    std::vector<BvhNode> nodes;
+    std::vector<int> items;  // Sphere indices, grouped by leaf
+    std::vector<int> leaves; // Node index of every leaf
+    const float* px;         // Sphere arrays from the last build() or update()
+    const float* py;
+    const float* pz;
+    const float* pr;
+    int sphereCount;
+    double builtArea;        // Total area right after the last build
+    int rebuilds;            // Builds so far
+};
@@ -0,0 +1,104 @@
+// Static starfield uploaded once and animated entirely on the GPU
+#include "Starfield.h"
+#include "GLExtensions.h"     // Buffer objects and shaders
+
+static const int BRIGHT_STARS = 20;         // Brighter stars pushed further out
+static const float BRIGHT_SIZE = 2.4f;      // Draws at 3 px: 2.4 * (1 + 0.5 * 0.5) with no flicker
+static const GLuint PARAMS_ATTRIB = 1;      // Generic attribute holding size/brightness/speed
+
+// Interleaved per-star vertex: position then the flicker parameters
+struct StarVertex {
+    float x, y, z;
+    float size, brightness, flickerSpeed;
+};
+
+static GLuint starBuffer = 0;               // Static vertex buffer
+static std::vector<StarVertex> clientStars; // Used only when buffers are unavailable
+static GLsizei starCount = 0;
+static GLuint starProgram = 0;
+static GLint timeUniform = -1;
+
+// Point size follows the old per-star CPU flicker exactly; stars stay pure white as before
+static const char* starVertexShader =
+    "#version 110\n"
+    "attribute vec3 starParams;  // size, brightness (unused), flickerSpeed\n"
+    "uniform float time;\n"
+    "void main() {\n"
+    "    float flicker = 0.5 + 0.5 * sin(time * starParams.z);\n"
+    "    gl_PointSize = starParams.x * (1.0 + flicker * 0.5);\n"
+    "    gl_FrontColor = vec4(1.0);\n"
+    "    gl_Position = ftransform();\n"
+    "}\n";
+
+static const char* starFragmentShader =
+    "#version 110\n"
+    "void main() {\n"
+    "    gl_FragColor = gl_Color;\n"
+    "}\n";
+
+void initStarfield(const std::vector<Star>& stars) {
+    std::vector<StarVertex> vertices;
+    vertices.reserve(stars.size() + BRIGHT_STARS);
+    for (const auto& star : stars) {
+        StarVertex v = { star.x, star.y, star.z, star.size, star.brightness, star.flickerSpeed };
+        vertices.push_back(v);
+    }
+    // Brighter stars: the first few again, further out, fixed size and no flicker
+    for (int i = 0; i < BRIGHT_STARS && i < (int)stars.size(); ++i) {
+        StarVertex v = { stars[i].x * 1.5f, stars[i].y * 1.5f, stars[i].z * 1.5f, BRIGHT_SIZE, 1.0f, 0.0f };
+        vertices.push_back(v);
+    }
+    starCount = (GLsizei)vertices.size();
+
+    if (hasVertexBuffers) {
+        if (!starBuffer) glGenBuffers(1, &starBuffer);
+        glBindBuffer(GL_ARRAY_BUFFER, starBuffer);
+        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(StarVertex), vertices.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        clientStars.clear();
+    }
+    else {
+        clientStars.swap(vertices);
+    }
+
+    if (!starProgram) {
+        const char* attributes[] = { "starParams" };
+        starProgram = buildProgram(starVertexShader, starFragmentShader, attributes, &PARAMS_ATTRIB, 1);
+        if (starProgram) timeUniform = glGetUniformLocation(starProgram, "time");
+    }
+}
+
+void drawStarfield(float time) {
+    if (starCount == 0) return;
+
+    glPushAttrib(GL_ENABLE_BIT | GL_CURRENT_BIT | GL_POINT_BIT);
+    glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
+    glDisable(GL_LIGHTING);     // Stars emit their own light
+
+    const char* base = starBuffer ? 0 : (const char*)clientStars.data();
+    if (starBuffer) glBindBuffer(GL_ARRAY_BUFFER, starBuffer);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(3, GL_FLOAT, sizeof(StarVertex), base);
+
+    if (starProgram) {
+        // Flicker and point size are computed per vertex on the GPU
+        glEnable(GL_VERTEX_PROGRAM_POINT_SIZE);
+        glUseProgram(starProgram);
+        glUniform1f(timeUniform, time);
+        glEnableVertexAttribArray(PARAMS_ATTRIB);
+        glVertexAttribPointer(PARAMS_ATTRIB, 3, GL_FLOAT, GL_FALSE, sizeof(StarVertex), base + 3 * sizeof(float));
+        glDrawArrays(GL_POINTS, 0, starCount);
+        glDisableVertexAttribArray(PARAMS_ATTRIB);
+        glUseProgram(0);
+    }
+    else {
+        // No shaders: same single draw, without flicker
+        glColor3f(1.0f, 1.0f, 1.0f);
+        glPointSize(1.0f);
+        glDrawArrays(GL_POINTS, 0, starCount);
+    }
+
+    if (starBuffer) glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glPopClientAttrib();
+    glPopAttrib();
+}
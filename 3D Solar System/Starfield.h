@@ -0,0 +1,19 @@
+// Static starfield uploaded once and animated entirely on the GPU
+#pragma once
+
+#include <vector>
+
+// Structure to represent a star in the background
+struct Star {
+    float x, y, z;         // 3D position coordinates
+    float size;            // Visual size of the star
+    float brightness;      // Base brightness level
+    float flickerSpeed;    // Speed of brightness variation
+};
+
+// Upload the stars (plus a handful of brighter ones) into a static vertex buffer.
+// The CPU copy is not needed afterwards.
+void initStarfield(const std::vector<Star>& stars);
+
+// Draw the whole starfield in one call; flicker is evaluated in the shader
+void drawStarfield(float time);
@@ -0,0 +1,119 @@
+// Work-stealing thread pool for splitting per-frame work across cores
+#include "TaskScheduler.h"
+#include <algorithm>          // std::min
+
+// Queue owned by the current thread (0 for threads outside the pool)
+static thread_local int currentQueue = 0;
+
+TaskScheduler::TaskScheduler(int threadCount) : queued(0), stopping(false) {
+    if (threadCount <= 0) threadCount = (int)std::thread::hardware_concurrency();
+    if (threadCount <= 0) threadCount = 1;
+
+    for (int i = 0; i < threadCount; ++i)
+        queues.push_back(new WorkQueue());
+    // The submitting thread works too, so start one fewer worker
+    for (int i = 1; i < threadCount; ++i)
+        workers.push_back(std::thread(&TaskScheduler::workerLoop, this, i));
+}
+
+TaskScheduler::~TaskScheduler() {
+    {
+        std::lock_guard<std::mutex> guard(sleepLock);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& worker : workers)
+        worker.join();
+    for (auto* queue : queues)
+        delete queue;
+}
+
+bool TaskScheduler::popLocal(int queue, Task& task) {
+    WorkQueue& q = *queues[queue];
+    std::lock_guard<std::mutex> guard(q.lock);
+    if (q.tasks.empty()) return false;
+    task = q.tasks.back();
+    q.tasks.pop_back();
+    queued--;
+    return true;
+}
+
+bool TaskScheduler::steal(int thief, Task& task) {
+    const int count = (int)queues.size();
+    for (int i = 1; i < count; ++i) {
+        WorkQueue& q = *queues[(thief + i) % count];
+        std::lock_guard<std::mutex> guard(q.lock);
+        if (q.tasks.empty()) continue;
+        task = q.tasks.front();
+        q.tasks.pop_front();
+        queued--;
+        return true;
+    }
+    return false;
+}
+
+bool TaskScheduler::findTask(int queue, Task& task) {
+    return popLocal(queue, task) || steal(queue, task);
+}
+
+void TaskScheduler::runTask(Task& task) {
+    (*task.body)(task.begin, task.end);
+    task.pending->fetch_sub(1);
+}
+
+void TaskScheduler::workerLoop(int queue) {
+    currentQueue = queue;
+    for (;;) {
+        Task task;
+        if (findTask(queue, task)) {
+            runTask(task);
+            continue;
+        }
+        // Nothing to do: sleep until more work is queued
+        std::unique_lock<std::mutex> guard(sleepLock);
+        wake.wait(guard, [this] { return stopping || queued > 0; });
+        if (stopping) return;
+    }
+}
+
+void TaskScheduler::parallelFor(int begin, int end, int grain, const RangeFunc& body) {
+    if (end <= begin) return;
+    if (grain < 1) grain = 1;
+    int chunks = (end - begin + grain - 1) / grain;
+    if (chunks == 1 || workers.empty()) {
+        body(begin, end);
+        return;
+    }
+
+    // Deal the chunks round-robin over every queue, starting with our own
+    std::atomic<int> pending(chunks);
+    const int count = (int)queues.size();
+    const int home = currentQueue;
+    for (int c = 0; c < chunks; ++c) {
+        Task task = { &body, begin + c * grain, std::min(end, begin + (c + 1) * grain), &pending };
+        WorkQueue& q = *queues[(home + c) % count];
+        std::lock_guard<std::mutex> guard(q.lock);
+        q.tasks.push_back(task);
+        queued++;
+    }
+    {
+        std::lock_guard<std::mutex> guard(sleepLock);
+    }
+    wake.notify_all();
+
+    // Help out until every chunk of this loop has finished
+    while (pending > 0) {
+        Task task;
+        if (findTask(home, task))
+            runTask(task);
+        else
+            std::this_thread::yield();
+    }
+}
+
+void parallelFor(TaskScheduler* scheduler, int begin, int end, int grain, const RangeFunc& body) {
+    if (scheduler)
+        scheduler->parallelFor(begin, end, grain, body);
+    else if (end > begin)
+        body(begin, end);
+}
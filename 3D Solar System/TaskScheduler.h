@@ -0,0 +1,55 @@
+// Work-stealing thread pool for splitting per-frame work across cores
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Body of a parallel loop: processes the index range [begin, end)
+typedef std::function<void(int begin, int end)> RangeFunc;
+
+// Pool of worker threads, each with its own task deque. Idle workers steal
+// from the front of other deques while owners pop from the back.
+class TaskScheduler {
+public:
+    // threadCount includes the calling thread; 0 picks the hardware thread count
+    explicit TaskScheduler(int threadCount = 0);
+    ~TaskScheduler();
+
+    int threadCount() const { return (int)workers.size() + 1; }
+
+    // Split [begin, end) into chunks of at most grain items and run them on all
+    // threads. The calling thread helps and returns once every chunk is done.
+    void parallelFor(int begin, int end, int grain, const RangeFunc& body);
+
+private:
+    struct Task {
+        const RangeFunc* body;       // Loop body shared by all chunks of one parallelFor
+        int begin, end;              // Chunk range
+        std::atomic<int>* pending;   // Chunks of the owning parallelFor still running
+    };
+    struct WorkQueue {
+        std::mutex lock;
+        std::deque<Task> tasks;
+    };
+
+    bool popLocal(int queue, Task& task);  // Newest task from our own queue
+    bool steal(int thief, Task& task);     // Oldest task from any other queue
+    bool findTask(int queue, Task& task);
+    void runTask(Task& task);
+    void workerLoop(int queue);
+
+    std::vector<std::thread> workers;
+    std::vector<WorkQueue*> queues;    // Queue 0 belongs to submitting threads
+    std::mutex sleepLock;              // Guards sleeping workers
+    std::condition_variable wake;      // Signalled when tasks are queued or on shutdown
+    std::atomic<int> queued;           // Tasks sitting in any queue
+    std::atomic<bool> stopping;
+};
+
+// Run body over [begin, end) on the scheduler, or inline when there is none
+void parallelFor(TaskScheduler* scheduler, int begin, int end, int grain, const RangeFunc& body);
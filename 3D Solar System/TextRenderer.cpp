@@ -0,0 +1,218 @@
+// Batched screen text drawn from a glyph atlas in one call per frame
+#include "TextRenderer.h"
+#include "GLExtensions.h"     // Buffer objects and framebuffer objects
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#define TEXT_FONT GLUT_BITMAP_HELVETICA_18
+static const int FIRST_GLYPH = 32;        // Printable ASCII only
+static const int GLYPH_COUNT = 95;
+static const int CELL = 32;               // Atlas cell per glyph (pixels)
+static const int CELL_ORIGIN_X = 4;       // Pen position inside a cell
+static const int CELL_ORIGIN_Y = 8;       // Baseline inside a cell (room for descenders)
+static const int ATLAS_COLUMNS = 16;
+static const int ATLAS_WIDTH = 512;
+static const int ATLAS_HEIGHT = 256;
+static const size_t MAX_LAYOUTS = 1024;   // Cached strings before the cache is reset
+
+// One corner of a glyph quad
+struct TextVertex {
+    float x, y;
+    float s, t;
+    unsigned char color[4];
+};
+
+static GLuint atlasTexture = 0;
+static int glyphAdvance[GLYPH_COUNT];
+static GLuint textBuffer = 0;                    // Streamed vertex buffer (0 uses client arrays)
+static std::vector<TextVertex> batch;            // Everything queued this frame
+static std::unordered_map<std::string, std::vector<TextVertex> > layouts;  // Quads at the origin per string
+
+// Draw every glyph with GLUT into the currently bound framebuffer and read it back
+static void rasterizeGlyphs(std::vector<unsigned char>& alpha) {
+    glPushAttrib(GL_ALL_ATTRIB_BITS);
+    glDisable(GL_LIGHTING);
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_TEXTURE_2D);
+    glDisable(GL_BLEND);
+    glViewport(0, 0, ATLAS_WIDTH, ATLAS_HEIGHT);
+    glMatrixMode(GL_PROJECTION);
+    glPushMatrix();
+    glLoadIdentity();
+    gluOrtho2D(0, ATLAS_WIDTH, 0, ATLAS_HEIGHT);
+    glMatrixMode(GL_MODELVIEW);
+    glPushMatrix();
+    glLoadIdentity();
+
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glColor3f(1.0f, 1.0f, 1.0f);
+    for (int i = 0; i < GLYPH_COUNT; ++i) {
+        glRasterPos2i((i % ATLAS_COLUMNS) * CELL + CELL_ORIGIN_X, (i / ATLAS_COLUMNS) * CELL + CELL_ORIGIN_Y);
+        glutBitmapCharacter(TEXT_FONT, FIRST_GLYPH + i);
+        glyphAdvance[i] = glutBitmapWidth(TEXT_FONT, FIRST_GLYPH + i);
+    }
+    alpha.resize(ATLAS_WIDTH * ATLAS_HEIGHT);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, ATLAS_WIDTH, ATLAS_HEIGHT, GL_RED, GL_UNSIGNED_BYTE, alpha.data());
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+
+    glPopMatrix();
+    glMatrixMode(GL_PROJECTION);
+    glPopMatrix();
+    glMatrixMode(GL_MODELVIEW);
+    glPopAttrib();
+}
+
+void initText() {
+    if (atlasTexture) return;
+
+    // Render into a scratch framebuffer when possible so the window contents don't matter
+    GLint previous = 0;
+    GLuint framebuffer = 0, renderbuffer = 0;
+    if (hasFramebuffers) {
+        glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previous);
+        glGenFramebuffers(1, &framebuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glGenRenderbuffers(1, &renderbuffer);
+        glBindRenderbuffer(GL_RENDERBUFFER, renderbuffer);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, ATLAS_WIDTH, ATLAS_HEIGHT);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderbuffer);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+            glBindFramebuffer(GL_FRAMEBUFFER, previous);
+            glDeleteFramebuffers(1, &framebuffer);
+            glDeleteRenderbuffers(1, &renderbuffer);
+            framebuffer = 0;
+        }
+    }
+    if (!framebuffer) glDrawBuffer(GL_BACK);  // The back buffer is cleared before the first frame anyway
+
+    std::vector<unsigned char> alpha;
+    rasterizeGlyphs(alpha);
+
+    if (framebuffer) {
+        glBindFramebuffer(GL_FRAMEBUFFER, previous);
+        glDeleteFramebuffers(1, &framebuffer);
+        glDeleteRenderbuffers(1, &renderbuffer);
+    }
+
+    // Coverage goes into an alpha texture; color comes from the vertices
+    glGenTextures(1, &atlasTexture);
+    glBindTexture(GL_TEXTURE_2D, atlasTexture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_ALPHA, ATLAS_WIDTH, ATLAS_HEIGHT, 0, GL_ALPHA, GL_UNSIGNED_BYTE, alpha.data());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);  // Pixel-exact glyphs
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    if (hasVertexBuffers) glGenBuffers(1, &textBuffer);
+}
+
+// Build (or fetch) the quads of a string laid out from the origin in white
+static const std::vector<TextVertex>& layoutText(const char* text) {
+    auto found = layouts.find(text);
+    if (found != layouts.end()) return found->second;
+    if (layouts.size() >= MAX_LAYOUTS) layouts.clear();  // Changing strings (timers) would grow it forever
+
+    std::vector<TextVertex>& quads = layouts[text];
+    int pen = 0;
+    for (const char* c = text; *c; ++c) {
+        int glyph = (unsigned char)*c - FIRST_GLYPH;
+        if (glyph < 0 || glyph >= GLYPH_COUNT) continue;
+        // The whole cell is drawn; its transparent margin covers glyphs that overhang the pen
+        float x0 = (float)(pen - CELL_ORIGIN_X), y0 = (float)-CELL_ORIGIN_Y;
+        float x1 = x0 + CELL, y1 = y0 + CELL;
+        float s0 = (float)((glyph % ATLAS_COLUMNS) * CELL) / ATLAS_WIDTH;
+        float t0 = (float)((glyph / ATLAS_COLUMNS) * CELL) / ATLAS_HEIGHT;
+        float s1 = s0 + (float)CELL / ATLAS_WIDTH, t1 = t0 + (float)CELL / ATLAS_HEIGHT;
+        TextVertex corners[4] = {
+            { x0, y0, s0, t0, { 255, 255, 255, 255 } },
+            { x1, y0, s1, t0, { 255, 255, 255, 255 } },
+            { x1, y1, s1, t1, { 255, 255, 255, 255 } },
+            { x0, y1, s0, t1, { 255, 255, 255, 255 } }
+        };
+        quads.insert(quads.end(), corners, corners + 4);
+        pen += glyphAdvance[glyph];
+    }
+    return quads;
+}
+
+void addText(float x, float y, const char* text, float r, float g, float b) {
+    if (!atlasTexture) return;
+    const std::vector<TextVertex>& quads = layoutText(text);
+    // Snap to whole pixels so nearest sampling reproduces the bitmap exactly
+    float px = (float)(int)(x + 0.5f), py = (float)(int)(y + 0.5f);
+    unsigned char color[4] = {
+        (unsigned char)(r * 255.0f + 0.5f), (unsigned char)(g * 255.0f + 0.5f), (unsigned char)(b * 255.0f + 0.5f), 255
+    };
+    size_t start = batch.size();
+    batch.insert(batch.end(), quads.begin(), quads.end());
+    for (size_t i = start; i < batch.size(); ++i) {
+        batch[i].x += px;
+        batch[i].y += py;
+        for (int k = 0; k < 4; ++k) batch[i].color[k] = color[k];
+    }
+}
+
+int textWidth(const char* text) {
+    if (!atlasTexture) return 0;
+    int width = 0;
+    for (const char* c = text; *c; ++c) {
+        int glyph = (unsigned char)*c - FIRST_GLYPH;
+        if (glyph >= 0 && glyph < GLYPH_COUNT) width += glyphAdvance[glyph];
+    }
+    return width;
+}
+
+void flushText(int windowWidth, int windowHeight) {
+    if (batch.empty()) return;
+
+    glPushAttrib(GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT | GL_TEXTURE_BIT | GL_CURRENT_BIT);
+    glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
+    glDisable(GL_LIGHTING);
+    glDisable(GL_DEPTH_TEST);  // Overlay text always sits on top
+    glEnable(GL_TEXTURE_2D);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glBindTexture(GL_TEXTURE_2D, atlasTexture);
+    glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+
+    // Window-pixel projection for the whole batch
+    glMatrixMode(GL_PROJECTION);
+    glPushMatrix();
+    glLoadIdentity();
+    gluOrtho2D(0, windowWidth, 0, windowHeight);
+    glMatrixMode(GL_MODELVIEW);
+    glPushMatrix();
+    glLoadIdentity();
+
+    // Stream the batch into fresh storage so we never wait on last frame's draw
+    const char* base = (const char*)batch.data();
+    if (textBuffer) {
+        glBindBuffer(GL_ARRAY_BUFFER, textBuffer);
+        glBufferData(GL_ARRAY_BUFFER, batch.size() * sizeof(TextVertex), batch.data(), GL_STREAM_DRAW);
+        base = 0;
+    }
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+    glVertexPointer(2, GL_FLOAT, sizeof(TextVertex), base + offsetof(TextVertex, x));
+    glTexCoordPointer(2, GL_FLOAT, sizeof(TextVertex), base + offsetof(TextVertex, s));
+    glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(TextVertex), base + offsetof(TextVertex, color));
+    glDrawArrays(GL_QUADS, 0, (GLsizei)batch.size());
+    if (textBuffer) glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glPopMatrix();
+    glMatrixMode(GL_PROJECTION);
+    glPopMatrix();
+    glMatrixMode(GL_MODELVIEW);
+    glPopClientAttrib();
+    glPopAttrib();
+    batch.clear();
+}
+
+int cachedTextLayouts() {
+    return (int)layouts.size();
+}
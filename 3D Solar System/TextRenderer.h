@@ -0,0 +1,19 @@
+// Batched screen text drawn from a glyph atlas in one call per frame
+#pragma once
+
+// Rasterize the GLUT Helvetica 18 font into a texture atlas; call once after
+// loadGLExtensions() with GLUT initialized. Without it nothing is drawn; headless
+// runs that can't start GLUT say so.
+void initText();
+
+// Queue a string with its baseline starting at (x, y) in window pixels (origin bottom-left)
+void addText(float x, float y, const char* text, float r = 1.0f, float g = 1.0f, float b = 1.0f);
+
+// Width of a string in pixels
+int textWidth(const char* text);
+
+// Draw every string queued this frame with one draw call, then empty the batch
+void flushText(int windowWidth, int windowHeight);
+
+// Layouts kept for strings seen recently (reused while a string is unchanged)
+int cachedTextLayouts();
@@ -0,0 +1,273 @@
+// Parallel texture decoding with a memory-mapped cache of prebuilt mip chains
+#include "TextureLoader.h"
+#include "MappedFile.h"       // Memory-mapped cache reads
+#include <SOIL.h>             // Simple OpenGL Image Library for image decoding
+#include <stdio.h>            // Cache file writing
+#include <string.h>           // memcpy, memchr, strcmp
+#include <stdint.h>           // Fixed-size cache fields
+#include <sys/stat.h>         // Source file size and modification time
+#include <chrono>             // Load timings
+#include <vector>
+
+// Define GL_CLAMP_TO_EDGE if not already defined by the system
+#ifndef GL_CLAMP_TO_EDGE
+#define GL_CLAMP_TO_EDGE 0x812F
+#endif
+
+static const char CACHE_MAGIC[4] = { 'S', 'T', 'X', 'C' };
+static const uint32_t CACHE_VERSION = 2;  // 2 widened names to fit any catalog texture path
+static const int MAX_LEVELS = 16;       // Enough for 32K x 32K
+static const uint32_t MAX_SIZE = 1u << (MAX_LEVELS - 1);  // Largest side a cache entry may claim
+static const int NAME_LENGTH = 256;    // Terminator included; longer names are never cached
+
+// Fixed-layout records at the start of the cache file
+struct CacheHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t count;
+    uint32_t reserved;
+};
+struct CacheEntry {
+    char name[NAME_LENGTH];             // Source file name, null-terminated
+    uint64_t sourceSize;                // Source size and time, to detect edits
+    int64_t sourceTime;
+    uint32_t width, height, channels, levels;
+    uint64_t levelOffset[MAX_LEVELS];   // From the start of the file
+    uint64_t levelSize[MAX_LEVELS];
+};
+
+// One decoded image with its whole mip chain in a single allocation
+struct DecodedImage {
+    int width, height, channels, levels;
+    std::vector<unsigned char> pixels;
+    size_t levelOffset[MAX_LEVELS];
+    size_t levelSize[MAX_LEVELS];
+};
+
+static double msSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Size and modification time of a source file (false if missing)
+static bool sourceStamp(const char* path, uint64_t& size, int64_t& time) {
+    struct stat info;
+    if (stat(path, &info) != 0) return false;
+    size = (uint64_t)info.st_size;
+    time = (int64_t)info.st_mtime;
+    return true;
+}
+
+// Decode one file, flip it and build its mip chain with a 2x2 box filter
+static bool decodeImage(const char* path, DecodedImage& image) {
+    int w, h, sourceChannels;
+    unsigned char* data = SOIL_load_image(path, &w, &h, &sourceChannels, SOIL_LOAD_AUTO);
+    if (!data) return false;
+    int c = (sourceChannels == 2) ? 4 : sourceChannels;  // Grey+alpha is expanded to RGBA
+
+    // Lay out every level up front
+    size_t total = 0;
+    int lw = w, lh = h, levels = 0;
+    for (;;) {
+        image.levelOffset[levels] = total;
+        image.levelSize[levels] = (size_t)lw * lh * c;
+        total += (image.levelSize[levels] + 15) & ~(size_t)15;  // 16-byte aligned levels
+        ++levels;
+        if ((lw == 1 && lh == 1) || levels == MAX_LEVELS) break;
+        lw = lw > 1 ? lw / 2 : 1;
+        lh = lh > 1 ? lh / 2 : 1;
+    }
+    image.width = w;
+    image.height = h;
+    image.channels = c;
+    image.levels = levels;
+    image.pixels.assign(total, 0);
+
+    // Level 0: copy rows bottom-up (same as SOIL_FLAG_INVERT_Y)
+    unsigned char* base = image.pixels.data();
+    for (int y = 0; y < h; ++y) {
+        unsigned char* dst = base + (size_t)(h - 1 - y) * w * c;
+        const unsigned char* src = data + (size_t)y * w * sourceChannels;
+        if (sourceChannels == c) {
+            memcpy(dst, src, (size_t)w * c);
+            continue;
+        }
+        for (int x = 0; x < w; ++x) {
+            dst[x * 4 + 0] = dst[x * 4 + 1] = dst[x * 4 + 2] = src[x * 2];
+            dst[x * 4 + 3] = src[x * 2 + 1];
+        }
+    }
+    SOIL_free_image_data(data);
+
+    // Remaining levels from the one above
+    lw = w; lh = h;
+    for (int level = 1; level < levels; ++level) {
+        int nw = lw > 1 ? lw / 2 : 1, nh = lh > 1 ? lh / 2 : 1;
+        const unsigned char* src = base + image.levelOffset[level - 1];
+        unsigned char* dst = base + image.levelOffset[level];
+        for (int y = 0; y < nh; ++y) {
+            int y0 = y * 2, y1 = (y * 2 + 1 < lh) ? y * 2 + 1 : y * 2;
+            for (int x = 0; x < nw; ++x) {
+                int x0 = x * 2, x1 = (x * 2 + 1 < lw) ? x * 2 + 1 : x * 2;
+                for (int k = 0; k < c; ++k) {
+                    int sum = src[((size_t)y0 * lw + x0) * c + k] + src[((size_t)y0 * lw + x1) * c + k] +
+                              src[((size_t)y1 * lw + x0) * c + k] + src[((size_t)y1 * lw + x1) * c + k];
+                    dst[((size_t)y * nw + x) * c + k] = (unsigned char)((sum + 2) / 4);
+                }
+            }
+        }
+        lw = nw; lh = nh;
+    }
+    return true;
+}
+
+// Upload one mip chain into a new texture with the usual filtering
+static GLuint uploadLevels(int width, int height, int channels, int levels, const unsigned char* const* data) {
+    GLuint tex;
+    glGenTextures(1, &tex);
+    glBindTexture(GL_TEXTURE_2D, tex);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    GLenum format = (channels == 4) ? GL_RGBA : (channels == 3) ? GL_RGB : GL_LUMINANCE;
+    int lw = width, lh = height;
+    for (int level = 0; level < levels; ++level) {
+        glTexImage2D(GL_TEXTURE_2D, level, format, lw, lh, 0, format, GL_UNSIGNED_BYTE, data[level]);
+        lw = lw > 1 ? lw / 2 : 1;
+        lh = lh > 1 ? lh / 2 : 1;
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR); // Minification filter
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);               // Magnification filter
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);            // S-coordinate wrapping
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);            // T-coordinate wrapping
+    return tex;
+}
+
+// Try to serve every file from the cache; false means it is missing or stale
+static bool loadFromCache(const char* const* files, int count, GLuint* textures, const char* cachePath,
+                          TextureLoadStats& stats) {
+    auto start = std::chrono::steady_clock::now();
+    MappedFile cache;
+    if (!mapFile(cachePath, cache)) return false;
+
+    // Validate the header and every entry against the source files
+    const CacheHeader* header = (const CacheHeader*)cache.data;
+    bool valid = cache.size >= sizeof(CacheHeader) + count * sizeof(CacheEntry) &&
+        memcmp(header->magic, CACHE_MAGIC, 4) == 0 && header->version == CACHE_VERSION &&
+        header->count == (uint32_t)count;
+    const CacheEntry* entries = (const CacheEntry*)(cache.data + sizeof(CacheHeader));
+    for (int i = 0; valid && i < count; ++i) {
+        uint64_t size;
+        int64_t time;
+        const CacheEntry& e = entries[i];
+        valid = memchr(e.name, 0, NAME_LENGTH) && strcmp(e.name, files[i]) == 0 && sourceStamp(files[i], size, time) &&
+            e.sourceSize == size && e.sourceTime == time && e.levels > 0 && e.levels <= (uint32_t)MAX_LEVELS &&
+            e.width > 0 && e.height > 0 && e.width <= MAX_SIZE && e.height <= MAX_SIZE &&
+            (e.channels == 1 || e.channels == 3 || e.channels == 4);
+        // Every level must hold exactly the pixels glTexImage2D will read from it
+        uint64_t lw = e.width, lh = e.height;
+        for (uint32_t l = 0; valid && l < e.levels; ++l) {
+            valid = e.levelSize[l] == lw * lh * e.channels && e.levelOffset[l] <= cache.size &&
+                e.levelSize[l] <= cache.size - e.levelOffset[l];
+            lw = lw > 1 ? lw / 2 : 1;
+            lh = lh > 1 ? lh / 2 : 1;
+        }
+    }
+    if (!valid) {
+        unmapFile(cache);
+        return false;
+    }
+    stats.decodeMs = msSince(start);
+
+    // Upload straight from the mapping; no decoding or copying on our side
+    auto uploadStart = std::chrono::steady_clock::now();
+    for (int i = 0; i < count; ++i) {
+        const CacheEntry& e = entries[i];
+        const unsigned char* levels[MAX_LEVELS];
+        for (uint32_t l = 0; l < e.levels; ++l)
+            levels[l] = cache.data + e.levelOffset[l];
+        textures[i] = uploadLevels(e.width, e.height, e.channels, e.levels, levels);
+    }
+    stats.uploadMs = msSince(uploadStart);
+    unmapFile(cache);
+    stats.warm = true;
+    return true;
+}
+
+// Write all decoded images to the cache file
+static void writeCache(const char* const* files, int count, const std::vector<DecodedImage>& images,
+                       const char* cachePath) {
+    // A name cut short would never match again, so such a set isn't cached at all
+    for (int i = 0; i < count; ++i)
+        if (strlen(files[i]) >= (size_t)NAME_LENGTH) return;
+    FILE* out = fopen(cachePath, "wb");
+    if (!out) return;  // Cache is optional
+
+    CacheHeader header;
+    memcpy(header.magic, CACHE_MAGIC, 4);
+    header.version = CACHE_VERSION;
+    header.count = count;
+    header.reserved = 0;
+
+    std::vector<CacheEntry> entries(count);
+    uint64_t offset = sizeof(CacheHeader) + count * sizeof(CacheEntry);
+    for (int i = 0; i < count; ++i) {
+        CacheEntry& e = entries[i];
+        memset(&e, 0, sizeof(e));
+        memcpy(e.name, files[i], strlen(files[i]) + 1);
+        sourceStamp(files[i], e.sourceSize, e.sourceTime);
+        e.width = images[i].width;
+        e.height = images[i].height;
+        e.channels = images[i].channels;
+        e.levels = images[i].levels;
+        for (int l = 0; l < images[i].levels; ++l) {
+            e.levelOffset[l] = offset + images[i].levelOffset[l];
+            e.levelSize[l] = images[i].levelSize[l];
+        }
+        offset += images[i].pixels.size();
+    }
+
+    bool ok = fwrite(&header, sizeof(header), 1, out) == 1 &&
+        fwrite(entries.data(), sizeof(CacheEntry), count, out) == (size_t)count;
+    for (int i = 0; ok && i < count; ++i)
+        ok = fwrite(images[i].pixels.data(), 1, images[i].pixels.size(), out) == images[i].pixels.size();
+    fclose(out);
+    if (!ok) remove(cachePath);  // Never leave a truncated cache behind
+}
+
+int loadTextureSet(const char* const* files, int count, GLuint* textures, const char* cachePath,
+                   TaskScheduler* scheduler, TextureLoadStats* stats) {
+    auto start = std::chrono::steady_clock::now();
+    TextureLoadStats local = { false, 0.0, 0.0, 0.0 };
+
+    if (cachePath && loadFromCache(files, count, textures, cachePath, local)) {
+        local.totalMs = msSince(start);
+        if (stats) *stats = local;
+        return -1;
+    }
+
+    // Cold start: decode and build mip chains for all files in parallel
+    std::vector<DecodedImage> images(count);
+    std::vector<char> decoded(count, 0);
+    parallelFor(scheduler, 0, count, 1, [&](int begin, int end) {
+        for (int i = begin; i < end; ++i)
+            decoded[i] = decodeImage(files[i], images[i]);
+    });
+    local.decodeMs = msSince(start);
+    for (int i = 0; i < count; ++i)
+        if (!decoded[i]) return i;
+
+    // Uploads must happen on the GL thread
+    auto uploadStart = std::chrono::steady_clock::now();
+    for (int i = 0; i < count; ++i) {
+        const DecodedImage& img = images[i];
+        const unsigned char* levels[MAX_LEVELS];
+        for (int l = 0; l < img.levels; ++l)
+            levels[l] = img.pixels.data() + img.levelOffset[l];
+        textures[i] = uploadLevels(img.width, img.height, img.channels, img.levels, levels);
+    }
+    local.uploadMs = msSince(uploadStart);
+
+    if (cachePath) writeCache(files, count, images, cachePath);
+    local.totalMs = msSince(start);
+    if (stats) *stats = local;
+    return -1;
+}
@@ -0,0 +1,20 @@
+// Parallel texture decoding with a memory-mapped cache of prebuilt mip chains
+#pragma once
+
+#include "GLExtensions.h"     // GL types
+#include "TaskScheduler.h"    // Worker threads for decoding
+
+// Timings of one loadTextureSet() call
+struct TextureLoadStats {
+    bool warm;          // True when every texture came from the cache
+    double decodeMs;    // Decoding images and building mip chains (or mapping the cache)
+    double uploadMs;    // Handing the levels to OpenGL
+    double totalMs;     // Whole call, including writing a fresh cache
+};
+
+// Load count image files into textures[] with full mip chains, flipped vertically.
+// A valid cache file is memory-mapped and uploaded directly; otherwise the images
+// are decoded in parallel and the cache is rewritten. Returns the index of the
+// first file that failed to decode, or -1 on success.
+int loadTextureSet(const char* const* files, int count, GLuint* textures, const char* cachePath,
+                   TaskScheduler* scheduler, TextureLoadStats* stats);
@@ -0,0 +1,782 @@
+// Virtual textures: tiled files, a shared tile atlas with LRU replacement, per-texture page
+// tables and background tile decoders
+#include "VirtualTexture.h"
+#include "MappedFile.h"       // Tiles are read straight from a mapping
+#include <SOIL.h>             // Source image decoding for buildVirtualTexture
+#include <math.h>             // sin, cos, acos
+#include <stdio.h>            // File writing, messages
+#include <string.h>           // memcpy, memcmp
+#include <stdint.h>           // Fixed-size file fields
+#include <algorithm>          // sort, min, max
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Define GL_CLAMP_TO_EDGE if not already defined by the system
+#ifndef GL_CLAMP_TO_EDGE
+#define GL_CLAMP_TO_EDGE 0x812F
+#endif
+#ifndef GL_RGBA8
+#define GL_RGBA8 0x8058
+#endif
+
+static const double VT_PI = 3.141592653589793;
+static const char VTEX_MAGIC[4] = { 'S', 'V', 'T', 'X' };
+static const uint32_t VTEX_VERSION = 1;
+static const int MAX_LEVELS = 20;          // Matches levelColumn[] in the fragment shader
+static const int PAGE_SIZE = 128;          // Atlas slot size in texels, border included
+static const int BORDER = 4;               // Texels copied from each neighbour around a tile
+static const int TILE_SIZE = PAGE_SIZE - 2 * BORDER;
+static const size_t DATA_ALIGNMENT = 4096; // Tiles start on a page boundary of the file
+static const int MAX_UPLOADS_PER_FRAME = 16;  // About 1 MB of texture updates
+static const int MAX_QUEUED_TILES = 64;    // Decoder backlog; the rest are asked for again next frame
+static const double REFINE_PIXELS = 1.0;   // Use a finer level while a texel covers more pixels than this
+static const unsigned long long EMPTY_SLOT = ~0ull;
+
+// File layout: this header, padding up to dataOffset, then every tile of level 0 row by row,
+// then level 1 and so on. Tiles are PAGE_SIZE squares of raw pixels, rows bottom-up like GL.
+struct VtexLevel {
+    uint32_t width, height;      // Texels in this level
+    uint32_t tilesX, tilesY;
+    uint64_t firstTile;          // Tiles before this level
+};
+struct VtexHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t width, height;      // Level 0 size
+    uint32_t tileSize, border;   // Tile content and the border around it
+    uint32_t channels;           // 3 (RGB) or 4 (RGBA)
+    uint32_t levels;             // The last one fits in one tile
+    uint64_t dataOffset;         // First tile, from the start of the file
+    VtexLevel level[MAX_LEVELS];
+};
+
+// One open tiled file and its page table: per tile of every level, the atlas slot holding the
+// finest resident tile that covers it, as RGBA (slot x, slot y, its level, 255). Levels sit side by
+// side, level 0 first.
+struct VirtualTexture {
+    MappedFile file;
+    const VtexHeader* header;
+    size_t tileBytes;
+    float columns[MAX_LEVELS];        // First page-table column of each level
+    GLuint pageTexture;
+    int pageWidth, pageHeight;
+    std::vector<GLubyte> pageTable;
+    int dirtyX0, dirtyY0, dirtyX1, dirtyY1;  // Page-table texels changed since the last upload (x0 > x1 when clean)
+};
+
+// Atlas slot; unpinned slots form a list from least to most recently used
+struct TileSlot {
+    unsigned long long key;      // Tile held (EMPTY_SLOT when free)
+    int prev, next;              // LRU neighbours (-1 at the ends)
+    long long lastUsed;          // Frame the tile was last wanted
+    bool pinned;                 // Coarsest tiles never leave
+};
+
+// A tile the current frame wants
+struct TileRequest {
+    unsigned long long key;
+    float pixels;                // Screen pixels per texel: how blurry it is while missing
+};
+
+// A tile read and expanded by a decoder, waiting for upload
+struct DecodedTile {
+    unsigned long long key;
+    std::vector<GLubyte> pixels;  // PAGE_SIZE x PAGE_SIZE RGBA
+};
+
+static std::vector<VirtualTexture*> virtualTextures;  // Never moved once opened: decoders read them
+static GLuint atlasTexture = 0;
+static GLuint program = 0;
+static GLint surfaceLocation = -1, pagesLocation = -1, columnsLocation = -1;
+static int atlasSlots = 0;                 // Slots per side
+static std::vector<TileSlot> slots;
+static int lruFirst = -1, lruLast = -1;
+static int pinnedSlots = 0;
+static std::unordered_map<unsigned long long, int> residentTiles;  // Tile key -> slot
+static std::vector<TileRequest> requests;  // Since the last update
+static long long frameNumber = 0;
+static VirtualTextureStats counters = {};
+
+// Decoders take keys from the queue and return pixels; the render thread owns everything else
+static std::vector<std::thread> decoders;
+static std::mutex decodeLock;
+static std::condition_variable decodeWork;  // Queue filled, or stopping
+static std::condition_variable decodeDone;  // A tile finished
+static std::deque<unsigned long long> decodeQueue;  // Most urgent first
+static std::vector<DecodedTile> decodedTiles;
+static bool decodersStopping = false;
+static std::unordered_set<unsigned long long> inFlight;  // Queued, decoding, or decoded and not yet uploaded
+static std::atomic<long long> bytesRead(0);
+
+// Sample the atlas through the page table with trilinear filtering between levels. The page table
+// gives, for the tile under uv at a level, the slot and level of the finest resident tile covering
+// it; a missing tile is drawn from that coarser one.
+static const char* vertexShader =
+    "#version 110\n"
+    "varying vec2 uv;\n"
+    "void main() {\n"
+    "    vec4 eye = gl_ModelViewMatrix * gl_Vertex;\n"
+    "    vec3 n = normalize(gl_NormalMatrix * gl_Normal);\n"
+    "    vec3 toLight = normalize(gl_LightSource[0].position.xyz - eye.xyz);\n"
+    "    float diffuse = max(dot(n, toLight), 0.0);\n"
+    "    float specular = diffuse > 0.0 ?\n"
+    "        pow(max(dot(n, normalize(toLight + vec3(0.0, 0.0, 1.0))), 0.0), gl_FrontMaterial.shininess) : 0.0;\n"
+    "    vec3 ambient = gl_LightModel.ambient.rgb + gl_LightSource[0].ambient.rgb;\n"
+    "    vec3 color = gl_FrontMaterial.emission.rgb + gl_Color.rgb * (ambient + gl_LightSource[0].diffuse.rgb * diffuse) +\n"
+    "                 gl_FrontMaterial.specular.rgb * gl_LightSource[0].specular.rgb * specular;\n"
+    "    gl_FrontColor = vec4(min(color, 1.0), gl_Color.a);\n"
+    "    uv = (gl_TextureMatrix[0] * gl_MultiTexCoord0).st;\n"
+    "    gl_Position = gl_ProjectionMatrix * eye;\n"
+    "}\n";
+
+static const char* fragmentShader =
+    "#version 110\n"
+    "uniform sampler2D atlas;\n"
+    "uniform sampler2D pageTable;\n"
+    "uniform vec4 surface;           // width, height, tile size, coarsest level\n"
+    "uniform vec4 pages;             // page table width and height, atlas slots per side, border\n"
+    "uniform float levelColumn[20];  // First page-table column of each level\n"
+    "varying vec2 uv;\n"
+    "vec2 levelSize(float level) {\n"
+    "    return max(floor(surface.xy / exp2(level)), 1.0);\n"
+    "}\n"
+    "vec4 sampleLevel(float level) {\n"
+    "    vec2 size = levelSize(level);\n"
+    "    vec2 tile = min(floor(uv * size / surface.z), ceil(size / surface.z) - 1.0);\n"
+    "    vec2 entryAt = (vec2(levelColumn[int(level)] + tile.x, tile.y) + 0.5) / pages.xy;\n"
+    "    vec4 entry = floor(texture2D(pageTable, entryAt) * 255.0 + 0.5);\n"
+    "    vec2 residentSize = levelSize(entry.z);\n"
+    "    vec2 residentTile = min(floor(tile / exp2(entry.z - level)), ceil(residentSize / surface.z) - 1.0);\n"
+    "    vec2 inTile = clamp(uv * residentSize - residentTile * surface.z, 0.5 - pages.w, surface.z + pages.w - 0.5);\n"
+    "    float page = surface.z + 2.0 * pages.w;\n"
+    "    return texture2D(atlas, (entry.xy * page + pages.w + inTile) / (pages.z * page));\n"
+    "}\n"
+    "void main() {\n"
+    "    vec2 texel = uv * surface.xy;\n"
+    "    vec2 dx = dFdx(texel), dy = dFdy(texel);\n"
+    "    float lambda = clamp(0.5 * log2(max(dot(dx, dx), dot(dy, dy))), 0.0, surface.w);\n"
+    "    float level = floor(lambda);\n"
+    "    vec4 color = mix(sampleLevel(level), sampleLevel(min(level + 1.0, surface.w)), lambda - level);\n"
+    "    gl_FragColor = color * gl_Color;\n"
+    "}\n";
+
+// Tile keys pack the texture, level and tile position
+static unsigned long long tileKey(int texture, int level, int x, int y) {
+    return ((unsigned long long)texture << 50) | ((unsigned long long)level << 44) |
+           ((unsigned long long)y << 22) | (unsigned long long)x;
+}
+static int keyTexture(unsigned long long key) { return (int)(key >> 50); }
+static int keyLevel(unsigned long long key) { return (int)((key >> 44) & 0x3F); }
+static int keyY(unsigned long long key) { return (int)((key >> 22) & 0x3FFFFF); }
+static int keyX(unsigned long long key) { return (int)(key & 0x3FFFFF); }
+
+// Copy one tile out of the mapping as RGBA (runs on the decoders)
+static void readTile(unsigned long long key, std::vector<GLubyte>& pixels) {
+    const VirtualTexture& vt = *virtualTextures[keyTexture(key)];
+    const VtexLevel& level = vt.header->level[keyLevel(key)];
+    const size_t index = level.firstTile + (size_t)keyY(key) * level.tilesX + keyX(key);
+    const GLubyte* src = vt.file.data + vt.header->dataOffset + index * vt.tileBytes;
+    pixels.resize((size_t)PAGE_SIZE * PAGE_SIZE * 4);
+    if (vt.header->channels == 4) {
+        memcpy(pixels.data(), src, pixels.size());
+    }
+    else {
+        for (int i = 0; i < PAGE_SIZE * PAGE_SIZE; ++i) {
+            pixels[i * 4 + 0] = src[i * 3 + 0];
+            pixels[i * 4 + 1] = src[i * 3 + 1];
+            pixels[i * 4 + 2] = src[i * 3 + 2];
+            pixels[i * 4 + 3] = 255;
+        }
+    }
+    bytesRead += (long long)vt.tileBytes;
+}
+
+static void decoderLoop() {
+    for (;;) {
+        DecodedTile tile;
+        {
+            std::unique_lock<std::mutex> guard(decodeLock);
+            decodeWork.wait(guard, [] { return decodersStopping || !decodeQueue.empty(); });
+            if (decodersStopping) return;
+            tile.key = decodeQueue.front();
+            decodeQueue.pop_front();
+        }
+        readTile(tile.key, tile.pixels);  // Page faults on the mapping happen here, off the render thread
+        {
+            std::lock_guard<std::mutex> guard(decodeLock);
+            decodedTiles.push_back(std::move(tile));
+        }
+        decodeDone.notify_all();
+    }
+}
+
+// Point of the unit sphere at texture coordinates (s, t), as the sphere mesh maps them
+static void spherePoint(double s, double t, double p[3]) {
+    double theta = 2.0 * VT_PI * s, rho = VT_PI * (1.0 - t);
+    p[0] = -sin(theta) * sin(rho);
+    p[1] = cos(theta) * sin(rho);
+    p[2] = cos(rho);
+}
+
+static GLubyte* pageEntry(VirtualTexture& vt, int level, int x, int y) {
+    return &vt.pageTable[((size_t)y * vt.pageWidth + (size_t)vt.columns[level] + x) * 4];
+}
+
+static void markDirty(VirtualTexture& vt, int x0, int y0, int x1, int y1) {
+    vt.dirtyX0 = std::min(vt.dirtyX0, x0);
+    vt.dirtyY0 = std::min(vt.dirtyY0, y0);
+    vt.dirtyX1 = std::max(vt.dirtyX1, x1);
+    vt.dirtyY1 = std::max(vt.dirtyY1, y1);
+}
+
+// Parent of a tile; the last row and column of a level can have more than two children
+static int parentTile(int tile, int parentTiles) {
+    return std::min(tile >> 1, parentTiles - 1);
+}
+
+// A tile arrived in a slot or left it (slot -1): rewrite its entry, then every entry below it
+// that has no resident tile of its own, coarse to fine, from its parent
+static void refreshPageTable(unsigned long long key, int slot) {
+    VirtualTexture& vt = *virtualTextures[keyTexture(key)];
+    const VtexHeader& h = *vt.header;
+    const int level = keyLevel(key), x = keyX(key), y = keyY(key);
+    GLubyte* entry = pageEntry(vt, level, x, y);
+    if (slot >= 0) {
+        entry[0] = (GLubyte)(slot % atlasSlots);
+        entry[1] = (GLubyte)(slot / atlasSlots);
+        entry[2] = (GLubyte)level;
+        entry[3] = 255;
+    }
+    else {
+        const VtexLevel& up = h.level[level + 1];  // The coarsest level is pinned, so this exists
+        memcpy(entry, pageEntry(vt, level + 1, parentTile(x, up.tilesX), parentTile(y, up.tilesY)), 4);
+    }
+    markDirty(vt, (int)vt.columns[level] + x, y, (int)vt.columns[level] + x, y);
+
+    const bool lastX = x == (int)h.level[level].tilesX - 1, lastY = y == (int)h.level[level].tilesY - 1;
+    for (int l = level - 1; l >= 0; --l) {
+        const int d = level - l;
+        const VtexLevel& lv = h.level[l];
+        const VtexLevel& up = h.level[l + 1];
+        int x0 = x << d, y0 = y << d;
+        int x1 = lastX ? (int)lv.tilesX - 1 : std::min(((x + 1) << d) - 1, (int)lv.tilesX - 1);
+        int y1 = lastY ? (int)lv.tilesY - 1 : std::min(((y + 1) << d) - 1, (int)lv.tilesY - 1);
+        for (int ty = y0; ty <= y1; ++ty) {
+            for (int tx = x0; tx <= x1; ++tx) {
+                GLubyte* child = pageEntry(vt, l, tx, ty);
+                // Resident itself (the level byte can't tell: zeroed entries also read level 0)
+                if (residentTiles.count(tileKey(keyTexture(key), l, tx, ty))) continue;
+                memcpy(child, pageEntry(vt, l + 1, parentTile(tx, up.tilesX), parentTile(ty, up.tilesY)), 4);
+            }
+        }
+        markDirty(vt, (int)vt.columns[l] + x0, y0, (int)vt.columns[l] + x1, y1);
+    }
+}
+
+// LRU list maintenance
+static void unlinkSlot(int s) {
+    TileSlot& slot = slots[s];
+    if (slot.prev >= 0) slots[slot.prev].next = slot.next;
+    else lruFirst = slot.next;
+    if (slot.next >= 0) slots[slot.next].prev = slot.prev;
+    else lruLast = slot.prev;
+    slot.prev = slot.next = -1;
+}
+static void appendSlot(int s) {
+    slots[s].prev = lruLast;
+    slots[s].next = -1;
+    if (lruLast >= 0) slots[lruLast].next = s;
+    else lruFirst = s;
+    lruLast = s;
+}
+static void touchSlot(int s, bool wanted = true) {
+    slots[s].lastUsed = wanted ? frameNumber : frameNumber - 1;  // Tiles nobody wants now may be evicted
+    if (slots[s].pinned || s == lruLast) return;
+    unlinkSlot(s);
+    appendSlot(s);
+}
+
+// Put a decoded tile into the least recently used slot. False when every slot is wanted this frame.
+static bool placeTile(unsigned long long key, const GLubyte* pixels, bool pin, bool wanted) {
+    int s = lruFirst;
+    if (s < 0 || (slots[s].key != EMPTY_SLOT && slots[s].lastUsed == frameNumber)) return false;
+    if (slots[s].key != EMPTY_SLOT) {
+        residentTiles.erase(slots[s].key);
+        refreshPageTable(slots[s].key, -1);
+        counters.evictions++;
+    }
+    glActiveTexture(GL_TEXTURE0 + 1);
+    glBindTexture(GL_TEXTURE_2D, atlasTexture);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, (s % atlasSlots) * PAGE_SIZE, (s / atlasSlots) * PAGE_SIZE,
+                    PAGE_SIZE, PAGE_SIZE, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    glActiveTexture(GL_TEXTURE0);
+
+    slots[s].key = key;
+    residentTiles[key] = s;
+    refreshPageTable(key, s);
+    if (pin) {
+        unlinkSlot(s);
+        slots[s].pinned = true;
+        pinnedSlots++;
+    }
+    touchSlot(s, wanted);
+    return true;
+}
+
+// Cut an image level into tiles, each with a border from its neighbours: wrapped around the
+// longitude seam, clamped at the poles
+static void writeLevelTiles(const std::vector<unsigned char>& pixels, int w, int h, int tilesX, int tilesY,
+                            std::vector<unsigned char>& page, FILE* out, bool& ok) {
+    for (int ty = 0; ok && ty < tilesY; ++ty) {
+        for (int tx = 0; ok && tx < tilesX; ++tx) {
+            for (int j = 0; j < PAGE_SIZE; ++j) {
+                int y = std::min(std::max(ty * TILE_SIZE + j - BORDER, 0), h - 1);
+                for (int i = 0; i < PAGE_SIZE; ++i) {
+                    int x = ((tx * TILE_SIZE + i - BORDER) % w + w) % w;
+                    memcpy(&page[((size_t)j * PAGE_SIZE + i) * 3], &pixels[((size_t)y * w + x) * 3], 3);
+                }
+            }
+            ok = fwrite(page.data(), 1, page.size(), out) == page.size();
+        }
+    }
+}
+
+bool buildVirtualTexture(const char* imagePath, const char* outputPath) {
+    int w, h, sourceChannels;
+    unsigned char* data = SOIL_load_image(imagePath, &w, &h, &sourceChannels, SOIL_LOAD_RGB);
+    if (!data) {
+        printf("%s: %s\n", imagePath, SOIL_last_result());
+        return false;
+    }
+    // Rows bottom-up, as the textures are uploaded
+    std::vector<unsigned char> pixels((size_t)w * h * 3);
+    for (int y = 0; y < h; ++y)
+        memcpy(&pixels[(size_t)(h - 1 - y) * w * 3], data + (size_t)y * w * 3, (size_t)w * 3);
+    SOIL_free_image_data(data);
+
+    // Halve until a level fits in one tile
+    VtexHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, VTEX_MAGIC, 4);
+    header.version = VTEX_VERSION;
+    header.width = w;
+    header.height = h;
+    header.tileSize = TILE_SIZE;
+    header.border = BORDER;
+    header.channels = 3;
+    uint64_t tiles = 0;
+    for (int lw = w, lh = h;; lw = std::max(lw / 2, 1), lh = std::max(lh / 2, 1)) {
+        if (header.levels == (uint32_t)MAX_LEVELS) {
+            printf("%s: too large for a virtual texture\n", imagePath);
+            return false;
+        }
+        VtexLevel& level = header.level[header.levels++];
+        level.width = lw;
+        level.height = lh;
+        level.tilesX = (lw + TILE_SIZE - 1) / TILE_SIZE;
+        level.tilesY = (lh + TILE_SIZE - 1) / TILE_SIZE;
+        level.firstTile = tiles;
+        tiles += (uint64_t)level.tilesX * level.tilesY;
+        if (level.tilesX == 1 && level.tilesY == 1) break;
+    }
+    header.dataOffset = (sizeof(header) + DATA_ALIGNMENT - 1) / DATA_ALIGNMENT * DATA_ALIGNMENT;
+
+    FILE* out = fopen(outputPath, "wb");
+    if (!out) {
+        printf("Could not write %s\n", outputPath);
+        return false;
+    }
+    std::vector<unsigned char> padding(header.dataOffset - sizeof(header), 0);
+    bool ok = fwrite(&header, sizeof(header), 1, out) == 1 &&
+        fwrite(padding.data(), 1, padding.size(), out) == padding.size();
+
+    // Write each level's tiles, then box-filter it into the next
+    std::vector<unsigned char> page((size_t)PAGE_SIZE * PAGE_SIZE * 3), next;
+    for (uint32_t l = 0; ok && l < header.levels; ++l) {
+        const VtexLevel& level = header.level[l];
+        const int lw = level.width, lh = level.height;
+        writeLevelTiles(pixels, lw, lh, level.tilesX, level.tilesY, page, out, ok);
+        if (l + 1 == header.levels) break;
+        const int nw = header.level[l + 1].width, nh = header.level[l + 1].height;
+        next.resize((size_t)nw * nh * 3);
+        for (int y = 0; y < nh; ++y) {
+            int y0 = std::min(y * 2, lh - 1), y1 = std::min(y * 2 + 1, lh - 1);
+            for (int x = 0; x < nw; ++x) {
+                int x0 = std::min(x * 2, lw - 1), x1 = std::min(x * 2 + 1, lw - 1);
+                for (int k = 0; k < 3; ++k) {
+                    int sum = pixels[((size_t)y0 * lw + x0) * 3 + k] + pixels[((size_t)y0 * lw + x1) * 3 + k] +
+                              pixels[((size_t)y1 * lw + x0) * 3 + k] + pixels[((size_t)y1 * lw + x1) * 3 + k];
+                    next[((size_t)y * nw + x) * 3 + k] = (unsigned char)((sum + 2) / 4);
+                }
+            }
+        }
+        pixels.swap(next);
+    }
+    ok = fclose(out) == 0 && ok;
+    if (!ok) {
+        remove(outputPath);  // Never leave a truncated file behind
+        printf("Could not write %s\n", outputPath);
+        return false;
+    }
+    printf("Wrote %s: %dx%d, %u levels, %llu tiles of %d texels (%.1f MB)\n", outputPath, w, h, header.levels,
+           (unsigned long long)tiles, TILE_SIZE, (header.dataOffset + tiles * page.size()) / (1024.0 * 1024.0));
+    return true;
+}
+
+bool initVirtualTextures(long long budgetBytes, int decoderThreads) {
+    if (program) return true;
+    if (!hasShaders || !glActiveTexture || !glUniform4f || !glUniform1fv) return false;
+    program = buildProgram(vertexShader, fragmentShader);
+    if (!program) return false;
+    surfaceLocation = glGetUniformLocation(program, "surface");
+    pagesLocation = glGetUniformLocation(program, "pages");
+    columnsLocation = glGetUniformLocation(program, "levelColumn");
+    glUseProgram(program);
+    glUniform1i(glGetUniformLocation(program, "atlas"), 1);
+    glUniform1i(glGetUniformLocation(program, "pageTable"), 2);
+    glUseProgram(0);
+
+    // A square atlas of whole slots within the budget and the largest texture size
+    GLint maxSize = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+    const long long slotBytes = (long long)PAGE_SIZE * PAGE_SIZE * 4;
+    atlasSlots = (int)sqrt((double)(budgetBytes / slotBytes));
+    atlasSlots = std::max(2, std::min(atlasSlots, std::min(256, (int)maxSize / PAGE_SIZE)));
+    glGenTextures(1, &atlasTexture);
+    glActiveTexture(GL_TEXTURE0 + 1);
+    glBindTexture(GL_TEXTURE_2D, atlasTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, atlasSlots * PAGE_SIZE, atlasSlots * PAGE_SIZE, 0,
+                 GL_RGBA, GL_UNSIGNED_BYTE, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);  // Levels come from the page table
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glActiveTexture(GL_TEXTURE0);
+
+    // Every slot starts free at the front of the LRU list
+    slots.assign(atlasSlots * atlasSlots, TileSlot());
+    lruFirst = lruLast = -1;
+    for (int s = 0; s < (int)slots.size(); ++s) {
+        slots[s].key = EMPTY_SLOT;
+        slots[s].lastUsed = -1;
+        slots[s].pinned = false;
+        appendSlot(s);
+    }
+    counters = VirtualTextureStats();
+    counters.slots = (int)slots.size();
+    counters.atlasBytes = (long long)slots.size() * slotBytes;
+
+    decodersStopping = false;
+    for (int i = 0; i < std::max(decoderThreads, 1); ++i)
+        decoders.push_back(std::thread(decoderLoop));
+    return true;
+}
+
+int openVirtualTexture(const char* path) {
+    if (!program) return -1;
+    VirtualTexture* vt = new VirtualTexture();
+    if (!mapFile(path, vt->file)) {
+        delete vt;
+        return -1;
+    }
+
+    // Check the header and that every tile lies inside the file
+    const VtexHeader* h = (const VtexHeader*)vt->file.data;
+    bool valid = vt->file.size >= sizeof(VtexHeader) && memcmp(h->magic, VTEX_MAGIC, 4) == 0 &&
+        h->version == VTEX_VERSION && h->tileSize + 2 * h->border == (uint32_t)PAGE_SIZE &&
+        (h->channels == 3 || h->channels == 4) && h->levels > 0 && h->levels <= (uint32_t)MAX_LEVELS;
+    GLint maxSize = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+    int pageWidth = 0;
+    if (valid) {
+        const VtexLevel& top = h->level[h->levels - 1];
+        uint64_t tiles = top.firstTile + 1;
+        vt->tileBytes = (size_t)PAGE_SIZE * PAGE_SIZE * h->channels;
+        valid = top.tilesX == 1 && top.tilesY == 1 && h->dataOffset + tiles * vt->tileBytes <= vt->file.size &&
+            h->level[0].tilesX < (1u << 22) && h->level[0].tilesY < (1u << 22) &&
+            (int)h->level[0].tilesY <= maxSize;
+        for (uint32_t l = 0; valid && l < h->levels; ++l) {
+            vt->columns[l] = (float)pageWidth;
+            pageWidth += h->level[l].tilesX;
+        }
+        valid = valid && pageWidth <= maxSize;
+    }
+    if (!valid || virtualTextures.size() >= 1u << 13) {
+        printf("%s: not a usable virtual texture\n", path);
+        unmapFile(vt->file);
+        delete vt;
+        return -1;
+    }
+    vt->header = h;
+    vt->pageWidth = pageWidth;
+    vt->pageHeight = h->level[0].tilesY;
+    vt->pageTable.assign((size_t)vt->pageWidth * vt->pageHeight * 4, 0);
+    vt->dirtyX0 = vt->dirtyY0 = 0;
+    vt->dirtyX1 = vt->dirtyY1 = -1;
+    glGenTextures(1, &vt->pageTexture);
+    glActiveTexture(GL_TEXTURE0 + 2);
+    glBindTexture(GL_TEXTURE_2D, vt->pageTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, vt->pageWidth, vt->pageHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+                 vt->pageTable.data());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);  // Entries are never blended
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glActiveTexture(GL_TEXTURE0);
+
+    // The coarsest tile backs every entry until finer ones arrive
+    const int id = (int)virtualTextures.size();
+    virtualTextures.push_back(vt);
+    std::vector<GLubyte> pixels;
+    const unsigned long long key = tileKey(id, h->levels - 1, 0, 0);
+    readTile(key, pixels);
+    if (!placeTile(key, pixels.data(), true, true)) {
+        printf("%s: the virtual texture budget is full\n", path);
+        return -1;  // Left open but unused; its id is never handed out
+    }
+    counters.textures++;
+    return id;
+}
+
+// Context of one texture's tile selection
+struct TileSelection {
+    int texture;
+    const VtexHeader* header;
+    const SurfaceView* view;
+    const Frustum* frustum;
+    double camera[3];    // Eye in the sphere's local frame
+    double distance;     // From the center
+    double horizon;      // Angle from the eye direction to the horizon (pi when inside the sphere)
+};
+
+// Request a tile if it can be seen, then its children while its texels are too big on screen
+static void selectTiles(const TileSelection& sel, int level, int x, int y) {
+    const VtexLevel& lv = sel.header->level[level];
+    const double r = sel.view->radius;
+    const double s0 = (double)x * TILE_SIZE / lv.width, s1 = std::min((double)(x + 1) * TILE_SIZE / lv.width, 1.0);
+    const double t0 = (double)y * TILE_SIZE / lv.height, t1 = std::min((double)(y + 1) * TILE_SIZE / lv.height, 1.0);
+
+    // Bounding cap of the patch: its center and the widest angle to its edges
+    double center[3], p[3];
+    spherePoint((s0 + s1) * 0.5, (t0 + t1) * 0.5, center);
+    double spread = 0.0;
+    for (int j = 0; j <= 2; ++j) {
+        for (int i = 0; i <= 2; ++i) {
+            spherePoint(s0 + (s1 - s0) * i * 0.5, t0 + (t1 - t0) * j * 0.5, p);
+            double c = center[0] * p[0] + center[1] * p[1] + center[2] * p[2];
+            spread = std::max(spread, acos(std::max(-1.0, std::min(c, 1.0))));
+        }
+    }
+    spread = std::min(spread * 1.15, VT_PI);  // Latitude edges bulge past the samples
+
+    // Behind the horizon?
+    double c = (center[0] * sel.camera[0] + center[1] * sel.camera[1] + center[2] * sel.camera[2]) / sel.distance;
+    if (acos(std::max(-1.0, std::min(c, 1.0))) - spread > sel.horizon) return;
+
+    // Outside the frustum?
+    double world[3];
+    for (int a = 0; a < 3; ++a)
+        world[a] = sel.view->center[a] + r * (center[0] * sel.view->axes[0][a] + center[1] * sel.view->axes[1][a] +
+                                               center[2] * sel.view->axes[2][a]);
+    double bound = spread >= VT_PI * 0.5 ? 2.0 * r : 2.0 * r * sin(spread * 0.5);
+    if (!sphereInFrustum(*sel.frustum, world[0], world[1], world[2], bound)) return;
+
+    // Texel size on screen at the nearest point of the patch
+    double dx = sel.camera[0] - r * center[0], dy = sel.camera[1] - r * center[1], dz = sel.camera[2] - r * center[2];
+    double nearest = std::max(sqrt(dx * dx + dy * dy + dz * dz) - bound, r * 1e-4);
+    double pixels = VT_PI * r / lv.height * sel.frustum->pixelsPerUnit / nearest;
+    TileRequest request = { tileKey(sel.texture, level, x, y), (float)pixels };
+    requests.push_back(request);
+    if (level == 0 || pixels <= REFINE_PIXELS) return;
+
+    const VtexLevel& down = sel.header->level[level - 1];
+    int x1 = x == (int)lv.tilesX - 1 ? (int)down.tilesX - 1 : std::min(x * 2 + 1, (int)down.tilesX - 1);
+    int y1 = y == (int)lv.tilesY - 1 ? (int)down.tilesY - 1 : std::min(y * 2 + 1, (int)down.tilesY - 1);
+    for (int cy = y * 2; cy <= y1; ++cy)
+        for (int cx = x * 2; cx <= x1; ++cx)
+            selectTiles(sel, level - 1, cx, cy);
+}
+
+void requestVirtualTexture(int id, const SurfaceView& view, const Frustum& frustum) {
+    if (id < 0 || id >= (int)virtualTextures.size()) return;
+    TileSelection sel;
+    sel.texture = id;
+    sel.header = virtualTextures[id]->header;
+    sel.view = &view;
+    sel.frustum = &frustum;
+    double rel[3] = { frustum.eye[0] - view.center[0], frustum.eye[1] - view.center[1], frustum.eye[2] - view.center[2] };
+    for (int a = 0; a < 3; ++a)
+        sel.camera[a] = rel[0] * view.axes[a][0] + rel[1] * view.axes[a][1] + rel[2] * view.axes[a][2];
+    sel.distance = std::max(sqrt(rel[0] * rel[0] + rel[1] * rel[1] + rel[2] * rel[2]), 1e-9);
+    sel.horizon = sel.distance > view.radius ? acos(view.radius / sel.distance) : VT_PI;
+    selectTiles(sel, sel.header->levels - 1, 0, 0);
+}
+
+static bool byKey(const TileRequest& a, const TileRequest& b) {
+    return a.key < b.key;
+}
+
+// Coarse tiles first (finer ones are useless without them), then the blurriest
+static bool moreUrgent(const TileRequest& a, const TileRequest& b) {
+    return keyLevel(a.key) != keyLevel(b.key) ? keyLevel(a.key) > keyLevel(b.key) : a.pixels > b.pixels;
+}
+
+// Upload decoded tiles (all of them when complete, else up to the per-frame cap).
+// False when a tile found no free slot.
+static bool uploadDecodedTiles(bool complete) {
+    std::vector<DecodedTile> ready;
+    {
+        std::lock_guard<std::mutex> guard(decodeLock);
+        ready.swap(decodedTiles);
+    }
+    size_t used = 0;
+    bool placed = true;
+    for (; used < ready.size() && placed && (complete || counters.uploads < MAX_UPLOADS_PER_FRAME); ++used) {
+        unsigned long long key = ready[used].key;
+        inFlight.erase(key);
+        if (residentTiles.count(key)) continue;
+        bool wanted = std::binary_search(requests.begin(), requests.end(), TileRequest{ key, 0.0f }, byKey);
+        placed = placeTile(key, ready[used].pixels.data(), false, wanted);
+        if (placed) counters.uploads++;
+    }
+    if (used < ready.size()) {
+        // Over the cap: keep the rest for the next frame
+        std::lock_guard<std::mutex> guard(decodeLock);
+        for (size_t i = used; i < ready.size(); ++i) {
+            if (!placed) inFlight.erase(ready[i].key);  // No room this frame; asked for again later
+            else decodedTiles.push_back(std::move(ready[i]));
+        }
+    }
+    return placed;
+}
+
+// Replace the decoders' backlog with this frame's missing tiles, most urgent first.
+// Returns how many wanted tiles are still missing.
+static int queueMissingTiles() {
+    std::vector<TileRequest> missing;
+    for (const TileRequest& request : requests)
+        if (!residentTiles.count(request.key)) missing.push_back(request);
+    std::sort(missing.begin(), missing.end(), moreUrgent);
+    {
+        std::lock_guard<std::mutex> guard(decodeLock);
+        for (unsigned long long key : decodeQueue) inFlight.erase(key);
+        decodeQueue.clear();
+        for (const TileRequest& request : missing) {
+            if ((int)decodeQueue.size() == MAX_QUEUED_TILES) break;
+            if (inFlight.insert(request.key).second) decodeQueue.push_back(request.key);
+        }
+    }
+    decodeWork.notify_all();
+    return (int)missing.size();
+}
+
+// Send the changed part of every page table
+static void flushPageTables() {
+    glActiveTexture(GL_TEXTURE0 + 2);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (VirtualTexture* vt : virtualTextures) {
+        if (vt->dirtyX0 > vt->dirtyX1) continue;
+        glBindTexture(GL_TEXTURE_2D, vt->pageTexture);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, vt->pageWidth);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, vt->dirtyX0, vt->dirtyY0, vt->dirtyX1 - vt->dirtyX0 + 1,
+                        vt->dirtyY1 - vt->dirtyY0 + 1, GL_RGBA, GL_UNSIGNED_BYTE,
+                        &vt->pageTable[((size_t)vt->dirtyY0 * vt->pageWidth + vt->dirtyX0) * 4]);
+        vt->dirtyX0 = vt->pageWidth;
+        vt->dirtyY0 = vt->pageHeight;
+        vt->dirtyX1 = vt->dirtyY1 = -1;
+    }
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glActiveTexture(GL_TEXTURE0);
+}
+
+void updateVirtualTextures(bool complete) {
+    if (!program) return;
+    ++frameNumber;
+    counters.uploads = counters.evictions = 0;
+
+    // Each tile once; resident ones move to the recently used end
+    std::sort(requests.begin(), requests.end(), byKey);
+    size_t unique = 0;
+    for (size_t i = 0; i < requests.size(); ++i) {
+        if (unique > 0 && requests[unique - 1].key == requests[i].key)
+            requests[unique - 1].pixels = std::max(requests[unique - 1].pixels, requests[i].pixels);
+        else
+            requests[unique++] = requests[i];
+    }
+    requests.resize(unique);
+    counters.hits = 0;
+    for (const TileRequest& request : requests)
+        counters.hits += (int)residentTiles.count(request.key);
+    counters.wanted = (int)requests.size();
+    counters.misses = counters.wanted - counters.hits;
+
+    // More than the atlas holds: keep the most urgent, and let the rest show a coarser level
+    // rather than evicting each other every frame
+    const size_t capacity = slots.size() - pinnedSlots;
+    if (requests.size() > capacity) {
+        std::nth_element(requests.begin(), requests.begin() + capacity, requests.end(), moreUrgent);
+        requests.resize(capacity);
+        std::sort(requests.begin(), requests.end(), byKey);
+    }
+    for (const TileRequest& request : requests) {
+        auto it = residentTiles.find(request.key);
+        if (it != residentTiles.end()) touchSlot(it->second);
+    }
+    counters.totalHits += counters.hits;
+    counters.totalMisses += counters.misses;
+
+    for (;;) {
+        bool placed = uploadDecodedTiles(complete);
+        int missing = queueMissingTiles();
+        if (!complete || !placed || missing == 0) break;
+        std::unique_lock<std::mutex> guard(decodeLock);
+        decodeDone.wait(guard, [] { return !decodedTiles.empty(); });
+    }
+    flushPageTables();
+    requests.clear();
+}
+
+void beginVirtualTexture(int id) {
+    const VirtualTexture& vt = *virtualTextures[id];
+    const VtexHeader& h = *vt.header;
+    glUseProgram(program);
+    glActiveTexture(GL_TEXTURE0 + 2);
+    glBindTexture(GL_TEXTURE_2D, vt.pageTexture);
+    glActiveTexture(GL_TEXTURE0 + 1);
+    glBindTexture(GL_TEXTURE_2D, atlasTexture);
+    glActiveTexture(GL_TEXTURE0);  // Unit 0 stays as the render state tracker left it
+    glUniform4f(surfaceLocation, (float)h.width, (float)h.height, (float)h.tileSize, (float)(h.levels - 1));
+    glUniform4f(pagesLocation, (float)vt.pageWidth, (float)vt.pageHeight, (float)atlasSlots, (float)h.border);
+    glUniform1fv(columnsLocation, h.levels, vt.columns);
+}
+
+void endVirtualTexture() {
+    glUseProgram(0);
+}
+
+void getVirtualTextureStats(VirtualTextureStats& stats) {
+    stats = counters;
+    stats.resident = (int)residentTiles.size();
+    {
+        std::lock_guard<std::mutex> guard(decodeLock);
+        stats.queued = (int)inFlight.size() - (int)decodedTiles.size();
+    }
+    stats.bytesRead = bytesRead;
+}
+
+void shutdownVirtualTextures() {
+    {
+        std::lock_guard<std::mutex> guard(decodeLock);
+        decodersStopping = true;
+    }
+    decodeWork.notify_all();
+    for (std::thread& decoder : decoders) decoder.join();
+    decoders.clear();
+}
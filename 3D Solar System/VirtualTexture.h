@@ -0,0 +1,59 @@
+// Virtual textures: surface maps far larger than GPU memory, paged in tile by tile from a tiled
+// file as the camera needs them
+#pragma once
+
+#include "GLExtensions.h"     // GL types
+#include "Visibility.h"       // Frustum
+
+// Where a textured sphere is this frame and how it is turned
+struct SurfaceView {
+    double center[3];    // World position of the sphere's center
+    double axes[3][3];   // World directions of the sphere mesh's local x, y and z axes
+    double radius;
+};
+
+// Residency and streaming counters (the per-frame ones are for the last updateVirtualTextures())
+struct VirtualTextureStats {
+    int textures;          // Open virtual textures
+    int slots;             // Tile slots in the atlas: the GPU budget
+    int resident;          // Slots holding a tile
+    long long atlasBytes;  // GPU memory held by the atlas
+    int wanted;            // Tiles the current view asked for
+    int hits;              // ... that were already resident
+    int misses;            // ... that were not (drawn from a coarser tile meanwhile)
+    int queued;            // Tiles waiting for or being decoded
+    int uploads;           // Tiles uploaded this frame
+    int evictions;         // Tiles evicted this frame
+    long long totalHits, totalMisses;  // Since initVirtualTextures()
+    long long bytesRead;   // Tile data read from disk since initVirtualTextures()
+};
+
+// Cut an image into a tiled virtual texture file: every mip level in bordered square tiles.
+// Prints the reason and returns false on failure.
+bool buildVirtualTexture(const char* imagePath, const char* outputPath);
+
+// Create a tile atlas of at most budgetBytes, the sampling program and decoderThreads background
+// decoders. Needs the GL context with extensions loaded; false when shaders are unavailable.
+bool initVirtualTextures(long long budgetBytes, int decoderThreads);
+
+// Open a tiled file; its coarsest tile is loaded now and stays resident. Returns an id or -1.
+int openVirtualTexture(const char* path);
+
+// Ask for the tiles a sphere needs from the current view: those on its visible side and inside
+// the frustum, down to the mip level whose texels are about a pixel on screen
+void requestVirtualTexture(int id, const SurfaceView& view, const Frustum& frustum);
+
+// Once per frame after the requests: upload decoded tiles into least recently used slots, refresh
+// the page tables and queue the missing tiles for the decoders. With complete set, wait until
+// every requested tile is resident (or the budget is full), so the frame never depends on timing.
+void updateVirtualTextures(bool complete);
+
+// Draw with a virtual texture in place of the bound 2D texture. The program samples the atlas
+// and the page table on texture units 1 and 2, and lights like fixed function (light 0, color material).
+void beginVirtualTexture(int id);
+void endVirtualTexture();
+
+void getVirtualTextureStats(VirtualTextureStats& stats);
+
+// Stop the decoder threads (call before exit)
+void shutdownVirtualTextures();
@@ -0,0 +1,94 @@
+// View-frustum culling and screen-space level-of-detail selection
+#include "Visibility.h"
+#include <math.h>             // sqrt, tan
+#include <atomic>
+
+static const double VIS_PI = 3.141592653589793;
+
+// Sphere tessellation per level, and the smallest on-screen radius (pixels) for each
+const int lodSegments[LOD_LEVELS] = { 40, 24, 12, 6 };
+static const double lodMinPixels[LOD_LEVELS] = { 50.0, 15.0, 4.0, 1.5 };
+
+static void normalize(double v[3]) {
+    double len = sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+    if (len > 0.0) { v[0] /= len; v[1] /= len; v[2] /= len; }
+}
+
+static void cross(const double a[3], const double b[3], double out[3]) {
+    out[0] = a[1] * b[2] - a[2] * b[1];
+    out[1] = a[2] * b[0] - a[0] * b[2];
+    out[2] = a[0] * b[1] - a[1] * b[0];
+}
+
+// Store a plane through the eye with normal n (normalized here)
+static void setPlane(double plane[4], double nx, double ny, double nz, const double eye[3], double offset) {
+    double n[3] = { nx, ny, nz };
+    normalize(n);
+    plane[0] = n[0]; plane[1] = n[1]; plane[2] = n[2];
+    plane[3] = -(n[0] * eye[0] + n[1] * eye[1] + n[2] * eye[2]) + offset;
+}
+
+void buildFrustum(const ViewParams& view, Frustum& frustum) {
+    // Camera basis, as gluLookAt builds it
+    double f[3] = { view.target[0] - view.eye[0], view.target[1] - view.eye[1], view.target[2] - view.eye[2] };
+    normalize(f);
+    double r[3], u[3];
+    cross(f, view.up, r);
+    normalize(r);
+    cross(r, f, u);
+
+    double tanY = tan(view.fovY * VIS_PI / 360.0);
+    double tanX = tanY * view.aspect;
+    const double* e = view.eye;
+    setPlane(frustum.planes[0], f[0], f[1], f[2], e, -view.zNear);      // Near
+    setPlane(frustum.planes[1], -f[0], -f[1], -f[2], e, view.zFar);     // Far
+    setPlane(frustum.planes[2], f[0] * tanX + r[0], f[1] * tanX + r[1], f[2] * tanX + r[2], e, 0.0);  // Left
+    setPlane(frustum.planes[3], f[0] * tanX - r[0], f[1] * tanX - r[1], f[2] * tanX - r[2], e, 0.0);  // Right
+    setPlane(frustum.planes[4], f[0] * tanY + u[0], f[1] * tanY + u[1], f[2] * tanY + u[2], e, 0.0);  // Bottom
+    setPlane(frustum.planes[5], f[0] * tanY - u[0], f[1] * tanY - u[1], f[2] * tanY - u[2], e, 0.0);  // Top
+
+    frustum.eye[0] = e[0]; frustum.eye[1] = e[1]; frustum.eye[2] = e[2];
+    frustum.pixelsPerUnit = 0.5 * view.viewportHeight / tanY;
+}
+
+bool sphereInFrustum(const Frustum& frustum, double x, double y, double z, double radius) {
+    for (int p = 0; p < 6; ++p) {
+        const double* pl = frustum.planes[p];
+        if (pl[0] * x + pl[1] * y + pl[2] * z + pl[3] < -radius) return false;
+    }
+    return true;
+}
+
+double projectedRadius(const Frustum& frustum, double x, double y, double z, double radius) {
+    double dx = x - frustum.eye[0], dy = y - frustum.eye[1], dz = z - frustum.eye[2];
+    double dist = sqrt(dx * dx + dy * dy + dz * dz);
+    if (dist <= radius) return 1e9;  // Camera inside the body
+    return radius * frustum.pixelsPerUnit / dist;
+}
+
+int selectLod(double pixelRadius) {
+    for (int level = 0; level < LOD_LEVELS; ++level)
+        if (pixelRadius >= lodMinPixels[level]) return level;
+    return LOD_IMPOSTOR;
+}
+
+int classifyBodies(const Frustum& frustum, const float* x, const float* y, const float* z,
+                   const float* radius, int count, signed char* lodOut, float* pixelRadiusOut,
+                   TaskScheduler* scheduler) {
+    std::atomic<int> visible(0);
+    parallelFor(scheduler, 0, count, 8192, [&](int begin, int end) {
+        int local = 0;
+        for (int i = begin; i < end; ++i) {
+            if (!sphereInFrustum(frustum, x[i], y[i], z[i], radius[i])) {
+                lodOut[i] = LOD_CULLED;
+                continue;
+            }
+            double pixels = projectedRadius(frustum, x[i], y[i], z[i], radius[i]);
+            lodOut[i] = (signed char)selectLod(pixels);
+            if (pixelRadiusOut) pixelRadiusOut[i] = (float)pixels;
+            ++local;
+        }
+        visible += local;
+    });
+    return visible;
+}
@@ -0,0 +1,43 @@
+// View-frustum culling and screen-space level-of-detail selection
+#pragma once
+
+#include "TaskScheduler.h"    // Parallel classification of large body sets
+
+// Camera and projection the frustum is built from
+struct ViewParams {
+    double eye[3], target[3], up[3];  // Same arguments as gluLookAt
+    double fovY;                       // Vertical field of view in degrees
+    double aspect;                     // Width / height
+    double zNear, zFar;                // Clip distances
+    int viewportHeight;                // In pixels, for screen-space size
+};
+
+// Six inward-facing planes (nx, ny, nz, d) plus what LOD selection needs
+struct Frustum {
+    double planes[6][4];
+    double eye[3];
+    double pixelsPerUnit;  // Screen pixels covered by one unit at distance 1
+};
+
+// Level of detail chosen for a body
+static const int LOD_LEVELS = 4;             // Mesh levels, finest first
+static const int LOD_IMPOSTOR = LOD_LEVELS;  // Too small for a mesh: draw a point sprite
+static const int LOD_CULLED = -1;            // Outside the frustum
+extern const int lodSegments[LOD_LEVELS];    // Sphere tessellation for each mesh level
+
+void buildFrustum(const ViewParams& view, Frustum& frustum);
+
+// True when a sphere touches the frustum
+bool sphereInFrustum(const Frustum& frustum, double x, double y, double z, double radius);
+
+// Approximate on-screen radius of a sphere in pixels
+double projectedRadius(const Frustum& frustum, double x, double y, double z, double radius);
+
+// Mesh level (or impostor) for an on-screen radius in pixels
+int selectLod(double pixelRadius);
+
+// Cull and pick a level for every body; lodOut[i] is LOD_CULLED, a mesh level or LOD_IMPOSTOR.
+// Returns the number of bodies that survived culling.
+int classifyBodies(const Frustum& frustum, const float* x, const float* y, const float* z,
+                   const float* radius, int count, signed char* lodOut, float* pixelRadiusOut,
+                   TaskScheduler* scheduler);